@@ -0,0 +1,12 @@
+#ifndef BENCH_ALLOC_H
+#define BENCH_ALLOC_H
+
+#include <cstddef>
+
+// Totals of the counting global operator new in bench_alloc.cpp. It lives
+// in its own translation unit so the replaced new/delete pair is never
+// inlined into callers.
+size_t allocationCount();
+size_t allocatedBytes();
+
+#endif // BENCH_ALLOC_H
@@ -0,0 +1,102 @@
+#include "bench_generator.h"
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+
+namespace {
+
+const char* const REGIONS[] = {
+    "central", "north", "south", "volga", "ural", "siberia",
+    "east", "west", "caspian", "baltic", "arctic", "steppe"
+};
+// Cumulative weights, roughly Zipf over the regions above.
+const uint32_t REGION_WEIGHTS[] = { 30, 50, 64, 75, 83, 89, 93, 96, 98, 99, 100, 101 };
+const size_t REGION_COUNT = sizeof(REGIONS) / sizeof(REGIONS[0]);
+
+const char* const PIPE_KINDS[] = { "trunk", "branch", "loop", "feeder", "bypass" };
+const uint32_t PIPE_KIND_WEIGHTS[] = { 40, 70, 85, 95, 100 };
+
+const double DIAMETERS[] = { 530, 720, 820, 1020, 1220, 1420 };
+const uint32_t DIAMETER_WEIGHTS[] = { 10, 25, 35, 60, 80, 100 };
+
+const char* const CLASSES[] = { "main", "booster", "distribution", "storage", "border", "reserve" };
+const uint32_t CLASS_WEIGHTS[] = { 45, 70, 85, 93, 98, 100 };
+
+}
+
+NetworkGenerator::NetworkGenerator(uint64_t seed)
+    : state(seed), pipe_serial(0), station_serial(0) {
+}
+
+// splitmix64
+uint64_t NetworkGenerator::next() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint32_t NetworkGenerator::below(uint32_t bound) {
+    return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+}
+
+size_t NetworkGenerator::pick(const uint32_t* cumulative, size_t count) {
+    uint32_t roll = below(cumulative[count - 1]);
+    size_t i = 0;
+    while (cumulative[i] <= roll) ++i;
+    return i;
+}
+
+PipeSpec NetworkGenerator::nextPipe() {
+    const char* region = REGIONS[pick(REGION_WEIGHTS, REGION_COUNT)];
+    const char* kind = PIPE_KINDS[pick(PIPE_KIND_WEIGHTS, 5)];
+    char buffer[64];
+    int len = std::snprintf(buffer, sizeof(buffer), "%s_%s_%06llu", region, kind,
+        static_cast<unsigned long long>(++pipe_serial));
+    pipe_name.assign(buffer, static_cast<size_t>(len));
+
+    PipeSpec spec;
+    spec.name = pipe_name;
+    spec.diameter = DIAMETERS[pick(DIAMETER_WEIGHTS, 6)];
+    spec.in_repair = below(100) < 3;
+    return spec;
+}
+
+StationSpec NetworkGenerator::nextStation() {
+    const char* region = REGIONS[pick(REGION_WEIGHTS, REGION_COUNT)];
+    char buffer[64];
+    int len = std::snprintf(buffer, sizeof(buffer), "cs_%s_%llu", region,
+        static_cast<unsigned long long>(++station_serial));
+    station_name.assign(buffer, static_cast<size_t>(len));
+
+    StationSpec spec;
+    spec.name = station_name;
+    spec.total = 1 + static_cast<int>(below(32));
+    // Most stations run nearly full; one in five is heavily idle.
+    uint32_t idle = below(5) == 0 ? below(static_cast<uint32_t>(spec.total) + 1)
+        : below(static_cast<uint32_t>(spec.total) / 4 + 1);
+    spec.working = spec.total - static_cast<int>(idle);
+    spec.classification = CLASSES[pick(CLASS_WEIGHTS, 6)];
+    return spec;
+}
+
+void NetworkGenerator::populate(Manager& manager, size_t pipes, size_t stations) {
+    manager.addPipes(pipes, [&](size_t) { return nextPipe(); });
+    manager.addStations(stations, [&](size_t) { return nextStation(); });
+}
+
+void NetworkGenerator::connect(Manager& manager) {
+    std::vector<int> stations = manager.getStations().idColumn();
+    std::sort(stations.begin(), stations.end());
+    if (stations.size() < 2) return;
+    std::vector<int> pipes = manager.getPipes().idColumn();
+    uint32_t last = static_cast<uint32_t>(stations.size() - 1);
+    for (int pipe : pipes) {
+        uint32_t from = below(last);
+        uint32_t to = from + 1 + below(std::min<uint32_t>(16, last - from));
+        manager.connectPipe(pipe, stations[from], stations[to]);
+    }
+}
+
+const char* NetworkGenerator::region(size_t i) { return REGIONS[i % REGION_COUNT]; }
+size_t NetworkGenerator::regionCount() { return REGION_COUNT; }
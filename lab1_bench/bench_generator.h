@@ -0,0 +1,47 @@
+#ifndef BENCH_GENERATOR_H
+#define BENCH_GENERATOR_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "Manager.h"
+
+// Deterministic synthetic gas network. The same seed yields the same records
+// on every platform (own PRNG, no std distributions).
+//
+// Pipes: "<region>_<kind>_<segment>" with regions and kinds skewed towards a
+// few common values, diameters from the standard trunk sizes, ~3% in repair.
+// Stations: "cs_<region>_<n>", 1-32 workshops, mostly busy with a long idle
+// tail, and a handful of classifications with a skewed distribution.
+class NetworkGenerator {
+private:
+    uint64_t state;
+    uint64_t pipe_serial;
+    uint64_t station_serial;
+    std::string pipe_name;
+    std::string station_name;
+
+    uint64_t next();
+    // Uniform in [0, bound).
+    uint32_t below(uint32_t bound);
+    // Index drawn from the cumulative weight table.
+    size_t pick(const uint32_t* cumulative, size_t count);
+
+public:
+    explicit NetworkGenerator(uint64_t seed = 1);
+
+    // The returned views stay valid until the next call of the same function.
+    PipeSpec nextPipe();
+    StationSpec nextStation();
+
+    // Adds the records through Manager's bulk API.
+    void populate(Manager& manager, size_t pipes, size_t stations);
+    // Connects every pipe downstream: from a station to one of the next 16
+    // by id, so the network is acyclic.
+    void connect(Manager& manager);
+
+    static const char* region(size_t i);
+    static size_t regionCount();
+};
+
+#endif // BENCH_GENERATOR_H
@@ -0,0 +1,1508 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cctype>
+#include <set>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <climits>
+#include <filesystem>
+#include "Manager.h"
+#include "bench_generator.h"
+#include "bench_alloc.h"
+#include "ConcurrentManager.h"
+#include "FilterKernels.h"
+#include "FlowSolver.h"
+#include "RecordPrinter.h"
+#include "SocketServer.h"
+#include "SlotMap.h"
+#include "Snapshot.h"
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+using namespace std;
+
+template <typename Func>
+double timeMs(Func func, int repeats) {
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) func();
+    auto stop = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(stop - start).count() / repeats;
+}
+
+// Repair-flag and idle-percent scans: columnar Manager vs. the old map layout.
+void benchScans(size_t n) {
+    Manager manager;
+    unordered_map<int, Pipe> pipeMap;
+    unordered_map<int, CompressorStation> stationMap;
+
+    for (size_t i = 0; i < n; ++i) {
+        string name = "pipe_" + to_string(i);
+        bool repair = i % 7 == 0;
+        int id = manager.addPipe(name, 100 + i % 1400, repair);
+        pipeMap.emplace(id, Pipe(id, name, 100 + i % 1400, repair));
+
+        int total = 1 + i % 20;
+        int working = i % (total + 1);
+        id = manager.addStation("station_" + to_string(i), total, working, "class" + to_string(i % 4));
+        stationMap.emplace(id, CompressorStation(id, "station_" + to_string(i), total, working, "class" + to_string(i % 4)));
+    }
+
+    size_t sink = 0;
+    int repeats = n >= 1000000 ? 3 : 20;
+
+    double mapRepair = timeMs([&]() {
+        vector<Pipe> result;
+        for (const auto& pair : pipeMap)
+            if (pair.second.isInRepair()) result.push_back(pair.second);
+        sink += result.size();
+    }, repeats);
+    double tableRepair = timeMs([&]() { sink += manager.findPipesByRepairFlag(true).size(); }, repeats);
+
+    double mapIdle = timeMs([&]() {
+        vector<CompressorStation> result;
+        for (const auto& pair : stationMap)
+            if (pair.second.percentIdle() >= 50.0) result.push_back(pair.second);
+        sink += result.size();
+    }, repeats);
+    double tableIdle = timeMs([&]() { sink += manager.findStationsByIdlePercent(50.0).size(); }, repeats);
+
+    cout << "records=" << n << "\n";
+    cout << "  repair scan: map " << mapRepair << " ms, columnar " << tableRepair
+        << " ms, speedup x" << mapRepair / tableRepair << "\n";
+    cout << "  idle scan:   map " << mapIdle << " ms, columnar " << tableIdle
+        << " ms, speedup x" << mapIdle / tableIdle << "\n";
+    cerr << sink << endl;
+}
+
+// Text format ingest in MB/s: parallel from_chars loader vs. the line-by-line one.
+void benchTextLoad(size_t n) {
+    const string filename = "bench_textload.txt";
+    {
+        Manager manager;
+        for (size_t i = 0; i < n; ++i) {
+            manager.addPipe("pipe_" + to_string(i), 100 + i % 1400, i % 7 == 0);
+            manager.addStation("station_" + to_string(i), 1 + i % 20, i % 10, "class" + to_string(i % 4));
+        }
+        manager.saveToFile(filename);
+    }
+
+    double mb;
+    {
+        ifstream is(filename, ios::binary | ios::ate);
+        mb = static_cast<double>(is.tellg()) / (1024.0 * 1024.0);
+    }
+
+    int repeats = n >= 1000000 ? 1 : 5;
+    Manager serial, parallel;
+    double serialMs = timeMs([&]() { serial.loadFromFileSerial(filename); }, repeats);
+    double parallelMs = timeMs([&]() { parallel.loadFromFile(filename); }, repeats);
+
+    cout << "records=" << 2 * n << " file=" << mb << " MB\n";
+    cout << "  serial loader:   " << mb / (serialMs / 1000.0) << " MB/s\n";
+    cout << "  parallel loader: " << mb / (parallelMs / 1000.0) << " MB/s\n";
+    if (serial.getPipeCount() != parallel.getPipeCount() || serial.getStationCount() != parallel.getStationCount())
+        cout << "  MISMATCH in loaded record counts\n";
+    remove(filename.c_str());
+}
+
+// Substring search on names: trigram index vs. a linear find over every name.
+void benchNameSearch(size_t n) {
+    const char* regions[] = { "north", "south", "east", "west", "central" };
+    Manager manager;
+    vector<string> names;
+    names.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        names.push_back(string(regions[i % 5]) + "_line_" + to_string(i));
+        manager.addPipe(names.back(), 100 + i % 1400, false);
+    }
+
+    const vector<string> queries = { "north_line_12", "line_99999", "st_line_4242" };
+    size_t sink = 0;
+    for (const string& q : queries) {
+        size_t linearCount = 0, indexCount = 0;
+        double linear = timeMs([&]() {
+            linearCount = 0;
+            for (const string& name : names)
+                if (name.find(q) != string::npos) ++linearCount;
+        }, 5);
+        double indexed = timeMs([&]() { indexCount = manager.findPipesByName(q).size(); }, 5);
+        cout << "records=" << n << " query=\"" << q << "\" matches=" << indexCount
+            << " linear " << linear << " ms, trigram " << indexed << " ms"
+            << (linearCount == indexCount ? "" : " MISMATCH") << "\n";
+        sink += indexCount;
+    }
+    cerr << sink << endl;
+}
+
+template <typename Func>
+size_t countAllocations(Func func) {
+    size_t before = allocationCount();
+    func();
+    return allocationCount() - before;
+}
+
+// Allocations per query: object copies + std::set<int> vs. id lists.
+void benchAllocations(size_t n) {
+    Manager manager;
+    for (size_t i = 0; i < n; ++i) {
+        manager.addPipe("pipe_with_a_long_enough_name_" + to_string(i), 100 + i % 1400, i % 3 == 0);
+        manager.addStation("station_with_a_long_enough_name_" + to_string(i), 10, i % 11, "class");
+    }
+
+    size_t oldRepair = countAllocations([&]() {
+        set<int> ids;
+        for (const Pipe& p : manager.findPipesByRepairFlag(true)) ids.insert(p.getId());
+        vector<int> idVector(ids.begin(), ids.end());
+        manager.batchEditPipes(idVector, 1);
+    });
+    size_t newRepair = countAllocations([&]() {
+        manager.batchEditPipes(manager.findPipeIdsByRepairFlag(true), 1);
+    });
+    size_t oldName = countAllocations([&]() {
+        set<int> ids;
+        for (const Pipe& p : manager.findPipesByName("name_12")) ids.insert(p.getId());
+    });
+    size_t newName = countAllocations([&]() { manager.findPipeIdsByName("name_12"); });
+    size_t oldIdle = countAllocations([&]() {
+        set<int> ids;
+        for (const CompressorStation& s : manager.findStationsByIdlePercent(50.0)) ids.insert(s.getId());
+    });
+    size_t newIdle = countAllocations([&]() { manager.findStationIdsByIdlePercent(50.0); });
+
+    Manager single, bulk;
+    char name[64];
+    size_t oneByOne = countAllocations([&]() {
+        for (size_t i = 0; i < n; ++i) {
+            snprintf(name, sizeof(name), "imported_pipe_%zu", i);
+            single.addPipe(name, 500, false);
+        }
+    });
+    size_t bulkAdd = countAllocations([&]() {
+        bulk.addPipes(n, [&](size_t i) {
+            int len = snprintf(name, sizeof(name), "imported_pipe_%zu", i);
+            return PipeSpec{ string_view(name, len), 500, false };
+        });
+    });
+    cout << "records=" << n << " import allocations per record: addPipe "
+        << static_cast<double>(oneByOne) / n << ", addPipes " << static_cast<double>(bulkAdd) / n << "\n";
+
+    cout << "records=" << n << " allocations per query (objects+set -> id list)\n";
+    cout << "  repair batch:  " << oldRepair << " -> " << newRepair << "\n";
+    cout << "  name search:   " << oldName << " -> " << newName << "\n";
+    cout << "  idle search:   " << oldIdle << " -> " << newIdle << "\n";
+}
+
+// Runs func(call) 'calls' times and prints one CSV row. 'items' is the number
+// of records one call touches, so items_per_s is comparable across sizes.
+template <typename Func>
+void measure(const char* op, size_t records, size_t calls, size_t items, Func func) {
+    size_t allocs = allocationCount();
+    size_t bytes = allocatedBytes();
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) func(i);
+    auto stop = chrono::steady_clock::now();
+    allocs = allocationCount() - allocs;
+    bytes = allocatedBytes() - bytes;
+
+    double ns = chrono::duration<double, nano>(stop - start).count();
+    double perCall = ns / calls;
+    printf("%s,%zu,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%.2f\n", op, records, calls, items,
+        perCall, 1e9 / perCall, items * 1e9 / perCall,
+        static_cast<double>(bytes) / calls, static_cast<double>(allocs) / calls);
+    fflush(stdout);
+}
+
+// Manager hot paths on a synthetic network of n pipes and n stations.
+// Output is CSV, one row per operation (header printed once by main).
+void benchSuite(size_t n) {
+    const string filename = "bench_suite.txt";
+    size_t repeats = n >= 1000000 ? 3 : 50;
+    size_t sink = 0;
+
+    Manager manager;
+    NetworkGenerator generator(42);
+    string name;
+    measure("addPipe", n, n, 1, [&](size_t) {
+        PipeSpec spec = generator.nextPipe();
+        name.assign(spec.name);
+        manager.addPipe(name, spec.diameter, spec.in_repair);
+    });
+    generator.populate(manager, 0, n);
+
+    const char* queries[] = { "volga_loop", "arctic", "_000042" };
+    measure("findPipesByName", n, repeats * 3, n, [&](size_t i) {
+        sink += manager.findPipesByName(queries[i % 3]).size();
+    });
+    measure("findPipesByRepairFlag", n, repeats, n, [&](size_t) {
+        sink += manager.findPipesByRepairFlag(true).size();
+    });
+    measure("findStationsByIdlePercent", n, repeats, n, [&](size_t) {
+        sink += manager.findStationsByIdlePercent(50.0).size();
+    });
+
+    vector<int> pipeIds, stationIds;
+    for (size_t row = 0; row < manager.getPipeCount(); row += 16) pipeIds.push_back(manager.getPipes().idColumn()[row]);
+    for (size_t row = 0; row < manager.getStationCount(); row += 16) stationIds.push_back(manager.getStations().idColumn()[row]);
+    measure("batchEditPipes", n, repeats, pipeIds.size(), [&](size_t i) {
+        manager.batchEditPipes(pipeIds, static_cast<int>(i % 2));
+    });
+    measure("batchEditStations", n, repeats, stationIds.size(), [&](size_t i) {
+        manager.batchEditStations(stationIds, i % 2 == 0 ? -1 : 1);
+    });
+
+    size_t fileRepeats = n >= 1000000 ? 1 : 5;
+    measure("saveToFile", n, fileRepeats, 2 * n, [&](size_t) { manager.saveToFile(filename); });
+    Manager loaded;
+    measure("loadFromFile", n, fileRepeats, 2 * n, [&](size_t) { loaded.loadFromFile(filename); });
+    if (loaded.getPipeCount() != n || loaded.getStationCount() != n)
+        fprintf(stderr, "suite: loaded %zu pipes, %zu stations, expected %zu\n",
+            loaded.getPipeCount(), loaded.getStationCount(), n);
+    remove(filename.c_str());
+    cerr << sink << endl;
+}
+
+// Readers and writers hammer a ConcurrentManager for a few seconds while the
+// readers check every result; afterwards the final state is compared with
+// what the writers last wrote. Returns false on any violation.
+bool benchStress(size_t n) {
+    const size_t writers = 2, readers = max<size_t>(2, thread::hardware_concurrency());
+    const auto duration = chrono::seconds(2);
+
+    Manager source;
+    NetworkGenerator(7).populate(source, n, n);
+    ConcurrentManager cm(8);
+    cm.importFrom(source);
+    const int maxPipe = static_cast<int>(n), maxStation = static_cast<int>(n);
+
+    atomic<bool> stop(false);
+    atomic<size_t> failures(0), queries(0), edits(0);
+    auto fail = [&](const char* what, int id) {
+        if (failures.fetch_add(1) < 10) fprintf(stderr, "stress: %s (id %d)\n", what, id);
+    };
+    auto sortedUnique = [](const IdList& ids) {
+        for (size_t i = 1; i < ids.size(); ++i) if (ids[i - 1] >= ids[i]) return false;
+        return true;
+    };
+
+    // Writer w owns the pipes and stations with id % writers == w and
+    // remembers the repair flag it set last.
+    vector<vector<uint8_t>> lastFlag(writers, vector<uint8_t>(n + 1, 2));
+    vector<thread> threads;
+    for (size_t w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w]() {
+            uint64_t seed = 0x9E3779B97F4A7C15ULL * (w + 1);
+            vector<int> batch;
+            for (size_t round = 0; !stop.load(); ++round) {
+                batch.clear();
+                seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+                int start = 1 + static_cast<int>(seed % static_cast<uint64_t>(maxPipe));
+                for (int id = start; id <= maxPipe && batch.size() < 512; ++id)
+                    if (static_cast<size_t>(id) % writers == w) batch.push_back(id);
+                int flag = static_cast<int>(round % 2);
+                cm.batchEditPipes(batch, flag);
+                for (int id : batch) lastFlag[w][id] = static_cast<uint8_t>(flag);
+                cm.batchEditStations(batch, flag == 1 ? 1 : -1);
+                edits.fetch_add(1);
+            }
+        });
+    }
+    // Churn: extra pipes are added and removed; they must read back intact.
+    threads.emplace_back([&]() {
+        for (size_t i = 0; !stop.load(); ++i) {
+            string name = "churn_" + to_string(i);
+            int id = cm.addPipe(name, 720, false);
+            if (cm.getPipeById(id).value_or(Pipe()).getName() != name) fail("churn pipe reads back wrong", id);
+            if (!cm.removePipeById(id)) fail("churn pipe vanished", id);
+        }
+    });
+    for (size_t r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r]() {
+            const char* region = NetworkGenerator::region(r);
+            while (!stop.load()) {
+                IdList ids = cm.findPipeIdsByRepairFlag(true);
+                if (!sortedUnique(ids)) fail("repair ids not sorted", 0);
+                ids = cm.findPipeIdsByName(region);
+                if (!sortedUnique(ids)) fail("name ids not sorted", 0);
+                for (size_t i = 0; i < ids.size(); i += 97) {
+                    if (cm.getPipeById(ids[i]).value_or(Pipe()).getName().find(region) == string::npos) fail("name mismatch", ids[i]);
+                }
+                ids = cm.findStationIdsByIdlePercent(50.0);
+                if (!sortedUnique(ids)) fail("idle ids not sorted", 0);
+                for (size_t i = 0; i < ids.size(); i += 97) {
+                    CompressorStation s = cm.getStationById(ids[i]).value_or(CompressorStation());
+                    if (s.getId() != ids[i] || s.getWorkingWorkshops() < 0 || s.getWorkingWorkshops() > s.getTotalWorkshops())
+                        fail("station out of range", ids[i]);
+                }
+                queries.fetch_add(3);
+            }
+        });
+    }
+
+    this_thread::sleep_for(duration);
+    stop.store(true);
+    for (thread& t : threads) t.join();
+
+    for (int id = 1; id <= maxPipe; ++id) {
+        uint8_t flag = lastFlag[static_cast<size_t>(id) % writers][id];
+        Pipe p = cm.getPipeById(id).value_or(Pipe());
+        if (p.getId() != id) fail("pipe lost", id);
+        else if (flag != 2 && p.isInRepair() != (flag == 1)) fail("final repair flag differs", id);
+    }
+    if (cm.getPipeCount() != n || cm.getStationCount() != static_cast<size_t>(maxStation)) fail("record count changed", 0);
+
+    cout << "stress records=" << n << " readers=" << readers << " writers=" << writers
+        << " queries=" << queries.load() << " batches=" << edits.load()
+        << (failures.load() == 0 ? " OK" : " FAILED") << "\n";
+    return failures.load() == 0;
+}
+
+// Query throughput with 1..N reader threads, alone and next to one writer
+// doing batch edits. CSV: threads,writer,queries,queries_per_s,speedup.
+void benchScaling(size_t n) {
+    Manager source;
+    NetworkGenerator(11).populate(source, n, n);
+    ConcurrentManager cm;
+    cm.importFrom(source);
+    const auto duration = chrono::milliseconds(1000);
+
+    vector<int> editIds;
+    for (int id = 1; id <= static_cast<int>(n); id += 64) editIds.push_back(id);
+
+    vector<size_t> counts;
+    size_t maxThreads = max(1u, thread::hardware_concurrency());
+    for (size_t t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    atomic<size_t> sink(0);
+    printf("threads,writer,records,queries,queries_per_s,speedup\n");
+    for (int withWriter = 0; withWriter <= 1; ++withWriter) {
+        double base = 0;
+        for (size_t t : counts) {
+            atomic<bool> stop(false);
+            atomic<size_t> queries(0);
+            vector<thread> threads;
+            if (withWriter) {
+                threads.emplace_back([&]() {
+                    for (int flag = 0; !stop.load(); flag ^= 1) cm.batchEditPipes(editIds, flag);
+                });
+            }
+            auto start = chrono::steady_clock::now();
+            for (size_t i = 0; i < t; ++i) {
+                threads.emplace_back([&, i]() {
+                    size_t local = 0;
+                    const char* region = NetworkGenerator::region(i);
+                    while (!stop.load()) {
+                        local += cm.findPipeIdsByName(region).empty() ? 0 : 1;
+                        local += cm.findStationIdsByIdlePercent(50.0).empty() ? 0 : 1;
+                        queries.fetch_add(2);
+                    }
+                    sink.fetch_add(local);
+                });
+            }
+            this_thread::sleep_for(duration);
+            stop.store(true);
+            for (thread& th : threads) th.join();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            double qps = queries.load() / seconds;
+            if (t == 1) base = qps;
+            printf("%zu,%d,%zu,%zu,%.1f,%.2f\n", t, withWriter, n, queries.load(), qps, qps / base);
+            fflush(stdout);
+        }
+    }
+    cerr << sink.load() << endl;
+}
+
+// "in repair AND diameter > 1000 AND name contains volga": separate
+// queries intersected vs. one fused pass (runtime expression, templates).
+void benchQuery(size_t n) {
+    Manager manager;
+    NetworkGenerator(3).populate(manager, n, 0);
+    int repeats = n >= 1000000 ? 5 : 50;
+    IdList separate, parsed, compiled;
+
+    double separateMs = timeMs([&]() {
+        IdList repair = manager.findPipeIdsByRepairFlag(true);
+        IdList named = manager.findPipeIdsByName("volga");
+        IdList both;
+        set_intersection(repair.begin(), repair.end(), named.begin(), named.end(), back_inserter(both));
+        separate.clear();
+        for (int id : both) if (manager.getPipeById(id).value_or(Pipe()).getDiameter() > 1000) separate.push_back(id);
+    }, repeats);
+
+    QueryExpr expr;
+    expr.parse("in repair AND diameter > 1000 AND name contains volga", QueryTarget::Pipes);
+    double parsedMs = timeMs([&]() { parsed = manager.findPipeIds(expr); }, repeats);
+
+    QueryExpr noIndex;
+    noIndex.parse("in repair AND diameter > 1000 AND (name contains volga OR name contains volga)", QueryTarget::Pipes);
+    IdList scanned;
+    double scannedMs = timeMs([&]() { scanned = manager.findPipeIds(noIndex); }, repeats);
+
+    auto pred = query::inRepair() && query::diameter(query::GT, 1000) && query::nameContains("volga");
+    double compiledMs = timeMs([&]() { compiled = manager.findPipeIdsWhere(pred); }, repeats);
+
+    bool same = separate == parsed && parsed == compiled && compiled == scanned;
+    cout << "records=" << n << " matches=" << parsed.size() << (same ? "" : " MISMATCH") << "\n";
+    cout << "  separate queries + intersect: " << separateMs << " ms\n";
+    cout << "  parsed expression (index):    " << parsedMs << " ms\n";
+    cout << "  parsed expression (full scan): " << scannedMs << " ms\n";
+    cout << "  compiled predicate:           " << compiledMs << " ms\n";
+}
+
+// Column kernels in GB/s for every instruction set the CPU has; each bitmap
+// must equal the per-row predicate.
+bool benchFilter(size_t n) {
+    Manager manager;
+    NetworkGenerator(5).populate(manager, n, n);
+    const PipeTable& pipes = manager.getPipes();
+    const StationTable& stations = manager.getStations();
+    size_t words = filter::wordCount(n);
+    int repeats = n >= 1000000 ? 20 : 500;
+
+    filter::Bitmap expectRepair(words), expectDiameter(words), expectIdle(words);
+    query::RepairIs repairPred(true);
+    query::DiameterIs diameterPred(query::GE, 700);
+    query::IdleIs idlePred(query::GT, 12.5);
+    for (size_t row = 0; row < n; ++row) {
+        expectRepair[row / 64] |= static_cast<uint64_t>(repairPred(pipes, row)) << (row % 64);
+        expectDiameter[row / 64] |= static_cast<uint64_t>(diameterPred(pipes, row)) << (row % 64);
+        expectIdle[row / 64] |= static_cast<uint64_t>(idlePred(stations, row)) << (row % 64);
+    }
+
+    bool ok = true;
+    filter::Bitmap bits(words);
+    const filter::Isa detected = filter::activeIsa();
+    cout << "records=" << n << " (GB/s of column data)\n";
+    for (filter::Isa isa : { filter::Isa::Scalar, filter::Isa::SSE2, filter::Isa::AVX2 }) {
+        if (filter::setIsa(isa) != isa) continue;
+        double repairMs = timeMs([&]() { filter::repairEquals(pipes.repairColumn().data(), n, true, bits.data()); }, repeats);
+        bool same = bits == expectRepair;
+        double diameterMs = timeMs([&]() {
+            filter::compareDoubles(pipes.diameterColumn().data(), n, query::GE, 700, bits.data());
+        }, repeats);
+        same = same && bits == expectDiameter;
+        double idleMs = timeMs([&]() {
+            filter::compareIdle(stations.totalColumn().data(), stations.workingColumn().data(), n, query::GT, 12.5, bits.data());
+        }, repeats);
+        same = same && bits == expectIdle;
+        ok = ok && same;
+
+        auto gbs = [&](size_t bytes, double ms) { return bytes / ms / 1e6; };
+        cout << "  " << filter::isaName(isa) << ": repair " << gbs(n, repairMs)
+            << ", diameter " << gbs(n * sizeof(double), diameterMs)
+            << ", idle " << gbs(n * 2 * sizeof(int32_t), idleMs) << (same ? "" : " MISMATCH") << "\n";
+    }
+    filter::setIsa(detected);
+    return ok;
+}
+
+// n stations, 2n pipes: incremental connects, then the graph queries on the
+// CSR + overlay, each checked against a network built in one pass.
+bool benchNetwork(size_t n) {
+    Manager manager;
+    NetworkGenerator gen(9);
+    gen.populate(manager, 2 * n, n);
+    double connectMs = timeMs([&]() { gen.connect(manager); }, 1);
+
+    // Churn: rewire every 10th pipe, drop every 50th station.
+    const vector<int> pipeIds = manager.getPipes().idColumn();
+    const vector<int> stationIds = manager.getStations().idColumn();
+    double rewireMs = timeMs([&]() {
+        for (size_t i = 0; i < pipeIds.size(); i += 10) {
+            if (i % 20 == 0) manager.disconnectPipe(pipeIds[i]);
+            else manager.connectPipe(pipeIds[i], stationIds[i % n], stationIds[(i + 1) % n]);
+        }
+    }, 1);
+    double removeMs = timeMs([&]() {
+        for (size_t i = 0; i < stationIds.size(); i += 50) manager.removeStationById(stationIds[i]);
+    }, 1);
+
+    const PipeTable& pipes = manager.getPipes();
+    Network reference;
+    reference.assign(manager.getStations().idColumn(), pipes.idColumn(), pipes.inColumn(), pipes.outColumn());
+    const Network& live = manager.getNetwork();
+
+    int start = stationIds[1];
+    IdList reach, order, expectOrder;
+    vector<IdList> groups;
+    double reachMs = timeMs([&]() { reach = manager.findReachableStationIds(start); }, 3);
+    bool acyclic = false;
+    double topoMs = timeMs([&]() { acyclic = manager.findStationTopologicalOrder(order); }, 3);
+    double groupsMs = timeMs([&]() { groups = manager.findConnectedStationGroups(); }, 3);
+    bool expectAcyclic = reference.topologicalOrder(expectOrder);
+
+    // Topological orders may legitimately differ; check the arcs instead.
+    bool orderOk = acyclic == expectAcyclic;
+    if (acyclic) {
+        unordered_map<int, size_t> position;
+        for (size_t i = 0; i < order.size(); ++i) position[order[i]] = i;
+        orderOk = order.size() == manager.getStationCount();
+        for (size_t row = 0; orderOk && row < pipes.size(); ++row) {
+            if (pipes.inColumn()[row] != 0) orderOk = position[pipes.inColumn()[row]] < position[pipes.outColumn()[row]];
+        }
+    }
+    bool same = reach == reference.reachableFrom(start) && groups == reference.components() && orderOk
+        && live.arcCount() == reference.arcCount();
+
+    cout << "records=" << n << " stations, " << live.arcCount() << " connected pipes" << (same ? "" : " MISMATCH") << "\n";
+    cout << "  connect all: " << connectMs << " ms, rewire 10%: " << rewireMs
+        << " ms, remove 2% of stations: " << removeMs << " ms\n";
+    cout << "  reachable (" << reach.size() << "): " << reachMs << " ms\n";
+    cout << "  topological order" << (acyclic ? "" : " (cycle)") << ": " << topoMs << " ms\n";
+    cout << "  components (" << groups.size() << "): " << groupsMs << " ms\n";
+    return same;
+}
+
+// n stations, 2n pipes: max flow between two far-apart stations with one
+// thread and with all of them, then repair flips through batchEditPipes
+// re-solved incrementally and checked against a solve from scratch.
+bool benchFlow(size_t n) {
+    Manager manager;
+    NetworkGenerator gen(11);
+    gen.populate(manager, 2 * n, n);
+    gen.connect(manager);
+    const vector<int> pipeIds = manager.getPipes().idColumn();
+    const Network& network = manager.getNetwork();
+    const PipeTable& table = manager.getPipes();
+
+    // CSR of the arcs that can carry flow: connected pipes out of repair.
+    vector<uint32_t> offsets(network.nodeCount() + 1, 0), heads;
+    auto carries = [&](int pipe) {
+        ptrdiff_t row = table.rowOf(pipe);
+        return row >= 0 && !table.repairColumn()[row] && FlowSolver::capacityFor(table.diameterColumn()[row]) > 0;
+    };
+    network.forEachPipe([&](uint32_t a, uint32_t, int pipe) { offsets[a + 1] += carries(pipe); });
+    for (size_t i = 1; i < offsets.size(); ++i) offsets[i] += offsets[i - 1];
+    heads.resize(offsets.back());
+    vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    network.forEachPipe([&](uint32_t a, uint32_t b, int pipe) { if (carries(pipe)) heads[fill[a]++] = b; });
+
+    // Source: the first station with somewhere to send flow; sink: the last
+    // station its breadth-first walk reaches, so the two are far apart.
+    int from = 0, to = 0;
+    vector<uint8_t> seen(network.nodeCount());
+    vector<uint32_t> order;
+    for (uint32_t src = 0; src < network.nodeCount() && to == 0; ++src) {
+        if (network.stationAt(src) == 0 || offsets[src] == offsets[src + 1]) continue;
+        fill_n(seen.begin(), seen.size(), 0);
+        order.assign(1, src);
+        seen[src] = 1;
+        for (size_t i = 0; i < order.size(); ++i) {
+            for (uint32_t k = offsets[order[i]]; k < offsets[order[i] + 1]; ++k) {
+                if (!seen[heads[k]]) {
+                    seen[heads[k]] = 1;
+                    order.push_back(heads[k]);
+                }
+            }
+        }
+        if (order.size() > 1) {
+            from = network.stationAt(src);
+            to = network.stationAt(order.back());
+        }
+    }
+    if (to == 0) {
+        cout << "records=" << n << " stations: no pipe can carry flow MISMATCH\n";
+        return false;
+    }
+    uint32_t s = static_cast<uint32_t>(network.nodeOf(from)), t = static_cast<uint32_t>(network.nodeOf(to));
+
+    auto solveFresh = [&](size_t threads) {
+        FlowSolver solver;
+        solver.setThreads(threads);
+        solver.build(network, manager.getPipes());
+        return solver.solve(s, t);
+    };
+    int64_t single = 0, multi = 0;
+    size_t threads = max(2u, thread::hardware_concurrency());
+    double singleMs = timeMs([&]() { single = solveFresh(1); }, 1);
+    double multiMs = timeMs([&]() { multi = solveFresh(threads); }, 1);
+
+    IdList cut;
+    double coldMs = timeMs([&]() { manager.findMaxFlow(from, to, &cut); }, 1);
+    // Half of the bottleneck plus a few hundred random pipes go to repair.
+    vector<int> flips;
+    for (size_t i = 0; i < cut.size(); i += 2) flips.push_back(cut[i]);
+    for (size_t i = 0; i < 256; ++i) flips.push_back(pipeIds[(i * 7919) % pipeIds.size()]);
+    sort(flips.begin(), flips.end());
+    flips.erase(unique(flips.begin(), flips.end()), flips.end());
+
+    bool ok = single > 0 && single == multi;
+    int64_t value = 0;
+    double repairMs = 0, restoreMs = 0, freshMs = 0;
+    for (int flag : { 1, 0 }) {
+        manager.batchEditPipes(flips, flag);
+        double ms = timeMs([&]() { value = manager.findMaxFlow(from, to); }, 1);
+        (flag ? repairMs : restoreMs) = ms;
+        int64_t expect = 0;
+        freshMs = timeMs([&]() { expect = solveFresh(1); }, 1);
+        ok = ok && value == expect;
+    }
+    ok = ok && value == single;
+
+    cout << "records=" << n << " stations, flow " << single << ", cut " << cut.size() << " pipes"
+        << (ok ? "" : " MISMATCH") << "\n";
+    cout << "  solve: 1 thread " << singleMs << " ms, " << threads << " threads " << multiMs
+        << " ms, via Manager " << coldMs << " ms\n";
+    cout << "  " << flips.size() << " repair flips: incremental " << repairMs << " ms, back " << restoreMs
+        << " ms, full re-solve " << freshMs << " ms\n";
+    return ok;
+}
+
+// Idle-ratio index against a brute-force scan of the station columns after
+// churn, including the extreme workshop counts a loaded file may carry.
+bool benchIdle(size_t n) {
+    Manager manager;
+    NetworkGenerator(37).populate(manager, 0, n);
+    const int extremes[] = { INT_MIN, -1000000000, -1, 0, 1, 1000000000, INT_MAX };
+    const size_t extremeCount = sizeof(extremes) / sizeof(extremes[0]);
+    for (int total : extremes) {
+        for (int working : extremes) manager.addStation("edge", total, working, "edge");
+    }
+    const IdList ids = manager.getStations().idColumn();
+    uint64_t state = 37;
+    auto below = [&](size_t bound) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<size_t>((state >> 33) % bound);
+    };
+    for (size_t i = 0; i < n / 2 + 64; ++i) {
+        int id = ids[below(ids.size())];
+        switch (below(4)) {
+        case 0: manager.setStationWorking(id, extremes[below(extremeCount)]); break;
+        case 1: manager.setStationWorking(id, static_cast<int>(below(40))); break;
+        case 2: manager.batchEditStations({ id }, below(2) ? 1 : -1); break;
+        default: manager.removeStationById(id); break;
+        }
+    }
+
+    struct Ratio {
+        int64_t idle;
+        int64_t total;
+        int id;
+    };
+    const StationTable& table = manager.getStations();
+    vector<Ratio> all;
+    for (size_t row = 0; row < table.size(); ++row) {
+        int64_t total = table.totalColumn()[row];
+        if (total <= 0) all.push_back(Ratio{ 0, 1, table.idColumn()[row] });
+        else all.push_back(Ratio{ total - table.workingColumn()[row], total, table.idColumn()[row] });
+    }
+
+    bool ok = true;
+    const pair<double, double> bounds[] = { { 0, 100 }, { 12.5, 50 }, { 50, 50 }, { -1e12, 0 }, { 100, 1e12 },
+        { 33.3, 66.7 }, { 60, 40 }, { -1e12, 1e12 } };
+    for (const auto& b : bounds) {
+        IdList expect;
+        for (const Ratio& r : all) {
+            if (100.0 * r.idle >= b.first * r.total && 100.0 * r.idle <= b.second * r.total) expect.push_back(r.id);
+        }
+        sort(expect.begin(), expect.end());
+        ok = ok && manager.findStationIdsByIdleRange(b.first, b.second) == expect;
+    }
+    // Most idle first, ties by the larger id.
+    sort(all.begin(), all.end(), [](const Ratio& a, const Ratio& b) {
+        int64_t l = a.idle * b.total, r = b.idle * a.total;
+        return l != r ? l > r : a.id > b.id;
+    });
+    for (size_t k : { size_t(0), size_t(1), size_t(10), all.size() / 2, all.size() + 10 }) {
+        IdList expect;
+        for (size_t i = 0; i < min(k, all.size()); ++i) expect.push_back(all[i].id);
+        ok = ok && manager.findMostIdleStationIds(k) == expect;
+    }
+    cout << "records=" << all.size() << " stations, idle range and top-k against a scan" << (ok ? "" : " MISMATCH") << "\n";
+    return ok;
+}
+
+// n pipes and n stations under random churn through the public mutators;
+// the maintained statistics must equal a set rebuilt by a full scan.
+bool benchStats(size_t n) {
+    Manager manager;
+    NetworkGenerator gen(13);
+    gen.populate(manager, n, n);
+    vector<int> pipeIds = manager.getPipes().idColumn();
+    vector<int> stationIds = manager.getStations().idColumn();
+
+    size_t ops = max<size_t>(n / 10, 1000);
+    double churnMs = timeMs([&]() {
+        for (size_t i = 0; i < ops; ++i) {
+            size_t pick = (i * 2654435761u) % pipeIds.size();
+            switch (i % 6) {
+            case 0: manager.setPipeInRepair(pipeIds[pick], i % 4 == 0); break;
+            case 1: manager.batchEditPipes({ pipeIds[pick], pipeIds[(pick + 1) % pipeIds.size()] }, i % 4 == 1); break;
+            case 2: manager.removePipeById(pipeIds[pick]); break;
+            case 3: pipeIds.push_back(manager.addPipe(string(gen.nextPipe().name), 700, false)); break;
+            case 4: manager.batchEditStations({ stationIds[pick % stationIds.size()] }, i % 4 == 0 ? 1 : -1); break;
+            case 5: manager.removeStationById(stationIds[pick % stationIds.size()]); break;
+            }
+        }
+    }, 1);
+
+    NetworkStats scanned;
+    const PipeTable& pipes = manager.getPipes();
+    const StationTable& stations = manager.getStations();
+    double scanMs = timeMs([&]() {
+        scanned.rebuild(pipes.diameterColumn(), pipes.repairColumn(), stations.totalColumn(), stations.workingColumn());
+    }, 3);
+    double avgIdle = 0;
+    double readMs = timeMs([&]() { avgIdle = manager.getStats().averageIdlePercent(); }, 3);
+
+    const NetworkStats& live = manager.getStats();
+    bool same = live.pipeCount() == pipes.size() && live.stationCount() == stations.size()
+        && live.pipesInRepair() == scanned.pipesInRepair() && live.averageDiameter() == scanned.averageDiameter()
+        && live.diameterHistogram() == scanned.diameterHistogram() && live.totalWorkshops() == scanned.totalWorkshops()
+        && live.workingWorkshops() == scanned.workingWorkshops() && avgIdle == scanned.averageIdlePercent()
+        && live.idleHistogram() == scanned.idleHistogram();
+
+    cout << "records=" << n << ", " << ops << " changes: " << churnMs << " ms" << (same ? "" : " MISMATCH") << "\n";
+    cout << "  full scan: " << scanMs << " ms, maintained read: " << readMs * 1e6 << " ns\n";
+    return same;
+}
+
+// Versioned stores: batch edits of 1% of n pipes/stations with history on,
+// undo/redo and diff timings, and a reader scanning an old version on
+// another thread while the writer keeps editing.
+bool benchHistory(size_t n) {
+    Manager manager;
+    NetworkGenerator gen(17);
+    gen.populate(manager, n, n);
+    double enableMs = timeMs([&]() { manager.setHistoryLimit(16); }, 1);
+
+    auto snapshot = [&]() {
+        vector<Pipe> all;
+        all.reserve(manager.getPipeCount());
+        for (const auto& pair : manager.getPipes()) all.push_back(pair.second);
+        return all;
+    };
+    auto sameAs = [&](const vector<Pipe>& expect) {
+        if (expect.size() != manager.getPipeCount()) return false;
+        for (const Pipe& p : expect) {
+            Pipe q = manager.getPipeById(p.getId()).value_or(Pipe());
+            if (q.isInRepair() != p.isInRepair() || q.getDiameter() != p.getDiameter()) return false;
+        }
+        return true;
+    };
+
+    const vector<int> pipeIds = manager.getPipes().idColumn();
+    const vector<int> stationIds = manager.getStations().idColumn();
+    vector<int> pipeBatch, stationBatch;
+    for (size_t i = 0; i < n; i += 100) {
+        pipeBatch.push_back(pipeIds[i]);
+        stationBatch.push_back(stationIds[i]);
+    }
+    vector<Pipe> before = snapshot();
+    shared_ptr<const StoreVersion> base = manager.getCurrentVersion();
+    size_t baseRepair = 0;
+    base->forEachPipe([&](int, const PipeState& p) { baseRepair += p.in_repair; });
+
+    // The reader counts pipes in repair in the base version over and over.
+    atomic<bool> stop(false);
+    atomic<size_t> scans(0);
+    bool readerOk = true;
+    thread reader([&]() {
+        while (!stop.load()) {
+            size_t repair = 0;
+            base->forEachPipe([&](int, const PipeState& p) { repair += p.in_repair; });
+            readerOk = readerOk && repair == baseRepair;
+            scans.fetch_add(1);
+        }
+    });
+
+    double batchMs = timeMs([&]() {
+        manager.batchEditPipes(pipeBatch, 1);
+        manager.batchEditStations(stationBatch, -1);
+    }, 1);
+    vector<Pipe> after = snapshot();
+    VersionDiff diff;
+    uint64_t last = manager.getCurrentVersion()->getNumber();
+    double diffMs = timeMs([&]() { manager.diffVersions(base->getNumber(), last, diff); }, 3);
+    double undoMs = timeMs([&]() { manager.undo(); manager.undo(); }, 1);
+    bool ok = sameAs(before);
+    double redoMs = timeMs([&]() { manager.redo(); manager.redo(); }, 1);
+    ok = ok && sameAs(after);
+    while (scans.load() < 2) this_thread::yield();
+    stop = true;
+    reader.join();
+    ok = ok && readerOk && diff.pipes_changed.size() + diff.stations_changed.size() <= pipeBatch.size() + stationBatch.size()
+        && diff.pipes_added.empty() && diff.pipes_removed.empty();
+
+    cout << "records=" << n << ", batch of " << pipeBatch.size() << "+" << stationBatch.size() << (ok ? "" : " MISMATCH") << "\n";
+    cout << "  enable history: " << enableMs << " ms, batch edits: " << batchMs << " ms, diff ("
+        << diff.size() << "): " << diffMs << " ms\n";
+    cout << "  undo both: " << undoMs << " ms, redo both: " << redoMs << " ms, reader scans: " << scans.load() << "\n";
+    return ok;
+}
+
+// Autosave: how long the editing thread is held by a synchronous save
+// versus publishing to the background saver, and whether the file the
+// saver leaves behind loads back to the same tables.
+bool benchAutosave(size_t n) {
+    Manager manager;
+    NetworkGenerator gen(19);
+    gen.populate(manager, n, n);
+    const string textFile = "bench_autosave.txt", snapFile = "bench_autosave.snap";
+    double syncMs = timeMs([&]() { manager.saveToFile(textFile); }, 1);
+
+    vector<int> pipeIds = manager.getPipes().idColumn();
+    size_t edits = 1000;
+    bool ok = true;
+    for (const string& file : { textFile, snapFile }) {
+        manager.startAutosave(file, chrono::milliseconds(0), edits / 4);
+        double editMs = timeMs([&]() {
+            for (size_t i = 0; i < edits; ++i) manager.setPipeInRepair(pipeIds[(i * 2654435761u) % pipeIds.size()], i % 2 == 0);
+        }, 1);
+        double flushMs = timeMs([&]() { ok = manager.flushAutosave() && ok; }, 1);
+        manager.stopAutosave();
+
+        Manager loaded;
+        bool read = file == snapFile ? loaded.loadSnapshot(file) : loaded.loadFromFile(file);
+        bool same = read && loaded.getPipeCount() == manager.getPipeCount() && loaded.getStationCount() == manager.getStationCount();
+        for (size_t i = 0; same && i < edits; ++i) {
+            int id = pipeIds[(i * 2654435761u) % pipeIds.size()];
+            same = loaded.getPipeById(id).value_or(Pipe()).isInRepair() == manager.getPipeById(id).value_or(Pipe()).isInRepair();
+        }
+        ok = ok && same;
+        cout << "records=" << n << " " << file << (same ? "" : " MISMATCH") << "\n";
+        cout << "  sync save: " << syncMs << " ms, " << edits << " edits with autosave: " << editMs
+            << " ms (" << editMs * 1e3 / edits << " us each), final flush: " << flushMs << " ms\n";
+    }
+    remove(textFile.c_str());
+    remove(snapFile.c_str());
+    return ok;
+}
+
+// Every record with all of its fields, in id order, for comparing stores.
+string storeDump(Manager& manager) {
+    ostringstream os;
+    IdList pipeIds = manager.getPipes().idColumn();
+    sort(pipeIds.begin(), pipeIds.end());
+    for (int id : pipeIds) {
+        Pipe p = manager.getPipeById(id).value_or(Pipe());
+        os << p << " " << p.getInStation() << ">" << p.getOutStation() << "\n";
+    }
+    IdList stationIds = manager.getStations().idColumn();
+    sort(stationIds.begin(), stationIds.end());
+    for (int id : stationIds) os << manager.getStationById(id).value_or(CompressorStation()) << "\n";
+    return os.str();
+}
+
+// Persistent store: random edits with undo and redo must reopen to the same
+// tables, a WAL cut at any byte must reopen to the state after its last
+// whole entry, and a crash between compaction's snapshot rename and the
+// journal reset must not apply anything twice. The store holds at most a
+// few thousand records so every cut can be reopened.
+bool benchJournal(size_t n) {
+    const size_t records = min<size_t>(n, 2000);
+    const string base = "bench_journal", snapFile = base + ".snap", walFile = base + ".wal";
+    const string savedSnap = base + "_saved.snap", savedWal = base + "_saved.wal";
+    const auto overwrite = filesystem::copy_options::overwrite_existing;
+    for (const string& file : { snapFile, walFile, savedSnap, savedWal }) remove(file.c_str());
+
+    bool ok = true;
+    const size_t edits = 4 * records;
+    string expected;
+    double editMs = 0;
+    {
+        Manager manager;
+        manager.setHistoryLimit(64);
+        manager.setCompactThreshold(~uint64_t(0));
+        ok = manager.openStore(base);
+        NetworkGenerator gen(31);
+        gen.populate(manager, records, records / 4 + 1);
+        gen.connect(manager);
+        const IdList pipeIds = manager.getPipes().idColumn(), stationIds = manager.getStations().idColumn();
+        uint64_t state = 31;
+        auto below = [&](size_t bound) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<size_t>((state >> 33) % bound);
+        };
+        editMs = timeMs([&]() {
+            for (size_t i = 0; i < edits; ++i) {
+                int pipe = pipeIds[below(pipeIds.size())];
+                int station = stationIds[below(stationIds.size())], other = stationIds[below(stationIds.size())];
+                switch (below(10)) {
+                case 0: manager.setPipeInRepair(pipe, below(2) == 1); break;
+                case 1: manager.setStationWorking(station, static_cast<int>(below(8))); break;
+                // Repeated ids step the same station twice.
+                case 2: manager.batchEditStations({ station, station, other }, below(2) ? 1 : -1); break;
+                case 3: manager.batchEditPipes({ pipe, pipeIds[below(pipeIds.size())] }, static_cast<int>(below(2))); break;
+                case 4: manager.connectPipe(pipe, station, other); break;
+                case 5: manager.removePipeById(pipe); break;
+                case 6: manager.addPipe("journal_" + to_string(i), 500, false); break;
+                case 7: manager.undo(); break;
+                case 8: manager.redo(); break;
+                default: manager.removeStationById(station); break;
+                }
+                if (i == edits / 2) ok = manager.compact() && ok;
+            }
+            manager.flushJournal();
+        }, 1);
+        expected = storeDump(manager);
+    }
+    double reopenMs = 0;
+    {
+        Manager reopened;
+        reopenMs = timeMs([&]() { ok = reopened.openStore(base) && ok; }, 1);
+        ok = ok && storeDump(reopened) == expected;
+    }
+    cout << "records=" << records << ", " << edits << " edits with undo/redo: " << editMs << " ms, reopen "
+        << reopenMs << " ms" << (ok ? "" : " MISMATCH") << "\n";
+
+    // One flushed edit at a time after a fresh compaction; each WAL size is
+    // the end of a whole entry group, with the state it holds.
+    vector<pair<uintmax_t, string>> prefixes;
+    {
+        Manager manager;
+        manager.setCompactThreshold(~uint64_t(0));
+        ok = manager.openStore(base) && manager.compact() && ok;
+        filesystem::copy_file(snapFile, savedSnap, overwrite);
+        prefixes.emplace_back(filesystem::file_size(walFile), storeDump(manager));
+        const IdList pipeIds = manager.getPipes().idColumn(), stationIds = manager.getStations().idColumn();
+        for (size_t i = 0; i < 48; ++i) {
+            int pipe = pipeIds[i * 7 % pipeIds.size()], station = stationIds[i * 5 % stationIds.size()];
+            switch (i % 4) {
+            case 0: manager.setPipeInRepair(pipe, i % 3 == 0); break;
+            case 1: manager.batchEditStations({ station }, i % 8 < 4 ? 1 : -1); break;
+            case 2: manager.addPipe("cut_" + to_string(i), 700, i % 2 == 1); break;
+            default: manager.setStationWorking(station, 0); break;
+            }
+            manager.flushJournal();
+            prefixes.emplace_back(filesystem::file_size(walFile), storeDump(manager));
+        }
+        filesystem::copy_file(walFile, savedWal, overwrite);
+    }
+    const uintmax_t walBytes = filesystem::file_size(savedWal);
+    size_t survived = 0;
+    for (uintmax_t cut = 0; cut <= walBytes; ++cut) {
+        filesystem::copy_file(savedSnap, snapFile, overwrite);
+        filesystem::copy_file(savedWal, walFile, overwrite);
+        filesystem::resize_file(walFile, cut);
+        size_t k = 0;
+        while (k + 1 < prefixes.size() && prefixes[k + 1].first <= cut) ++k;
+        Manager manager;
+        survived += manager.openStore(base) && storeDump(manager) == prefixes[k].second;
+    }
+    ok = ok && survived == walBytes + 1;
+    cout << "  WAL cut at every byte: " << survived << "/" << walBytes + 1 << " reopened to their last whole entry"
+        << (survived == walBytes + 1 ? "" : " MISMATCH") << "\n";
+
+    // Compaction renames its snapshot into place, then the process dies
+    // before the journal reset: the old WAL replays over the new snapshot.
+    bool crashOk = true;
+    {
+        Manager manager;
+        manager.setCompactThreshold(~uint64_t(0));
+        crashOk = manager.openStore(base) && manager.compact();
+        const StationTable& table = manager.getStations();
+        int stepped = 0;
+        for (size_t row = 0; row < table.size() && stepped == 0; ++row) {
+            if (table.workingColumn()[row] < table.totalColumn()[row]) stepped = table.idColumn()[row];
+        }
+        manager.batchEditStations({ stepped }, 1);
+        manager.setPipeInRepair(manager.getPipes().idColumn()[0], true);
+        manager.flushJournal();
+        filesystem::copy_file(walFile, savedWal, overwrite);
+        crashOk = crashOk && stepped != 0 && manager.compact();
+        expected = storeDump(manager);
+    }
+    filesystem::copy_file(savedWal, walFile, overwrite);
+    {
+        Manager crashed;
+        crashOk = crashOk && crashed.openStore(base) && storeDump(crashed) == expected;
+    }
+    ok = ok && crashOk;
+    cout << "  crash between snapshot rename and journal reset: " << (crashOk ? "replays cleanly" : "MISMATCH") << "\n";
+
+    for (const string& file : { snapFile, walFile, savedSnap, savedWal }) remove(file.c_str());
+    return ok;
+}
+
+// Save formats side by side: file size and save/load time of text, binary
+// snapshot and packed files, a full comparison of the packed round trip,
+// and damaged packed files that must all be rejected.
+bool benchPacked(size_t n) {
+    Manager manager;
+    NetworkGenerator gen(23);
+    gen.populate(manager, n, n);
+    gen.connect(manager);
+
+    auto fileMb = [](const string& file) {
+        ifstream is(file, ios::binary | ios::ate);
+        return static_cast<double>(is.tellg()) / (1024.0 * 1024.0);
+    };
+    bool ok = true;
+    cout << "records=" << 2 * n << "\n";
+    for (const string& file : { string("bench_packed.txt"), string("bench_packed.snap"), string("bench_packed.lpk") }) {
+        double saveMs = timeMs([&]() { ok = manager.saveAnyFormat(file) && ok; }, 1);
+        Manager loaded;
+        double loadMs = timeMs([&]() { ok = loaded.loadAnyFormat(file) && ok; }, 1);
+        cout << "  " << file << ": " << fileMb(file) << " MB, save " << saveMs << " ms, load " << loadMs << " ms\n";
+        if (file.ends_with(".lpk")) {
+            bool same = loaded.getPipeCount() == manager.getPipeCount() && loaded.getStationCount() == manager.getStationCount();
+            for (const auto& pair : manager.getPipes()) {
+                const Pipe& p = pair.second;
+                Pipe q = loaded.getPipeById(p.getId()).value_or(Pipe());
+                same = same && q.getName() == p.getName() && q.getDiameter() == p.getDiameter()
+                    && q.isInRepair() == p.isInRepair() && q.getInStation() == p.getInStation() && q.getOutStation() == p.getOutStation();
+            }
+            for (const auto& pair : manager.getStations()) {
+                const CompressorStation& s = pair.second;
+                CompressorStation t = loaded.getStationById(s.getId()).value_or(CompressorStation());
+                same = same && t.getName() == s.getName() && t.getTotalWorkshops() == s.getTotalWorkshops()
+                    && t.getWorkingWorkshops() == s.getWorkingWorkshops() && t.getClassification() == s.getClassification();
+            }
+            if (!same) cout << "  MISMATCH after packed round trip\n";
+            ok = ok && same;
+
+            // Flip bytes and cut the file short; the checksums must catch every one.
+            string bytes;
+            {
+                ifstream is(file, ios::binary);
+                bytes.assign(istreambuf_iterator<char>(is), istreambuf_iterator<char>());
+            }
+            size_t rejected = 0, trials = 64;
+            for (size_t t = 0; t < trials; ++t) {
+                string damaged = bytes;
+                if (t % 2) damaged.resize(damaged.size() * t / trials);
+                else damaged[(t * 2654435761u) % damaged.size()] ^= 0x5A;
+                ofstream(file, ios::binary | ios::trunc).write(damaged.data(), damaged.size());
+                Manager broken;
+                rejected += !broken.loadPacked(file);
+            }
+            cout << "  damaged files rejected: " << rejected << "/" << trials << (rejected == trials ? "" : " MISMATCH") << "\n";
+            ok = ok && rejected == trials;
+        }
+        remove(file.c_str());
+    }
+    return ok;
+}
+
+// Lazy open against a full load of the same text file: time to first use,
+// point lookups through a small page cache, and edits on both managers
+// that must leave identical stores once the lazy one loads the rest.
+bool benchLazy(size_t n) {
+    const string filename = "bench_lazy.txt";
+    {
+        Manager source;
+        NetworkGenerator gen(29);
+        gen.populate(source, n, n);
+        gen.connect(source);
+        source.saveToFile(filename);
+    }
+    remove((filename + ".idx").c_str());
+
+    Manager eager, lazy;
+    double loadMs = timeMs([&]() { eager.loadFromFile(filename); }, 1);
+    const size_t budget = 4 << 20;
+    double openMs = timeMs([&]() { lazy.openLazy(filename, budget); }, 1);
+    Manager again;
+    double reopenMs = timeMs([&]() { again.openLazy(filename, budget); }, 1);
+
+    const vector<int> pipeIds = eager.getPipes().idColumn();
+    const vector<int> stationIds = eager.getStations().idColumn();
+    size_t lookups = min<size_t>(n, 100000);
+    bool ok = lazy.isLazy() && lazy.getPipeCount() == eager.getPipeCount() && lazy.getStationCount() == eager.getStationCount();
+    size_t peak = 0;
+    double lookupMs = timeMs([&]() {
+        for (size_t i = 0; i < lookups; ++i) {
+            int id = pipeIds[(i * 2654435761u) % pipeIds.size()];
+            Pipe a = lazy.getPipeById(id).value_or(Pipe()), b = eager.getPipeById(id).value_or(Pipe());
+            ok = ok && a.getName() == b.getName() && a.isInRepair() == b.isInRepair() && a.getOutStation() == b.getOutStation();
+            peak = max(peak, lazy.getLazyStore().cachedBytes());
+        }
+    }, 1);
+    const PagedStore& store = lazy.getLazyStore();
+    cout << "records=" << 2 * n << ", " << store.pageCount() << " pages\n";
+    cout << "  full load: " << loadMs << " ms, lazy open: " << openMs << " ms, reopen with index: " << reopenMs << " ms\n";
+    cout << "  " << lookups << " lookups: " << lookupMs * 1e3 / lookups << " us each, cache peak " << peak / 1024
+        << " KiB of " << budget / 1024 << " KiB, hits " << store.cacheHits() << " misses " << store.cacheMisses() << "\n";
+    ok = ok && peak <= budget + (256 << 10);
+
+    // The same edits on both, then compare everything.
+    for (Manager* m : { &eager, &lazy }) {
+        for (size_t i = 0; i < 1000; ++i) {
+            size_t pick = (i * 40503u) % pipeIds.size();
+            if (i % 3 == 0) m->setPipeInRepair(pipeIds[pick], i % 2 == 0);
+            else if (i % 3 == 1) m->removePipeById(pipeIds[pick]);
+            else m->setStationWorking(stationIds[pick % stationIds.size()], 0);
+        }
+    }
+    bool stillLazy = lazy.isLazy();
+    double restMs = timeMs([&]() { lazy.getStats(); }, 1);
+    ok = ok && stillLazy && !lazy.isLazy() && lazy.getPipeCount() == eager.getPipeCount();
+    for (const auto& pair : eager.getPipes()) {
+        Pipe q = lazy.getPipeById(pair.first).value_or(Pipe());
+        ok = ok && q.isInRepair() == pair.second.isInRepair() && q.getInStation() == pair.second.getInStation();
+    }
+    for (const auto& pair : eager.getStations()) {
+        ok = ok && lazy.getStationById(pair.first).value_or(CompressorStation()).getWorkingWorkshops() == pair.second.getWorkingWorkshops();
+    }
+    ok = ok && lazy.getStats().pipesInRepair() == eager.getStats().pipesInRepair();
+    cout << "  loading the rest after 1000 edits: " << restMs << " ms" << (ok ? "" : " MISMATCH") << "\n";
+
+    // The file gone before the rest is read: the save fails and nothing is dropped.
+    Manager orphan;
+    const string moved = filename + ".moved";
+    bool kept = orphan.openLazy(filename, budget);
+    const size_t onFile = orphan.getPipeCount();
+    kept = kept && orphan.setPipeInRepair(pipeIds[0], true) && rename(filename.c_str(), moved.c_str()) == 0;
+    kept = kept && !orphan.saveToFile("bench_lazy_out.txt") && orphan.isLazy() && orphan.getPipeCount() == onFile;
+    kept = kept && rename(moved.c_str(), filename.c_str()) == 0 && orphan.saveToFile("bench_lazy_out.txt") && !orphan.isLazy()
+        && orphan.getPipes().size() == onFile;
+    cout << "  unreadable file on full load: " << (kept ? "stays lazy" : "MISMATCH") << "\n";
+    ok = ok && kept;
+
+    // A snapshot is served from its mapping the same way until a whole-store query copies it.
+    const string snapFile = "bench_lazy.snap", badFile = "bench_lazy_bad.snap";
+    Manager plain, mapped;
+    bool mappedOk = plain.loadFromFile(filename) && plain.saveSnapshot(snapFile);
+    double mapMs = timeMs([&]() { mappedOk = mapped.loadSnapshot(snapFile) && mappedOk; }, 1);
+    mappedOk = mappedOk && mapped.isLazy() && mapped.getPipeCount() == plain.getPipeCount()
+        && mapped.getStationCount() == plain.getStationCount();
+    double mappedMs = timeMs([&]() {
+        for (size_t i = 0; mappedOk && i < lookups; ++i) {
+            int id = pipeIds[(i * 2654435761u) % pipeIds.size()];
+            mappedOk = mapped.getPipeById(id).value_or(Pipe()).getName() == plain.getPipeById(id).value_or(Pipe()).getName();
+        }
+    }, 1);
+    mappedOk = mappedOk && mapped.setPipeInRepair(pipeIds[0], true) && plain.setPipeInRepair(pipeIds[0], true) && mapped.isLazy();
+    mappedOk = mappedOk && mapped.getPipes().size() == plain.getPipeCount() && !mapped.isLazy()
+        && mapped.getPipeById(pipeIds[0]).value_or(Pipe()).isInRepair();
+    // A header whose counts overflow when multiplied by the record size.
+    {
+        ifstream is(snapFile, ios::binary);
+        string bytes((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+        SnapshotHeader h;
+        memcpy(&h, bytes.data(), sizeof(h));
+        h.pipe_count = (~uint64_t(0) / sizeof(PipeRecord)) + 1;
+        memcpy(bytes.data(), &h, sizeof(h));
+        ofstream(badFile, ios::binary | ios::trunc).write(bytes.data(), bytes.size());
+        Manager broken;
+        mappedOk = mappedOk && !broken.loadSnapshot(badFile);
+    }
+    cout << "  snapshot: map " << mapMs << " ms, " << lookups << " lookups " << mappedMs * 1e3 / lookups << " us each"
+        << (mappedOk ? "" : " MISMATCH") << "\n";
+    ok = ok && mappedOk;
+    remove(snapFile.c_str());
+    remove(badFile.c_str());
+    remove("bench_lazy_out.txt");
+    remove(filename.c_str());
+    remove((filename + ".idx").c_str());
+    return ok;
+}
+
+// Listing: operator<< per record against the buffered printer, both into
+// a string to compare the text, then the printer straight into a file
+// descriptor, and one sorted page from the middle.
+bool benchList(size_t n) {
+    Manager manager;
+    NetworkGenerator gen(31);
+    gen.populate(manager, n, n);
+    gen.connect(manager);
+    const PipeTable& pipes = manager.getPipes();
+    const StationTable& stations = manager.getStations();
+
+    ostringstream streamed;
+    double streamMs = timeMs([&]() {
+        streamed.str("");
+        for (const auto& pair : pipes) streamed << pair.second << "\n";
+        for (const auto& pair : stations) streamed << pair.second << "\n";
+    }, 1);
+    ostringstream printed;
+    double printMs = timeMs([&]() {
+        printed.str("");
+        OutputBuffer out(printed);
+        printPipes(pipes, ListOptions(), out);
+        printStations(stations, ListOptions(), out);
+    }, 1);
+    bool ok = streamed.str() == printed.str();
+
+    double fdMs = -1;
+    FILE* sink = fopen("bench_list.txt", "wb");
+    if (sink) {
+        fdMs = timeMs([&]() {
+            OutputBuffer out(fileno(sink));
+            printPipes(pipes, ListOptions(), out);
+            printStations(stations, ListOptions(), out);
+            ok = out.flush() && ok;
+        }, 1);
+        fclose(sink);
+        remove("bench_list.txt");
+    }
+
+    ListOptions page;
+    page.sorted_by_id = true;
+    page.offset = n / 2;
+    page.limit = 100;
+    ostringstream middle;
+    double pageMs = timeMs([&]() {
+        middle.str("");
+        OutputBuffer out(middle);
+        printPipes(pipes, page, out);
+    }, 3);
+    const string pageText = middle.str();
+    ok = ok && count(pageText.begin(), pageText.end(), '\n') == static_cast<ptrdiff_t>(min<size_t>(100, n - n / 2));
+
+    double mb = static_cast<double>(printed.str().size()) / (1024.0 * 1024.0);
+    cout << "records=" << 2 * n << ", " << mb << " MB of text" << (ok ? "" : " MISMATCH") << "\n";
+    cout << "  operator<<: " << streamMs << " ms, buffered: " << printMs << " ms, to fd: " << fdMs
+        << " ms, sorted page of 100: " << pageMs << " ms\n";
+    return ok;
+}
+
+// Id -> row lookups: the slot map the tables use against the hash map they
+// used before, then stale handles and ids too sparse for the vector.
+bool benchSlotMap(size_t n) {
+    SlotMap<uint32_t> slots;
+    unordered_map<int, uint32_t> hashed;
+    slots.reserve(n);
+    hashed.reserve(n);
+    for (size_t i = 1; i <= n; ++i) {
+        slots.insert(static_cast<int>(i), static_cast<uint32_t>(i - 1));
+        hashed.emplace(static_cast<int>(i), static_cast<uint32_t>(i - 1));
+    }
+    // Every fourth id removed, as after a run of deletes.
+    for (size_t i = 4; i <= n; i += 4) {
+        slots.erase(static_cast<int>(i));
+        hashed.erase(static_cast<int>(i));
+    }
+    // Ids too sparse for the vector must not slow down the dense ones.
+    slots.insert(-5, 1);
+    slots.insert(2000000000, 2);
+    hashed.emplace(-5, 1);
+    hashed.emplace(2000000000, 2);
+    const size_t lookups = 10000000;
+    vector<int> probe(lookups);
+    for (size_t i = 0; i < lookups; ++i) probe[i] = static_cast<int>((i * 2654435761u) % (n + n / 8) + 1);
+
+    uint64_t slotSum = 0, hashSum = 0;
+    double slotMs = timeMs([&]() {
+        for (int id : probe) {
+            if (const uint32_t* row = slots.find(id)) slotSum += *row + 1;
+        }
+    }, 1);
+    double hashMs = timeMs([&]() {
+        for (int id : probe) {
+            auto it = hashed.find(id);
+            if (it != hashed.end()) hashSum += it->second + 1;
+        }
+    }, 1);
+    bool ok = slotSum == hashSum && slots.size() == hashed.size();
+
+    SlotMap<uint32_t>::Handle h = slots.handle(1);
+    slots.erase(1);
+    slots.insert(1, 7);
+    ok = ok && slots.find(h) == nullptr && slots.find(slots.handle(1)) && *slots.find(1) == 7;
+    ok = ok && slots.contains(-5) && *slots.find(2000000000) == 2 && !slots.contains(1999999999);
+
+    // A side-map id moves into the vector once the vector reaches it.
+    SlotMap<uint32_t> growing;
+    growing.insert(100000, 9);
+    SlotMap<uint32_t>::Handle far = growing.handle(100000);
+    for (int id = 1; id < 100000; ++id) growing.insert(id, static_cast<uint32_t>(id));
+    growing.insert(100001, 1);
+    ok = ok && growing.size() == 100001 && growing.find(far) && *growing.find(100000) == 9;
+
+    cout << "ids=" << n << ", " << lookups << " lookups" << (ok ? "" : " MISMATCH") << "\n";
+    cout << "  slot map: " << slotMs * 1e6 / lookups << " ns each, unordered_map: " << hashMs * 1e6 / lookups << " ns each\n";
+    return ok;
+}
+
+#ifdef __linux__
+// Blocking client side of the daemon protocol.
+struct ServerClient {
+    int fd = -1;
+    string in;
+
+    ~ServerClient() {
+        if (fd >= 0) close(fd);
+    }
+    bool connectTo(const string& path) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, path.c_str(), min(path.size(), sizeof(addr.sun_path) - 1));
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        return fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+    bool sendAll(const string& data) {
+        for (size_t done = 0; done < data.size();) {
+            ssize_t sent = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (sent <= 0) return false;
+            done += static_cast<size_t>(sent);
+        }
+        return true;
+    }
+    bool fill() {
+        char tmp[64 * 1024];
+        ssize_t got = recv(fd, tmp, sizeof(tmp), 0);
+        if (got <= 0) return false;
+        in.append(tmp, static_cast<size_t>(got));
+        return true;
+    }
+    bool readReply(bool& ok, string& body) {
+        size_t eol;
+        while ((eol = in.find('\n')) == string::npos) {
+            if (!fill()) return false;
+        }
+        ok = in.compare(0, 3, "OK ") == 0;
+        size_t length = strtoul(in.c_str() + (ok ? 3 : 4), nullptr, 10);
+        while (in.size() < eol + 1 + length) {
+            if (!fill()) return false;
+        }
+        body.assign(in, eol + 1, length);
+        in.erase(0, eol + 1 + length);
+        return true;
+    }
+};
+
+// Daemon load: an in-process server on a Unix socket, several client
+// threads sending batches of 'depth' pipelined requests (show, count,
+// repair), every reply checked. Latency runs from a batch's send to the
+// arrival of each reply.
+bool benchServer(size_t n) {
+    Manager manager;
+    NetworkGenerator gen(31);
+    gen.populate(manager, n, n);
+    gen.connect(manager);
+    const vector<int> pipeIds = manager.getPipes().idColumn();
+    const vector<int> stationIds = manager.getStations().idColumn();
+
+    const string path = "/tmp/lab1_bench_" + to_string(getpid()) + ".sock";
+    SocketServer server(manager, path);
+    bool started = true;
+    thread serving([&]() { started = server.run(); });
+    while (!server.isListening() && started) this_thread::sleep_for(chrono::milliseconds(1));
+
+    const size_t clients = 4;
+    const size_t perClient = 20480;
+    bool ok = started;
+    cout << "records=" << 2 * n << ", " << clients << " clients\n";
+    for (size_t depth : { 1, 16, 128 }) {
+        vector<vector<double>> latencies(clients);
+        vector<int> good(clients, 1);
+        auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (size_t c = 0; c < clients && ok; ++c) {
+            workers.emplace_back([&, c]() {
+                ServerClient client;
+                if (!client.connectTo(path)) {
+                    good[c] = 0;
+                    return;
+                }
+                latencies[c].reserve(perClient);
+                string batch, body;
+                for (size_t sent = 0; sent < perClient; sent += depth) {
+                    batch.clear();
+                    for (size_t k = sent; k < sent + depth; ++k) {
+                        size_t pick = (k * 2654435761u + c) % pipeIds.size();
+                        switch (k % 4) {
+                        case 0: batch += "show pipe " + to_string(pipeIds[pick]) + "\n"; break;
+                        case 1: batch += "count\n"; break;
+                        case 2: batch += "repair " + to_string(pipeIds[pick]) + " " + to_string(k % 2) + "\n"; break;
+                        default: batch += "show station " + to_string(stationIds[pick % stationIds.size()]) + "\n"; break;
+                        }
+                    }
+                    auto issued = chrono::steady_clock::now();
+                    if (!client.sendAll(batch)) {
+                        good[c] = 0;
+                        return;
+                    }
+                    for (size_t k = sent; k < sent + depth; ++k) {
+                        bool replyOk = false;
+                        if (!client.readReply(replyOk, body)) {
+                            good[c] = 0;
+                            return;
+                        }
+                        latencies[c].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - issued).count());
+                        bool expected = k % 4 == 1 ? body.compare(0, 6, "pipes ") == 0
+                            : k % 4 == 2 ? body.empty() : body.compare(0, 3, "ID=") == 0;
+                        if (!replyOk || !expected) good[c] = 0;
+                    }
+                }
+            });
+        }
+        for (thread& t : workers) t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        vector<double> all;
+        for (size_t c = 0; c < clients; ++c) {
+            ok = ok && good[c];
+            all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        }
+        if (all.empty()) break;
+        sort(all.begin(), all.end());
+        cout << "  depth " << depth << ": " << static_cast<size_t>(all.size() / seconds) << " req/s, p50 "
+            << all[all.size() / 2] << " us, p99 " << all[all.size() * 99 / 100] << " us\n";
+    }
+
+    // A bad request is answered in order, then the server is told to stop.
+    ServerClient last;
+    string body;
+    bool errOk = true, stopOk = false;
+    ok = ok && last.connectTo(path) && last.sendAll("frobnicate\ncount\nshutdown\n")
+        && last.readReply(errOk, body) && !errOk && last.readReply(stopOk, body) && stopOk
+        && last.readReply(stopOk, body) && stopOk;
+    server.stop();
+    serving.join();
+    ok = ok && started && server.requestCount() == 3 * clients * perClient + 3;
+    cout << "  served " << server.requestCount() << " requests over " << server.connectionCount() << " connections"
+        << (ok ? "" : " MISMATCH") << "\n";
+    return ok;
+}
+#else
+bool benchServer(size_t) {
+    cout << "server: Unix sockets with epoll are Linux only, skipped\n";
+    return true;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    string mode = "all";
+    vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (isdigit(static_cast<unsigned char>(arg[0]))) sizes.push_back(stoul(arg));
+        else mode = arg;
+    }
+    if (sizes.empty()) sizes = mode == "suite" ? vector<size_t>{ 10000, 1000000, 10000000 } : vector<size_t>{ 10000, 1000000 };
+
+    bool ok = true;
+    if (mode == "suite") printf("op,records,calls,items_per_call,ns_per_op,ops_per_s,items_per_s,bytes_per_op,allocs_per_op\n");
+    for (size_t n : sizes) {
+        if (mode == "suite") benchSuite(n);
+        if (mode == "stress") ok = benchStress(n) && ok;
+        if (mode == "scaling") benchScaling(n);
+        if (mode == "all" || mode == "scan") benchScans(n);
+        if (mode == "all" || mode == "textload") benchTextLoad(n);
+        if (mode == "all" || mode == "namesearch") benchNameSearch(n);
+        if (mode == "all" || mode == "alloc") benchAllocations(n);
+        if (mode == "all" || mode == "query") benchQuery(n);
+        if (mode == "all" || mode == "filter") ok = benchFilter(n) && ok;
+        if (mode == "all" || mode == "network") ok = benchNetwork(n) && ok;
+        if (mode == "all" || mode == "flow") ok = benchFlow(n) && ok;
+        if (mode == "all" || mode == "stats") ok = benchStats(n) && ok;
+        if (mode == "all" || mode == "idle") ok = benchIdle(n) && ok;
+        if (mode == "all" || mode == "history") ok = benchHistory(n) && ok;
+        if (mode == "all" || mode == "autosave") ok = benchAutosave(n) && ok;
+        if (mode == "all" || mode == "journal") ok = benchJournal(n) && ok;
+        if (mode == "all" || mode == "packed") ok = benchPacked(n) && ok;
+        if (mode == "all" || mode == "lazy") ok = benchLazy(n) && ok;
+        if (mode == "all" || mode == "list") ok = benchList(n) && ok;
+        if (mode == "all" || mode == "server") ok = benchServer(n) && ok;
+        if (mode == "all" || mode == "slotmap") ok = benchSlotMap(n) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include "AsyncLog.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const size_t HEADER_BYTES = 1 + sizeof(uint32_t);
+// Longer strings are split so one event always fits the ring.
+const size_t MAX_TEXT_PART = 4096;
+
+}
+
+AsyncLog* AsyncLog::current = nullptr;
+
+AsyncLog::AsyncLog(std::ostream& out_, std::chrono::milliseconds interval_, size_t capacity_)
+    : out(out_), capacity(1), interval(interval_), head(0), tail(0), written(0), kicked(false), stopping(false) {
+    while (capacity < capacity_ || capacity < 4 * (HEADER_BYTES + MAX_TEXT_PART)) capacity <<= 1;
+    ring.reset(new char[capacity]);
+    worker = std::thread(&AsyncLog::run, this);
+    current = this;
+}
+
+AsyncLog::~AsyncLog() {
+    if (current == this) current = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void AsyncLog::copyIn(size_t pos, const void* src, size_t n) {
+    size_t at = pos & (capacity - 1);
+    size_t first = std::min(n, capacity - at);
+    std::memcpy(ring.get() + at, src, first);
+    std::memcpy(ring.get(), static_cast<const char*>(src) + first, n - first);
+}
+
+void AsyncLog::copyOut(size_t pos, void* dst, size_t n) const {
+    size_t at = pos & (capacity - 1);
+    size_t first = std::min(n, capacity - at);
+    std::memcpy(dst, ring.get() + at, first);
+    std::memcpy(static_cast<char*>(dst) + first, ring.get(), n - first);
+}
+
+void AsyncLog::kick() {
+    kicked.store(true, std::memory_order_release);
+    wake.notify_one();
+}
+
+void AsyncLog::push(EventType type, const void* payload, uint32_t length) {
+    size_t need = HEADER_BYTES + length;
+    size_t pos = head.load(std::memory_order_relaxed);
+    // Full ring: wait for the worker instead of dropping input.
+    while (capacity - (pos - tail.load(std::memory_order_acquire)) < need) {
+        kick();
+        std::this_thread::yield();
+    }
+    uint8_t tag = type;
+    copyIn(pos, &tag, 1);
+    copyIn(pos + 1, &length, sizeof(length));
+    copyIn(pos + HEADER_BYTES, payload, length);
+    head.store(pos + need, std::memory_order_release);
+
+    size_t used = pos + need - tail.load(std::memory_order_relaxed);
+    if (used >= capacity / 2 && used - need < capacity / 2) kick();
+}
+
+void AsyncLog::text(std::string_view s) {
+    while (s.size() > MAX_TEXT_PART) {
+        push(TEXT_PART, s.data(), static_cast<uint32_t>(MAX_TEXT_PART));
+        s.remove_prefix(MAX_TEXT_PART);
+    }
+    push(TEXT, s.data(), static_cast<uint32_t>(s.size()));
+}
+
+void AsyncLog::integer(long long v) {
+    push(INTEGER, &v, sizeof(v));
+}
+
+void AsyncLog::real(double v) {
+    push(REAL, &v, sizeof(v));
+}
+
+void AsyncLog::flush() {
+    size_t target = head.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> guard(lock);
+    kick();
+    drained.wait(guard, [&]() { return written.load() >= target; });
+}
+
+// Formats every complete event between tail and head and writes them as one
+// batch. Runs on the worker thread only.
+void AsyncLog::drain() {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    size_t end = head.load(std::memory_order_acquire);
+    if (pos == end) return;
+
+    batch.clear();
+    char number[32];
+    while (pos < end) {
+        uint8_t tag;
+        uint32_t length;
+        copyOut(pos, &tag, 1);
+        copyOut(pos + 1, &length, sizeof(length));
+        size_t payload = pos + HEADER_BYTES;
+
+        if (tag == TEXT || tag == TEXT_PART) {
+            size_t at = batch.size();
+            batch.resize(at + length);
+            copyOut(payload, &batch[at], length);
+            if (tag == TEXT) batch.push_back('\n');
+        }
+        else if (tag == INTEGER) {
+            long long v;
+            copyOut(payload, &v, sizeof(v));
+            auto res = std::to_chars(number, number + sizeof(number), v);
+            batch.append(number, res.ptr);
+            batch.push_back('\n');
+        }
+        else if (tag == REAL) {
+            double v;
+            copyOut(payload, &v, sizeof(v));
+            // %g is what an ostream with default flags and precision prints.
+            int len = std::snprintf(number, sizeof(number), "%g", v);
+            batch.append(number, static_cast<size_t>(len));
+            batch.push_back('\n');
+        }
+        pos = payload + length;
+    }
+    tail.store(pos, std::memory_order_release);
+
+    out.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+    out.flush();
+}
+
+void AsyncLog::run() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait_for(guard, interval, [&]() { return stopping || kicked.exchange(false); });
+        bool last = stopping;
+        guard.unlock();
+        drain();
+        guard.lock();
+        written.store(tail.load());
+        drained.notify_all();
+        if (last) break;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Input echo log. The writing thread appends small binary events to a
+// lock-free single-producer ring; a background thread turns them into text
+// lines and writes them in batches every flush interval (or earlier when the
+// ring is half full). The text is the same one line per value that the old
+// "std::cerr << x << std::endl" produced, so logs stay replayable.
+//
+// Only one thread may log at a time. The destructor flushes everything.
+class AsyncLog {
+private:
+    enum EventType : uint8_t { TEXT = 1, TEXT_PART = 2, INTEGER = 3, REAL = 4 };
+
+    std::ostream& out;
+    std::unique_ptr<char[]> ring;
+    size_t capacity;
+    std::chrono::milliseconds interval;
+
+    // Free-running byte positions; the ring index is pos & (capacity - 1).
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    std::atomic<size_t> written;
+    // Set before waking the worker early (half-full ring, flush request).
+    std::atomic<bool> kicked;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    bool stopping;
+    std::string batch;
+    std::thread worker;
+
+    static AsyncLog* current;
+
+    void push(EventType type, const void* payload, uint32_t length);
+    void copyIn(size_t pos, const void* src, size_t n);
+    void copyOut(size_t pos, void* dst, size_t n) const;
+    void kick();
+    void drain();
+    void run();
+
+public:
+    // capacity is rounded up to a power of two.
+    AsyncLog(std::ostream& out_, std::chrono::milliseconds interval_ = std::chrono::milliseconds(100),
+        size_t capacity_ = 1 << 20);
+    ~AsyncLog();
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    void text(std::string_view s);
+    void integer(long long v);
+    void real(double v);
+    // Blocks until everything logged so far is written and flushed.
+    void flush();
+
+    // The log INPUT_LINE and GetCorrectNumber write to; null if none.
+    static AsyncLog* active() { return current; }
+};
+
+#endif // ASYNCLOG_H
@@ -0,0 +1,180 @@
+#include "AutoSave.h"
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include "Snapshot.h"
+#include "PackedFormat.h"
+
+namespace {
+
+const size_t WRITE_CHUNK = 1 << 20;
+
+bool endsWith(const std::string& s, const char* suffix) {
+    size_t n = std::char_traits<char>::length(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+template <typename T>
+void appendNumber(std::string& out, T value) {
+    char buf[32];
+    std::to_chars_result r = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, r.ptr);
+}
+
+// Text format written through one buffer that goes to the file in large chunks.
+bool writeText(const std::string& filename, const StoreVersion& version) {
+    std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+    if (!os) return false;
+    std::string buf;
+    buf.reserve(WRITE_CHUNK + 4096);
+    auto spill = [&](bool force) {
+        if (force || buf.size() >= WRITE_CHUNK) {
+            os.write(buf.data(), buf.size());
+            buf.clear();
+        }
+    };
+    version.forEachPipe([&](int id, const PipeState& p) {
+        buf += "PIPE|";
+        appendNumber(buf, id);
+        buf += '|';
+        buf += p.name;
+        buf += '|';
+        appendNumber(buf, p.diameter);
+        buf += p.in_repair ? "|1|" : "|0|";
+        appendNumber(buf, p.in_station);
+        buf += '|';
+        appendNumber(buf, p.out_station);
+        buf += '\n';
+        spill(false);
+    });
+    version.forEachStation([&](int id, const StationState& s) {
+        buf += "STATION|";
+        appendNumber(buf, id);
+        buf += '|';
+        buf += s.name;
+        buf += '|';
+        appendNumber(buf, s.total);
+        buf += '|';
+        appendNumber(buf, s.working);
+        buf += '|';
+        buf += ClassRegistry::name(s.classification);
+        buf += '\n';
+        spill(false);
+    });
+    spill(true);
+    return static_cast<bool>(os);
+}
+
+}
+
+AutoSaver::AutoSaver()
+    : interval(0), dirty_threshold(0), next_pipe_id(1), next_station_id(1), dirty(0),
+    writing(false), flushing(false), stopping(false), save_count(0), last_ok(true) {}
+
+AutoSaver::~AutoSaver() {
+    stop();
+}
+
+bool AutoSaver::saveVersion(const std::string& filename, const StoreVersion& version, int pipeId, int stationId) {
+    const std::string tmpFile = filename + ".tmp";
+    bool ok = endsWith(filename, ".snap") ? writeSnapshot(tmpFile, version, pipeId, stationId)
+        : endsWith(filename, ".lpk") ? writePacked(tmpFile, version, pipeId, stationId, 1)
+        : writeText(tmpFile, version);
+    if (!ok) return false;
+    std::error_code ec;
+    std::filesystem::rename(tmpFile, filename, ec);
+    return !ec;
+}
+
+bool AutoSaver::write(const StoreVersion& version, int pipeId, int stationId) const {
+    return saveVersion(path, version, pipeId, stationId);
+}
+
+void AutoSaver::start(const std::string& path_, std::chrono::milliseconds interval_, size_t dirtyRecords) {
+    stop();
+    path = path_;
+    interval = interval_;
+    dirty_threshold = dirtyRecords;
+    stopping = false;
+    worker = std::thread(&AutoSaver::run, this);
+}
+
+void AutoSaver::stop() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void AutoSaver::publish(std::shared_ptr<const StoreVersion> version, int pipeId, int stationId, size_t changed) {
+    bool due;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        latest = std::move(version);
+        next_pipe_id = pipeId;
+        next_station_id = stationId;
+        dirty += changed;
+        due = dirty_threshold > 0 && dirty >= dirty_threshold;
+    }
+    if (due) wake.notify_one();
+}
+
+bool AutoSaver::flush() {
+    std::unique_lock<std::mutex> guard(lock);
+    if (!worker.joinable()) return last_ok;
+    flushing = true;
+    wake.notify_one();
+    // The worker clears the request once nothing is left to write.
+    saved.wait(guard, [&]() { return !flushing; });
+    return last_ok;
+}
+
+uint64_t AutoSaver::saveCount() {
+    std::lock_guard<std::mutex> guard(lock);
+    return save_count;
+}
+
+bool AutoSaver::lastSaveOk() {
+    std::lock_guard<std::mutex> guard(lock);
+    return last_ok;
+}
+
+void AutoSaver::run() {
+    using clock = std::chrono::steady_clock;
+    std::unique_lock<std::mutex> guard(lock);
+    clock::time_point last = clock::now();
+    while (true) {
+        auto ready = [&]() {
+            return stopping || flushing || (dirty_threshold > 0 && dirty >= dirty_threshold);
+        };
+        if (interval.count() > 0) wake.wait_until(guard, last + interval, ready);
+        else wake.wait(guard, ready);
+
+        bool timeUp = interval.count() > 0 && clock::now() >= last + interval;
+        if (dirty > 0 && latest && (ready() || timeUp)) {
+            // The version is immutable: write it without holding the lock.
+            std::shared_ptr<const StoreVersion> version = latest;
+            int pipeId = next_pipe_id, stationId = next_station_id;
+            dirty = 0;
+            writing = true;
+            guard.unlock();
+            bool ok = write(*version, pipeId, stationId);
+            guard.lock();
+            writing = false;
+            last_ok = ok;
+            ++save_count;
+            last = clock::now();
+        }
+        else if (timeUp) {
+            last = clock::now();
+        }
+        if (dirty == 0 && flushing) {
+            flushing = false;
+            saved.notify_all();
+        }
+        if (stopping && dirty == 0) break;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "VersionHistory.h"
+
+// Background saver. The owner publishes every committed StoreVersion (an
+// O(1) handle, immutable and shared with the live store); a worker thread
+// writes the latest one once the interval has passed or enough records
+// changed, into <path>.tmp with large buffered writes, then renames it over
+// <path>. A path ending in ".snap" gets the binary snapshot format, ".lpk"
+// the packed format, anything else the PIPE|/STATION| text format.
+class AutoSaver {
+private:
+    std::string path;
+    std::chrono::milliseconds interval;
+    size_t dirty_threshold;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable saved;
+    std::shared_ptr<const StoreVersion> latest;
+    int next_pipe_id;
+    int next_station_id;
+    size_t dirty;
+    bool writing;
+    bool flushing;
+    bool stopping;
+    uint64_t save_count;
+    bool last_ok;
+    std::thread worker;
+
+    void run();
+    bool write(const StoreVersion& version, int pipeId, int stationId) const;
+
+public:
+    AutoSaver();
+    ~AutoSaver();
+    AutoSaver(const AutoSaver&) = delete;
+    AutoSaver& operator=(const AutoSaver&) = delete;
+
+    // interval 0 saves on the record threshold only, threshold 0 on the
+    // interval only. Restarting flushes the previous target first.
+    void start(const std::string& path_, std::chrono::milliseconds interval_, size_t dirtyRecords);
+    // Writes what is still pending, then stops the worker.
+    void stop();
+    bool isRunning() const { return worker.joinable(); }
+    const std::string& getPath() const { return path; }
+
+    // 'changed' records differ from the previously published version.
+    void publish(std::shared_ptr<const StoreVersion> version, int pipeId, int stationId, size_t changed);
+    // Blocks until everything published so far is on disk; false if the last write failed.
+    bool flush();
+
+    uint64_t saveCount();
+    bool lastSaveOk();
+
+    // One-off save of a version (same formats, same tmp + rename).
+    static bool saveVersion(const std::string& filename, const StoreVersion& version, int pipeId, int stationId);
+};
+
+#endif // AUTOSAVE_H
@@ -0,0 +1,193 @@
+#include "BlockCodec.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "Checksum.h"
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+const unsigned HASH_BITS = 14;
+
+uint32_t load32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void putLength(std::string& out, size_t extra) {
+    while (extra >= 255) {
+        out += static_cast<char>(255);
+        extra -= 255;
+    }
+    out += static_cast<char>(extra);
+}
+
+// Literal run, then a match unless matchLength is 0 (the closing sequence).
+void putSequence(std::string& out, const unsigned char* literals, size_t literalCount, size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+    out += static_cast<char>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15));
+    if (literalCount >= 15) putLength(out, literalCount - 15);
+    out.append(reinterpret_cast<const char*>(literals), literalCount);
+    if (!matchLength) return;
+    out += static_cast<char>(offset & 0xFF);
+    out += static_cast<char>(offset >> 8);
+    if (matchCode >= 15) putLength(out, matchCode - 15);
+}
+
+bool getLength(const unsigned char*& src, const unsigned char* end, size_t& length) {
+    unsigned char b;
+    do {
+        if (src == end) return false;
+        b = *src++;
+        length += b;
+    } while (b == 255);
+    return true;
+}
+
+// Runs job(i) for i in [0, count) on up to 'threads' threads.
+template <typename Job>
+void forBlocks(size_t count, size_t threads, Job job) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, count));
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) job(i);
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; ++t) workers.emplace_back(worker);
+    worker();
+    for (auto& t : workers) t.join();
+}
+
+}
+
+namespace BlockCodec {
+
+void compress(std::string_view in, std::string& out) {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(in.data());
+    const size_t n = in.size();
+    std::vector<int32_t> table(size_t(1) << HASH_BITS, -1);
+
+    size_t anchor = 0, i = 0;
+    while (i + MIN_MATCH <= n) {
+        uint32_t v = load32(src + i);
+        uint32_t h = (v * 2654435761u) >> (32 - HASH_BITS);
+        int32_t candidate = table[h];
+        table[h] = static_cast<int32_t>(i);
+        if (candidate < 0 || i - candidate > MAX_OFFSET || load32(src + candidate) != v) {
+            // Step faster through data that keeps missing.
+            i += 1 + ((i - anchor) >> 6);
+            continue;
+        }
+        size_t length = MIN_MATCH;
+        while (i + length < n && src[candidate + length] == src[i + length]) ++length;
+        putSequence(out, src + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+        if (i >= 2 && i + MIN_MATCH <= n + 2) {
+            table[(load32(src + i - 2) * 2654435761u) >> (32 - HASH_BITS)] = static_cast<int32_t>(i - 2);
+        }
+    }
+    putSequence(out, src + anchor, n - anchor, 0, 0);
+}
+
+bool decompress(const char* srcData, size_t srcSize, char* dstData, size_t rawSize) {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(srcData);
+    const unsigned char* end = src + srcSize;
+    unsigned char* dst = reinterpret_cast<unsigned char*>(dstData);
+    size_t pos = 0;
+    while (src < end) {
+        unsigned token = *src++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !getLength(src, end, literals)) return false;
+        if (literals > static_cast<size_t>(end - src) || literals > rawSize - pos) return false;
+        std::memcpy(dst + pos, src, literals);
+        src += literals;
+        pos += literals;
+        if (src == end) break;
+
+        if (end - src < 2) return false;
+        size_t offset = src[0] | (size_t(src[1]) << 8);
+        src += 2;
+        size_t length = token & 15;
+        if (length == 15 && !getLength(src, end, length)) return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > pos || length > rawSize - pos) return false;
+        // Overlapping copies repeat the last 'offset' bytes, so go byte by byte.
+        const unsigned char* from = dst + pos - offset;
+        for (size_t k = 0; k < length; ++k) dst[pos + k] = from[k];
+        pos += length;
+    }
+    return pos == rawSize;
+}
+
+void packStream(std::string_view raw, std::string& out, size_t blockSize, size_t threads) {
+    if (blockSize == 0) blockSize = DEFAULT_BLOCK_SIZE;
+    const size_t count = (raw.size() + blockSize - 1) / blockSize;
+    std::vector<std::string> payloads(count);
+    forBlocks(count, threads, [&](size_t i) {
+        std::string_view block = raw.substr(i * blockSize, blockSize);
+        compress(block, payloads[i]);
+        if (payloads[i].size() >= block.size()) payloads[i].assign(block);
+    });
+
+    BlockStreamHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, STREAM_MAGIC, sizeof(h.magic));
+    h.block_size = static_cast<uint32_t>(blockSize);
+    h.raw_size = raw.size();
+    h.block_count = static_cast<uint32_t>(count);
+    const size_t start = out.size();
+    out.append(reinterpret_cast<const char*>(&h), sizeof(h));
+    for (size_t i = 0; i < count; ++i) {
+        BlockEntry e{ static_cast<uint32_t>(std::min(blockSize, raw.size() - i * blockSize)),
+            static_cast<uint32_t>(payloads[i].size()), checksum(payloads[i].data(), payloads[i].size()) };
+        out.append(reinterpret_cast<const char*>(&e), sizeof(e));
+    }
+    h.table_checksum = checksum(out.data() + start, out.size() - start);
+    std::memcpy(out.data() + start, &h, sizeof(h));
+    for (const std::string& p : payloads) out += p;
+}
+
+bool unpackStream(const char* data, size_t size, std::string& raw, size_t threads) {
+    raw.clear();
+    if (size < sizeof(BlockStreamHeader)) return false;
+    BlockStreamHeader h;
+    std::memcpy(&h, data, sizeof(h));
+    if (std::memcmp(h.magic, STREAM_MAGIC, sizeof(h.magic)) != 0) return false;
+    if (h.block_count > (size - sizeof(h)) / sizeof(BlockEntry)) return false;
+    const size_t tableSize = sizeof(h) + size_t(h.block_count) * sizeof(BlockEntry);
+    std::string table(data, tableSize);
+    std::memset(table.data() + offsetof(BlockStreamHeader, table_checksum), 0, sizeof(h.table_checksum));
+    if (checksum(table.data(), table.size()) != h.table_checksum) return false;
+
+    std::vector<BlockEntry> entries(h.block_count);
+    std::memcpy(entries.data(), data + sizeof(h), entries.size() * sizeof(BlockEntry));
+    // Each block's position in the file and in the output are prefix sums.
+    std::vector<uint64_t> stored(entries.size() + 1, sizeof(h) + entries.size() * sizeof(BlockEntry));
+    std::vector<uint64_t> unpacked(entries.size() + 1, 0);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].raw_size > h.block_size) return false;
+        stored[i + 1] = stored[i] + entries[i].stored_size;
+        unpacked[i + 1] = unpacked[i] + entries[i].raw_size;
+    }
+    if (stored.back() != size || unpacked.back() != h.raw_size) return false;
+
+    raw.resize(static_cast<size_t>(h.raw_size));
+    std::atomic<bool> ok(true);
+    forBlocks(entries.size(), threads, [&](size_t i) {
+        const char* src = data + stored[i];
+        char* dst = raw.data() + unpacked[i];
+        if (checksum(src, entries[i].stored_size) != entries[i].checksum) ok = false;
+        else if (entries[i].stored_size == entries[i].raw_size) std::memcpy(dst, src, entries[i].raw_size);
+        else if (!decompress(src, entries[i].stored_size, dst, entries[i].raw_size)) ok = false;
+    });
+    if (!ok) raw.clear();
+    return ok;
+}
+
+}
@@ -0,0 +1,56 @@
+#ifndef BLOCKCODEC_H
+#define BLOCKCODEC_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// Byte-oriented LZ77 compression over independent blocks. A block is a
+// run of sequences, each a token byte (literal count << 4 | match length - 4,
+// 15 in a nibble means more length bytes follow, 255 per byte), the
+// literals and, except after the last one, a 16-bit little-endian back
+// offset and the extra match length bytes. Blocks never reference each
+// other, so a stream of them can be packed and unpacked on many threads.
+namespace BlockCodec {
+
+const size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+// Appends the compressed form of 'in' to 'out'.
+void compress(std::string_view in, std::string& out);
+// Decodes exactly 'rawSize' bytes into dst; false on corrupt input.
+bool decompress(const char* src, size_t srcSize, char* dst, size_t rawSize);
+
+// Block stream: BlockStreamHeader | BlockEntry[block_count] | payloads.
+// A payload whose stored size equals its raw size is kept uncompressed.
+// Each entry carries the checksum of its stored payload, and the header
+// one of itself (with that field zero) and the entry table, so damage is
+// caught before anything is decoded.
+const char STREAM_MAGIC[4] = { 'L', 'B', 'L', 'K' };
+
+struct BlockStreamHeader {
+    char magic[4];
+    uint32_t block_size;
+    uint64_t raw_size;
+    uint32_t block_count;
+    uint32_t table_checksum;
+};
+
+struct BlockEntry {
+    uint32_t raw_size;
+    uint32_t stored_size;
+    uint32_t checksum;
+};
+
+static_assert(sizeof(BlockStreamHeader) == 24, "block stream header layout");
+static_assert(sizeof(BlockEntry) == 12, "block entry layout");
+
+// Splits 'raw' into blocks and compresses them on up to 'threads' threads
+// (0 = hardware concurrency); the stream is appended to 'out'.
+void packStream(std::string_view raw, std::string& out, size_t blockSize = DEFAULT_BLOCK_SIZE, size_t threads = 0);
+// Inverse of packStream; blocks are decoded in parallel into 'raw'.
+bool unpackStream(const char* data, size_t size, std::string& raw, size_t threads = 0);
+
+}
+
+#endif // BLOCKCODEC_H
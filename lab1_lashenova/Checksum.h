@@ -0,0 +1,18 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstdint>
+#include <cstddef>
+
+// 32-bit FNV-1a over a byte range; guards journal entries and packed
+// blocks against torn writes and flipped bytes.
+inline uint32_t checksum(const char* data, size_t size) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+#endif // CHECKSUM_H
@@ -0,0 +1,99 @@
+#include "ClassRegistry.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// Names live in blocks of doubling size (64, 128, 256, ...) that are never
+// moved or freed, so a name's address is fixed once it is interned. Writers
+// take the lock; name() only reads 'count' and the block table, which are
+// filled in before 'count' is raised.
+const unsigned FIRST_BLOCK_BITS = 6;
+const unsigned BLOCKS = 26;
+
+struct Registry {
+    std::mutex lock;
+    std::atomic<std::string*> blocks[BLOCKS];
+    std::atomic<size_t> count;
+    std::unordered_map<std::string_view, ClassId> handles;
+
+    Registry() : count(0) {
+        for (std::atomic<std::string*>& b : blocks) b.store(nullptr, std::memory_order_relaxed);
+        append(std::string_view());
+    }
+    ~Registry() {
+        for (unsigned k = 0; k < BLOCKS; ++k) delete[] blocks[k].load(std::memory_order_relaxed);
+    }
+
+    static void locate(size_t id, unsigned& block, size_t& offset) {
+        size_t i = id + (size_t(1) << FIRST_BLOCK_BITS);
+        unsigned top = 0;
+        while (i >> (top + 1)) ++top;
+        block = top - FIRST_BLOCK_BITS;
+        offset = i - (size_t(1) << top);
+    }
+
+    std::string& at(size_t id) const {
+        unsigned block;
+        size_t offset;
+        locate(id, block, offset);
+        return blocks[block].load(std::memory_order_acquire)[offset];
+    }
+
+    // Caller holds the lock (or is the constructor).
+    ClassId append(std::string_view name) {
+        size_t id = count.load(std::memory_order_relaxed);
+        unsigned block;
+        size_t offset;
+        locate(id, block, offset);
+        if (!blocks[block].load(std::memory_order_relaxed)) {
+            blocks[block].store(new std::string[size_t(1) << (block + FIRST_BLOCK_BITS)], std::memory_order_release);
+        }
+        std::string& slot = at(id);
+        slot.assign(name);
+        handles.emplace(std::string_view(slot), static_cast<ClassId>(id));
+        count.store(id + 1, std::memory_order_release);
+        return static_cast<ClassId>(id);
+    }
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+}
+
+ClassId ClassRegistry::intern(std::string_view name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    auto it = r.handles.find(name);
+    if (it != r.handles.end()) return it->second;
+    return r.append(name);
+}
+
+bool ClassRegistry::find(std::string_view name, ClassId& id) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    auto it = r.handles.find(name);
+    if (it == r.handles.end()) return false;
+    id = it->second;
+    return true;
+}
+
+const std::string& ClassRegistry::name(ClassId id) {
+    const Registry& r = registry();
+    return r.at(id < r.count.load(std::memory_order_acquire) ? id : NONE);
+}
+
+size_t ClassRegistry::size() {
+    return registry().count.load(std::memory_order_acquire);
+}
+
+ClassId ClassResolver::operator()(std::string_view name) {
+    auto it = seen.find(name);
+    if (it != seen.end()) return it->second;
+    return seen.emplace(name, ClassRegistry::intern(name)).first->second;
+}
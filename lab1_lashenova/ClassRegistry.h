@@ -0,0 +1,38 @@
+#ifndef CLASSREGISTRY_H
+#define CLASSREGISTRY_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+typedef uint32_t ClassId;
+
+// Process-wide intern table for station classifications. Handles are dense,
+// never reused and stay valid for the lifetime of the program; handle 0 is
+// the empty classification. Safe to use from several threads; name() and
+// size() do not lock, so printing and saving can call them per row.
+class ClassRegistry {
+public:
+    static constexpr ClassId NONE = 0;
+
+    static ClassId intern(std::string_view name);
+    // Handle of an already interned name; false if it was never seen.
+    static bool find(std::string_view name, ClassId& id);
+    static const std::string& name(ClassId id);
+    static size_t size();
+};
+
+// Memo in front of intern() for bulk loads: each distinct name takes the
+// registry lock once instead of once per row. One thread; the viewed
+// names must outlive the resolver.
+class ClassResolver {
+private:
+    std::unordered_map<std::string_view, ClassId> seen;
+
+public:
+    ClassId operator()(std::string_view name);
+};
+
+#endif // CLASSREGISTRY_H
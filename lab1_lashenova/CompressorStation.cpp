@@ -3,10 +3,14 @@
 #include <limits>
 
 CompressorStation::CompressorStation() 
-    : id(0), name(""), total_workshops(0), working_workshops(0), classification() {
+    : id(0), name(""), total_workshops(0), working_workshops(0), classification(ClassRegistry::NONE) {
 }
 
 CompressorStation::CompressorStation(int id_, const std::string& name_, int total_, int working_, const std::string& classification_)
+    : id(id_), name(name_), total_workshops(total_), working_workshops(working_), classification(ClassRegistry::intern(classification_)) {
+}
+
+CompressorStation::CompressorStation(int id_, const std::string& name_, int total_, int working_, ClassId classification_)
     : id(id_), name(name_), total_workshops(total_), working_workshops(working_), classification(classification_) {
 }
 
@@ -14,7 +18,8 @@ int CompressorStation::getId() const { return id; }
 std::string CompressorStation::getName() const { return name; }
 int CompressorStation::getTotalWorkshops() const { return total_workshops; }
 int CompressorStation::getWorkingWorkshops() const { return working_workshops; }
-std:: string CompressorStation::getClassification() const { return classification; }
+const std::string& CompressorStation::getClassification() const { return ClassRegistry::name(classification); }
+ClassId CompressorStation::getClassId() const { return classification; }
 
 void CompressorStation::setTotalWorkshops(int t) { total_workshops = t; }
 void CompressorStation::setWorkingWorkshops(int w) { working_workshops = w; }
@@ -31,7 +36,7 @@ std::ostream& operator<<(std::ostream& os, const CompressorStation& cs) {
         << " | Total=" << cs.total_workshops
         << " | Working=" << cs.working_workshops
         << " | Idle%=" << cs.percentIdle()  
-        << " | Class=\"" << cs.classification << "\"";
+        << " | Class=\"" << cs.getClassification() << "\"";
     return os;
 }
 
@@ -45,6 +50,8 @@ std::istream& operator>>(std::istream& is, CompressorStation& cs) {
 
     is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     std::cout << "Enter classification: ";
-    std::getline(is, cs.classification);
+    std::string classification;
+    std::getline(is, classification);
+    cs.classification = ClassRegistry::intern(classification);
     return is;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <iostream>
+#include "ClassRegistry.h"
 
 class CompressorStation {
 private:
@@ -10,17 +11,19 @@ private:
     std::string name;
     int total_workshops;
     int working_workshops;
-    std::string classification;
+    ClassId classification;
 
 public:
     CompressorStation();
     CompressorStation(int id_, const std::string& name_, int total_, int working_, const std::string& classification_);
+    CompressorStation(int id_, const std::string& name_, int total_, int working_, ClassId classification_);
 
     int getId() const;
     std::string getName() const;
     int getTotalWorkshops() const;
     int getWorkingWorkshops() const;
-    std::string getClassification() const;
+    const std::string& getClassification() const;
+    ClassId getClassId() const;
 
     void setTotalWorkshops(int t);
     void setWorkingWorkshops(int w);
@@ -0,0 +1,169 @@
+#include "ConcurrentManager.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+ConcurrentManager::ConcurrentManager(size_t shardCount) : next_pipe_id(1), next_station_id(1) {
+    if (shardCount == 0) shardCount = std::max(1u, std::thread::hardware_concurrency());
+    shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) shards.emplace_back(new Shard());
+}
+
+template <typename Query>
+IdList ConcurrentManager::collect(Query query) const {
+    IdList result;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> guard(shard->lock);
+        IdList part = query(shard->manager);
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template <typename Edit>
+void ConcurrentManager::forEachShard(const std::vector<int>& ids, Edit edit) {
+    std::vector<std::vector<int>> parts(shards.size());
+    for (int id : ids) parts[static_cast<unsigned>(id) % shards.size()].push_back(id);
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (parts[i].empty()) continue;
+        std::unique_lock<std::shared_mutex> guard(shards[i]->lock);
+        edit(shards[i]->manager, parts[i]);
+    }
+}
+
+int ConcurrentManager::addPipe(const std::string& name, double diameter, bool in_repair) {
+    int id = next_pipe_id.fetch_add(1);
+    Shard& shard = shardOf(id);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    shard.manager.applyAddPipe(id, name, diameter, in_repair);
+    return id;
+}
+
+bool ConcurrentManager::removePipeById(int id) {
+    Shard& shard = shardOf(id);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    return shard.manager.removePipeById(id);
+}
+
+bool ConcurrentManager::setPipeInRepair(int id, bool in_repair) {
+    Shard& shard = shardOf(id);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    return shard.manager.setPipeInRepair(id, in_repair);
+}
+
+std::optional<Pipe> ConcurrentManager::getPipeById(int id) const {
+    Shard& shard = shardOf(id);
+    std::shared_lock<std::shared_mutex> guard(shard.lock);
+    return shard.manager.getPipeById(id);
+}
+
+IdList ConcurrentManager::findPipeIdsByName(const std::string& substring) const {
+    return collect([&](Manager& m) { return m.findPipeIdsByName(substring); });
+}
+
+IdList ConcurrentManager::findPipeIdsByRepairFlag(bool in_repair) const {
+    return collect([&](Manager& m) { return m.findPipeIdsByRepairFlag(in_repair); });
+}
+
+size_t ConcurrentManager::getPipeCount() const {
+    size_t count = 0;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> guard(shard->lock);
+        count += shard->manager.getPipeCount();
+    }
+    return count;
+}
+
+int ConcurrentManager::addStation(const std::string& name, int total, int working, const std::string& classification) {
+    int id = next_station_id.fetch_add(1);
+    Shard& shard = shardOf(id);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    shard.manager.applyAddStation(id, name, total, working, ClassRegistry::intern(classification));
+    return id;
+}
+
+bool ConcurrentManager::removeStationById(int id) {
+    Shard& shard = shardOf(id);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    return shard.manager.removeStationById(id);
+}
+
+bool ConcurrentManager::setStationWorking(int id, int working) {
+    Shard& shard = shardOf(id);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    return shard.manager.setStationWorking(id, working);
+}
+
+std::optional<CompressorStation> ConcurrentManager::getStationById(int id) const {
+    Shard& shard = shardOf(id);
+    std::shared_lock<std::shared_mutex> guard(shard.lock);
+    return shard.manager.getStationById(id);
+}
+
+IdList ConcurrentManager::findStationIdsByName(const std::string& substring) const {
+    return collect([&](Manager& m) { return m.findStationIdsByName(substring); });
+}
+
+IdList ConcurrentManager::findStationIdsByClass(const std::string& classification) const {
+    return collect([&](Manager& m) { return m.findStationIdsByClass(classification); });
+}
+
+IdList ConcurrentManager::findStationIdsByIdlePercent(double minIdlePercent) const {
+    return collect([&](Manager& m) { return m.findStationIdsByIdlePercent(minIdlePercent); });
+}
+
+size_t ConcurrentManager::getStationCount() const {
+    size_t count = 0;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> guard(shard->lock);
+        count += shard->manager.getStationCount();
+    }
+    return count;
+}
+
+NetworkStats ConcurrentManager::getStats() const {
+    NetworkStats total;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> guard(shard->lock);
+        total.merge(shard->manager.getStats());
+    }
+    return total;
+}
+
+void ConcurrentManager::batchEditPipes(const std::vector<int>& ids, int changeRepairFlag) {
+    forEachShard(ids, [&](Manager& m, const std::vector<int>& part) { m.batchEditPipes(part, changeRepairFlag); });
+}
+
+void ConcurrentManager::batchEditStations(const std::vector<int>& ids, int workingStationsFlag) {
+    forEachShard(ids, [&](Manager& m, const std::vector<int>& part) { m.batchEditStations(part, workingStationsFlag); });
+}
+
+void ConcurrentManager::importFrom(Manager& source) {
+    const PipeTable& pipes = source.getPipes();
+    const StationTable& stations = source.getStations();
+    int maxPipe = 0, maxStation = 0;
+
+    for (auto& shard : shards) {
+        std::unique_lock<std::shared_mutex> guard(shard->lock);
+        Manager& m = shard->manager;
+        for (size_t row = 0; row < pipes.size(); ++row) {
+            int id = pipes.idColumn()[row];
+            if (&shardOf(id) != shard.get()) continue;
+            m.applyAddPipe(id, pipes.nameColumn()[row], pipes.diameterColumn()[row], pipes.repairColumn()[row] != 0);
+            maxPipe = std::max(maxPipe, id);
+        }
+        for (size_t row = 0; row < stations.size(); ++row) {
+            int id = stations.idColumn()[row];
+            if (&shardOf(id) != shard.get()) continue;
+            m.applyAddStation(id, stations.nameColumn()[row], stations.totalColumn()[row],
+                stations.workingColumn()[row], stations.classColumn()[row]);
+            maxStation = std::max(maxStation, id);
+        }
+    }
+
+    int expected = next_pipe_id.load();
+    while (expected <= maxPipe && !next_pipe_id.compare_exchange_weak(expected, maxPipe + 1)) {}
+    expected = next_station_id.load();
+    while (expected <= maxStation && !next_station_id.compare_exchange_weak(expected, maxStation + 1)) {}
+}
@@ -0,0 +1,74 @@
+#ifndef CONCURRENTMANAGER_H
+#define CONCURRENTMANAGER_H
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "Manager.h"
+
+// Thread-safe front for many concurrent readers and occasional writers.
+// Records are spread over shards by id (id % shard count); every shard is a
+// plain Manager behind its own reader/writer lock. Queries take shared locks
+// one shard at a time, so they only wait for writers touching the same
+// shard. A query or batch that spans shards is consistent per shard, not as
+// a whole.
+class ConcurrentManager {
+private:
+    struct Shard {
+        mutable std::shared_mutex lock;
+        Manager manager;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<int> next_pipe_id;
+    std::atomic<int> next_station_id;
+
+    Shard& shardOf(int id) const { return *shards[static_cast<unsigned>(id) % shards.size()]; }
+    // Runs query on every shard under a shared lock and merges the sorted
+    // results. Shards are never opened lazily, so their queries only read.
+    template <typename Query>
+    IdList collect(Query query) const;
+    // Splits ids by shard; edit(manager, part) runs under the shard's exclusive lock.
+    template <typename Edit>
+    void forEachShard(const std::vector<int>& ids, Edit edit);
+
+public:
+    // 0 picks one shard per hardware thread.
+    explicit ConcurrentManager(size_t shardCount = 0);
+    ConcurrentManager(const ConcurrentManager&) = delete;
+    ConcurrentManager& operator=(const ConcurrentManager&) = delete;
+
+    size_t shardCount() const { return shards.size(); }
+
+    int addPipe(const std::string& name, double diameter, bool in_repair);
+    bool removePipeById(int id);
+    bool setPipeInRepair(int id, bool in_repair);
+    std::optional<Pipe> getPipeById(int id) const;
+    IdList findPipeIdsByName(const std::string& substring) const;
+    IdList findPipeIdsByRepairFlag(bool in_repair) const;
+    size_t getPipeCount() const;
+
+    int addStation(const std::string& name, int total, int working, const std::string& classification);
+    bool removeStationById(int id);
+    bool setStationWorking(int id, int working);
+    std::optional<CompressorStation> getStationById(int id) const;
+    IdList findStationIdsByName(const std::string& substring) const;
+    IdList findStationIdsByClass(const std::string& classification) const;
+    IdList findStationIdsByIdlePercent(double minIdlePercent) const;
+    size_t getStationCount() const;
+    // Sum of the shards' statistics, each read under its shared lock.
+    NetworkStats getStats() const;
+
+    void batchEditPipes(const std::vector<int>& ids, int changeRepairFlag);
+    void batchEditStations(const std::vector<int>& ids, int workingStationsFlag);
+
+    // Copies every record of source, keeping ids; a lazily opened source
+    // is read in full first. Pipe connections are not imported: a pipe and
+    // its stations usually land in different shards, and there are no
+    // network queries here, so imported pipes are unconnected.
+    void importFrom(Manager& source);
+};
+
+#endif // CONCURRENTMANAGER_H
@@ -0,0 +1,312 @@
+#include "FilterKernels.h"
+#include <algorithm>
+#include <bit>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FILTER_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(FILTER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+namespace filter {
+
+namespace {
+
+Isa detectIsa() {
+#if defined(FILTER_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? Isa::AVX2 : Isa::SSE2;
+#elif defined(FILTER_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return Isa::SSE2;
+    __cpuid(info, 1);
+    bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osAvx && (info[1] & (1 << 5)) ? Isa::AVX2 : Isa::SSE2;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+const Isa DETECTED = detectIsa();
+Isa current = DETECTED;
+
+template <typename F>
+void withOp(query::CmpOp op, F f) {
+    switch (op) {
+    case query::LT: f(std::integral_constant<query::CmpOp, query::LT>()); break;
+    case query::LE: f(std::integral_constant<query::CmpOp, query::LE>()); break;
+    case query::GT: f(std::integral_constant<query::CmpOp, query::GT>()); break;
+    case query::GE: f(std::integral_constant<query::CmpOp, query::GE>()); break;
+    case query::EQ: f(std::integral_constant<query::CmpOp, query::EQ>()); break;
+    case query::NE: f(std::integral_constant<query::CmpOp, query::NE>()); break;
+    }
+}
+
+// Scalar variants handle any row count, so they also finish the tail word.
+
+void repairScalar(const uint8_t* repair, size_t n, uint8_t wanted, uint64_t* out) {
+    for (size_t w = 0; w * 64 < n; ++w) {
+        size_t count = std::min<size_t>(64, n - w * 64);
+        uint64_t bits = 0;
+        for (size_t i = 0; i < count; ++i) bits |= static_cast<uint64_t>(repair[w * 64 + i] == wanted) << i;
+        out[w] = bits;
+    }
+}
+
+template <query::CmpOp OP>
+void doublesScalar(const double* values, size_t n, double x, uint64_t* out) {
+    for (size_t w = 0; w * 64 < n; ++w) {
+        size_t count = std::min<size_t>(64, n - w * 64);
+        uint64_t bits = 0;
+        for (size_t i = 0; i < count; ++i) bits |= static_cast<uint64_t>(query::compare(values[w * 64 + i], OP, x)) << i;
+        out[w] = bits;
+    }
+}
+
+// Idle test from the ">=" and "<=" bits of idle * den vs num * total, plus
+// the rows with total > 0; the others count as 0% and get 'zero'.
+uint64_t combineIdle(query::CmpOp op, uint64_t ge, uint64_t le, uint64_t positive, uint64_t zero) {
+    uint64_t bits = 0;
+    switch (op) {
+    case query::LT: bits = ~ge; break;
+    case query::LE: bits = le; break;
+    case query::GT: bits = ~le; break;
+    case query::GE: bits = ge; break;
+    case query::EQ: bits = ge & le; break;
+    case query::NE: bits = ~(ge & le); break;
+    }
+    return (bits & positive) | (zero & ~positive);
+}
+
+void idleScalar(const int32_t* total, const int32_t* working, size_t n, double num, double den,
+    query::CmpOp op, bool zeroMatches, uint64_t* out) {
+    for (size_t w = 0; w * 64 < n; ++w) {
+        size_t count = std::min<size_t>(64, n - w * 64);
+        uint64_t ge = 0, le = 0, positive = 0;
+        for (size_t i = 0; i < count; ++i) {
+            double t = total[w * 64 + i];
+            double lhs = (t - working[w * 64 + i]) * den, rhs = num * t;
+            ge |= static_cast<uint64_t>(lhs >= rhs) << i;
+            le |= static_cast<uint64_t>(lhs <= rhs) << i;
+            positive |= static_cast<uint64_t>(t > 0) << i;
+        }
+        uint64_t valid = count == 64 ? ~0ull : (1ull << count) - 1;
+        out[w] = combineIdle(op, ge, le, positive, zeroMatches ? ~0ull : 0) & valid;
+    }
+}
+
+#ifdef FILTER_X86
+
+void repairSse2(const uint8_t* repair, size_t words, uint8_t wanted, uint64_t* out) {
+    const __m128i key = _mm_set1_epi8(static_cast<char>(wanted));
+    for (size_t w = 0; w < words; ++w) {
+        const uint8_t* p = repair + w * 64;
+        uint64_t bits = 0;
+        for (int i = 0; i < 64; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            bits |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, key)))) << i;
+        }
+        out[w] = bits;
+    }
+}
+
+AVX2_TARGET void repairAvx2(const uint8_t* repair, size_t words, uint8_t wanted, uint64_t* out) {
+    const __m256i key = _mm256_set1_epi8(static_cast<char>(wanted));
+    for (size_t w = 0; w < words; ++w) {
+        const uint8_t* p = repair + w * 64;
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+        uint64_t l = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, key)));
+        uint64_t h = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, key)));
+        out[w] = l | (h << 32);
+    }
+}
+
+template <query::CmpOp OP>
+inline __m128d cmpSse2(__m128d a, __m128d b) {
+    if constexpr (OP == query::LT) return _mm_cmplt_pd(a, b);
+    else if constexpr (OP == query::LE) return _mm_cmple_pd(a, b);
+    else if constexpr (OP == query::GT) return _mm_cmpgt_pd(a, b);
+    else if constexpr (OP == query::GE) return _mm_cmpge_pd(a, b);
+    else if constexpr (OP == query::EQ) return _mm_cmpeq_pd(a, b);
+    else return _mm_cmpneq_pd(a, b);
+}
+
+template <query::CmpOp OP>
+void doublesSse2(const double* values, size_t words, double x, uint64_t* out) {
+    const __m128d key = _mm_set1_pd(x);
+    for (size_t w = 0; w < words; ++w) {
+        const double* p = values + w * 64;
+        uint64_t bits = 0;
+        for (int i = 0; i < 64; i += 2) {
+            bits |= static_cast<uint64_t>(_mm_movemask_pd(cmpSse2<OP>(_mm_loadu_pd(p + i), key))) << i;
+        }
+        out[w] = bits;
+    }
+}
+
+template <query::CmpOp OP>
+AVX2_TARGET inline __m256d cmpAvx2(__m256d a, __m256d b) {
+    if constexpr (OP == query::LT) return _mm256_cmp_pd(a, b, _CMP_LT_OQ);
+    else if constexpr (OP == query::LE) return _mm256_cmp_pd(a, b, _CMP_LE_OQ);
+    else if constexpr (OP == query::GT) return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+    else if constexpr (OP == query::GE) return _mm256_cmp_pd(a, b, _CMP_GE_OQ);
+    else if constexpr (OP == query::EQ) return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);
+    else return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ);
+}
+
+template <query::CmpOp OP>
+AVX2_TARGET void doublesAvx2(const double* values, size_t words, double x, uint64_t* out) {
+    const __m256d key = _mm256_set1_pd(x);
+    for (size_t w = 0; w < words; ++w) {
+        const double* p = values + w * 64;
+        uint64_t bits = 0;
+        for (int i = 0; i < 64; i += 8) {
+            uint64_t a = static_cast<uint64_t>(_mm256_movemask_pd(cmpAvx2<OP>(_mm256_loadu_pd(p + i), key)));
+            uint64_t b = static_cast<uint64_t>(_mm256_movemask_pd(cmpAvx2<OP>(_mm256_loadu_pd(p + i + 4), key)));
+            bits |= (a | (b << 4)) << i;
+        }
+        out[w] = bits;
+    }
+}
+
+// Two int32 lanes at a time are widened to double; products stay below
+// 2^53, so the comparison is exact.
+void idleSse2(const int32_t* total, const int32_t* working, size_t words, double num, double den,
+    query::CmpOp op, bool zeroMatches, uint64_t* out) {
+    const __m128d vnum = _mm_set1_pd(num), vden = _mm_set1_pd(den), zero = _mm_setzero_pd();
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t ge = 0, le = 0, positive = 0;
+        for (int i = 0; i < 64; i += 4) {
+            __m128i t4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(total + w * 64 + i));
+            __m128i w4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(working + w * 64 + i));
+            for (int half = 0; half < 2; ++half) {
+                __m128d t = _mm_cvtepi32_pd(half ? _mm_shuffle_epi32(t4, 0xEE) : t4);
+                __m128d k = _mm_cvtepi32_pd(half ? _mm_shuffle_epi32(w4, 0xEE) : w4);
+                __m128d lhs = _mm_mul_pd(_mm_sub_pd(t, k), vden), rhs = _mm_mul_pd(vnum, t);
+                int shift = i + 2 * half;
+                ge |= static_cast<uint64_t>(_mm_movemask_pd(_mm_cmpge_pd(lhs, rhs))) << shift;
+                le |= static_cast<uint64_t>(_mm_movemask_pd(_mm_cmple_pd(lhs, rhs))) << shift;
+                positive |= static_cast<uint64_t>(_mm_movemask_pd(_mm_cmpgt_pd(t, zero))) << shift;
+            }
+        }
+        out[w] = combineIdle(op, ge, le, positive, zeroMatches ? ~0ull : 0);
+    }
+}
+
+AVX2_TARGET void idleAvx2(const int32_t* total, const int32_t* working, size_t words, double num, double den,
+    query::CmpOp op, bool zeroMatches, uint64_t* out) {
+    const __m256d vnum = _mm256_set1_pd(num), vden = _mm256_set1_pd(den), zero = _mm256_setzero_pd();
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t ge = 0, le = 0, positive = 0;
+        for (int i = 0; i < 64; i += 4) {
+            __m256d t = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(total + w * 64 + i)));
+            __m256d k = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(working + w * 64 + i)));
+            __m256d lhs = _mm256_mul_pd(_mm256_sub_pd(t, k), vden), rhs = _mm256_mul_pd(vnum, t);
+            ge |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, _CMP_GE_OQ))) << i;
+            le |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, _CMP_LE_OQ))) << i;
+            positive |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(t, zero, _CMP_GT_OQ))) << i;
+        }
+        out[w] = combineIdle(op, ge, le, positive, zeroMatches ? ~0ull : 0);
+    }
+}
+
+#endif
+
+}
+
+Isa activeIsa() { return current; }
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar: return "scalar";
+    case Isa::SSE2: return "sse2";
+    case Isa::AVX2: return "avx2";
+    }
+    return "?";
+}
+
+Isa setIsa(Isa isa) {
+    current = std::min(isa, DETECTED);
+    return current;
+}
+
+void repairEquals(const uint8_t* repair, size_t n, bool in_repair, uint64_t* out) {
+    uint8_t wanted = in_repair ? 1 : 0;
+    size_t full = n / 64;
+#ifdef FILTER_X86
+    if (current == Isa::AVX2) repairAvx2(repair, full, wanted, out);
+    else if (current == Isa::SSE2) repairSse2(repair, full, wanted, out);
+    else full = 0;
+#else
+    full = 0;
+#endif
+    repairScalar(repair + full * 64, n - full * 64, wanted, out + full);
+}
+
+void compareDoubles(const double* values, size_t n, query::CmpOp op, double x, uint64_t* out) {
+    withOp(op, [&](auto tag) {
+        constexpr query::CmpOp OP = decltype(tag)::value;
+        size_t full = n / 64;
+#ifdef FILTER_X86
+        if (current == Isa::AVX2) doublesAvx2<OP>(values, full, x, out);
+        else if (current == Isa::SSE2) doublesSse2<OP>(values, full, x, out);
+        else full = 0;
+#else
+        full = 0;
+#endif
+        doublesScalar<OP>(values + full * 64, n - full * 64, x, out + full);
+    });
+}
+
+void compareIdle(const int32_t* total, const int32_t* working, size_t n, query::CmpOp op, double percent,
+    uint64_t* out) {
+    bool zeroMatches = query::compare(0.0, op, percent);
+    double num, den;
+    query::idleRatio(percent, num, den);
+    size_t full = n / 64;
+#ifdef FILTER_X86
+    if (current == Isa::AVX2) idleAvx2(total, working, full, num, den, op, zeroMatches, out);
+    else if (current == Isa::SSE2) idleSse2(total, working, full, num, den, op, zeroMatches, out);
+    else full = 0;
+#else
+    full = 0;
+#endif
+    idleScalar(total + full * 64, working + full * 64, n - full * 64, num, den, op, zeroMatches, out + full);
+}
+
+void andInto(uint64_t* dst, const uint64_t* src, size_t words) {
+    for (size_t i = 0; i < words; ++i) dst[i] &= src[i];
+}
+
+size_t countBits(const uint64_t* bits, size_t words) {
+    size_t count = 0;
+    for (size_t i = 0; i < words; ++i) {
+        count += static_cast<size_t>(std::popcount(bits[i]));
+    }
+    return count;
+}
+
+std::vector<int> selectIds(const uint64_t* bits, const std::vector<int>& ids) {
+    std::vector<int> result;
+    result.reserve(countBits(bits, wordCount(ids.size())));
+    for (size_t w = 0; w < wordCount(ids.size()); ++w) {
+        uint64_t v = bits[w];
+        for (; v; v &= v - 1) result.push_back(ids[w * 64 + std::countr_zero(v)]);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+}
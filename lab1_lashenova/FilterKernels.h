@@ -0,0 +1,43 @@
+#ifndef FILTERKERNELS_H
+#define FILTERKERNELS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Query.h"
+
+// Vectorized column filters. Each kernel reads a contiguous column and
+// writes a selection bitmap: bit (row % 64) of word (row / 64) is set when
+// the row matches; bits past the last row stay zero. The SSE2 / AVX2 / scalar
+// variant is picked once at startup from the CPU.
+namespace filter {
+
+typedef std::vector<uint64_t> Bitmap;
+
+enum class Isa { Scalar, SSE2, AVX2 };
+
+Isa activeIsa();
+const char* isaName(Isa isa);
+// Restricts kernels to the given instruction set (clamped to what the CPU
+// supports); used to compare variants. Returns the set actually used.
+Isa setIsa(Isa isa);
+
+inline size_t wordCount(size_t rows) { return (rows + 63) / 64; }
+
+// repair[row] == in_repair (stored as 0/1).
+void repairEquals(const uint8_t* repair, size_t n, bool in_repair, uint64_t* out);
+// values[row] <op> x, with the same NaN behaviour as the scalar comparison.
+void compareDoubles(const double* values, size_t n, query::CmpOp op, double x, uint64_t* out);
+// idle% <op> percent with idle% = 100 * (total - working) / total, and 0 when
+// total <= 0; same cross-multiplied test as query::IdleIs (see idleRatio).
+void compareIdle(const int32_t* total, const int32_t* working, size_t n, query::CmpOp op, double percent,
+    uint64_t* out);
+
+void andInto(uint64_t* dst, const uint64_t* src, size_t words);
+size_t countBits(const uint64_t* bits, size_t words);
+// ids[row] for every set bit, ascending.
+std::vector<int> selectIds(const uint64_t* bits, const std::vector<int>& ids);
+
+}
+
+#endif // FILTERKERNELS_H
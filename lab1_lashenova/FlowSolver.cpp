@@ -0,0 +1,255 @@
+#include "FlowSolver.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace {
+
+const int64_t UNLIMITED = std::numeric_limits<int64_t>::max();
+// Below these sizes a BFS level is expanded on the calling thread.
+const size_t PARALLEL_ARCS = 1 << 18;
+const size_t PARALLEL_FRONTIER = 1 << 13;
+
+}
+
+FlowSolver::FlowSolver() : built(false), solved(false), source(0), sink(0), value(0), threads(0) {
+    setThreads(0);
+}
+
+int64_t FlowSolver::capacityFor(double diameter) {
+    if (!(diameter > 0)) return 0;
+    return std::llround(std::pow(diameter / 100.0, 2.5) * 100.0);
+}
+
+void FlowSolver::setThreads(size_t n) {
+    threads = n ? n : std::max(1u, std::thread::hardware_concurrency());
+}
+
+void FlowSolver::build(const Network& network, const PipeTable& pipes) {
+    size_t n = network.nodeCount();
+    first.assign(n + 1, 0);
+    network.forEachPipe([&](uint32_t from, uint32_t to, int) {
+        ++first[from + 1];
+        ++first[to + 1];
+    });
+    for (size_t i = 0; i < n; ++i) first[i + 1] += first[i];
+
+    size_t arcs = first[n];
+    head.resize(arcs);
+    mate.resize(arcs);
+    capacity.assign(arcs, 0);
+    pipe_of.resize(arcs);
+    arc_of.clear();
+    arc_of.reserve(arcs / 2);
+    std::vector<uint32_t> pos(first.begin(), first.end() - 1);
+    network.forEachPipe([&](uint32_t from, uint32_t to, int pipe) {
+        uint32_t fwd = pos[from]++, rev = pos[to]++;
+        head[fwd] = to;
+        head[rev] = from;
+        mate[fwd] = rev;
+        mate[rev] = fwd;
+        pipe_of[fwd] = pipe_of[rev] = pipe;
+        ptrdiff_t row = pipes.rowOf(pipe);
+        if (row >= 0 && !pipes.repairColumn()[row]) capacity[fwd] = capacityFor(pipes.diameterColumn()[row]);
+        arc_of.emplace(pipe, fwd);
+    });
+    residual = capacity;
+    level.resize(n);
+    cursor.resize(n);
+    built = true;
+    solved = false;
+    value = 0;
+}
+
+void FlowSolver::reset() {
+    residual = capacity;
+    solved = false;
+    value = 0;
+}
+
+// Level-synchronous BFS. Large levels of large graphs are split between
+// threads, which claim nodes with a compare-and-swap on their level.
+bool FlowSolver::buildLevels(uint32_t s, uint32_t t) {
+    std::fill(level.begin(), level.end(), -1);
+    level[s] = 0;
+    frontier.assign(1, s);
+    std::vector<uint32_t> next;
+    bool parallel = threads > 1 && head.size() >= PARALLEL_ARCS;
+    for (int32_t depth = 0; !frontier.empty() && level[t] < 0; ++depth) {
+        next.clear();
+        if (parallel && frontier.size() >= PARALLEL_FRONTIER) {
+            expandParallel(next, depth);
+        } else {
+            for (uint32_t u : frontier) {
+                for (uint32_t a = first[u]; a < first[u + 1]; ++a) {
+                    uint32_t v = head[a];
+                    if (residual[a] > 0 && level[v] < 0) {
+                        level[v] = depth + 1;
+                        next.push_back(v);
+                    }
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+    return level[t] >= 0;
+}
+
+void FlowSolver::expandParallel(std::vector<uint32_t>& next, int32_t depth) {
+    size_t workers = std::min(threads, frontier.size() / (PARALLEL_FRONTIER / 4));
+    std::vector<std::vector<uint32_t>> found(workers);
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back([&, w]() {
+            size_t begin = frontier.size() * w / workers, end = frontier.size() * (w + 1) / workers;
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t u = frontier[i];
+                for (uint32_t a = first[u]; a < first[u + 1]; ++a) {
+                    if (residual[a] <= 0) continue;
+                    std::atomic_ref<int32_t> slot(level[head[a]]);
+                    int32_t unseen = -1;
+                    if (slot.load(std::memory_order_relaxed) < 0
+                        && slot.compare_exchange_strong(unseen, depth + 1, std::memory_order_relaxed)) {
+                        found[w].push_back(head[a]);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& t : pool) t.join();
+    for (const std::vector<uint32_t>& part : found) next.insert(next.end(), part.begin(), part.end());
+}
+
+// Iterative DFS along the level graph with per-node arc cursors, so long
+// pipelines do not recurse.
+int64_t FlowSolver::blockingFlow(uint32_t s, uint32_t t, int64_t limit) {
+    for (size_t u = 0; u + 1 < first.size(); ++u) cursor[u] = first[u];
+    int64_t total = 0;
+    path.clear();
+    uint32_t u = s;
+    while (total < limit) {
+        if (u == t) {
+            int64_t push = limit - total;
+            for (uint32_t a : path) push = std::min(push, residual[a]);
+            size_t cut = path.size();
+            for (size_t i = 0; i < path.size(); ++i) {
+                residual[path[i]] -= push;
+                residual[mate[path[i]]] += push;
+                if (residual[path[i]] == 0 && cut == path.size()) cut = i;
+            }
+            total += push;
+            // Retreat to the tail of the first saturated arc.
+            path.resize(cut);
+            u = cut == 0 ? s : head[path[cut - 1]];
+            continue;
+        }
+        uint32_t& a = cursor[u];
+        while (a < first[u + 1] && !(residual[a] > 0 && level[head[a]] == level[u] + 1)) ++a;
+        if (a < first[u + 1]) {
+            path.push_back(a);
+            u = head[a];
+            continue;
+        }
+        if (u == s) break;
+        level[u] = -1;
+        path.pop_back();
+        u = path.empty() ? s : head[path.back()];
+        ++cursor[u];
+    }
+    return total;
+}
+
+int64_t FlowSolver::augment(uint32_t s, uint32_t t, int64_t limit) {
+    int64_t total = 0;
+    if (s == t) return 0;
+    while (total < limit && buildLevels(s, t)) {
+        int64_t pushed = blockingFlow(s, t, limit - total);
+        if (pushed == 0) break;
+        total += pushed;
+    }
+    return total;
+}
+
+int64_t FlowSolver::netOutflow(uint32_t node) const {
+    int64_t out = 0;
+    for (uint32_t a = first[node]; a < first[node + 1]; ++a) {
+        // Forward arcs hold their flow in the mate, reverse arcs in themselves.
+        if (arc_of.at(pipe_of[a]) == a) out += residual[mate[a]];
+        else out -= residual[a];
+    }
+    return out;
+}
+
+int64_t FlowSolver::solve(uint32_t s, uint32_t t) {
+    residual = capacity;
+    source = s;
+    sink = t;
+    value = augment(s, t, UNLIMITED);
+    solved = true;
+    return value;
+}
+
+int64_t FlowSolver::update(const PipeTable& pipes, const std::vector<int>& changed) {
+    if (!built) return 0;
+    for (int pipe : changed) {
+        auto it = arc_of.find(pipe);
+        if (it == arc_of.end()) continue;
+        uint32_t fwd = it->second, rev = mate[fwd];
+        ptrdiff_t row = pipes.rowOf(pipe);
+        int64_t cap = row >= 0 && !pipes.repairColumn()[row] ? capacityFor(pipes.diameterColumn()[row]) : 0;
+        if (cap == capacity[fwd]) continue;
+        capacity[fwd] = cap;
+
+        int64_t flow = residual[rev];
+        if (!solved || flow <= cap) {
+            residual[fwd] = cap - (solved ? flow : 0);
+            continue;
+        }
+        // The tail now holds 'excess' units it cannot send; the head is
+        // short by the same amount.
+        int64_t excess = flow - cap;
+        residual[fwd] = 0;
+        residual[rev] = cap;
+        uint32_t u = tailOf(fwd), v = head[fwd];
+        int64_t rest = excess - augment(u, v, excess);
+        if (rest > 0) {
+            if (u != source && u != sink) augment(u, source, rest);
+            if (v != source && v != sink) augment(sink, v, rest);
+        }
+    }
+    if (!solved) return 0;
+    augment(source, sink, UNLIMITED);
+    value = netOutflow(source);
+    return value;
+}
+
+int64_t FlowSolver::flowOn(int pipe) const {
+    auto it = arc_of.find(pipe);
+    return solved && it != arc_of.end() ? residual[mate[it->second]] : 0;
+}
+
+std::vector<int> FlowSolver::minCut() const {
+    std::vector<int> cut;
+    if (!solved) return cut;
+    std::vector<uint8_t> reached(level.size(), 0);
+    std::vector<uint32_t> queue(1, source);
+    reached[source] = 1;
+    for (size_t i = 0; i < queue.size(); ++i) {
+        uint32_t u = queue[i];
+        for (uint32_t a = first[u]; a < first[u + 1]; ++a) {
+            if (residual[a] > 0 && !reached[head[a]]) {
+                reached[head[a]] = 1;
+                queue.push_back(head[a]);
+            }
+        }
+    }
+    for (uint32_t u : queue) {
+        for (uint32_t a = first[u]; a < first[u + 1]; ++a) {
+            if (capacity[a] > 0 && !reached[head[a]]) cut.push_back(pipe_of[a]);
+        }
+    }
+    std::sort(cut.begin(), cut.end());
+    return cut;
+}
@@ -0,0 +1,84 @@
+#ifndef FLOWSOLVER_H
+#define FLOWSOLVER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include "Network.h"
+#include "PipeTable.h"
+
+// Maximum gas throughput between two stations (Dinic's algorithm). Every
+// connected pipe is an arc of capacity capacityFor(diameter), 0 while the
+// pipe is in repair. The residual graph is a CSR copy of the Network taken
+// by build(); after solve() the flow stays in it, so update() can apply
+// repair flag changes by rerouting or cancelling only the affected flow and
+// then augmenting again, instead of solving from zero.
+class FlowSolver {
+private:
+    // Residual arcs grouped by tail node; arc a and mate[a] are the two
+    // directions of one pipe, only the forward one has capacity.
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> head;
+    std::vector<uint32_t> mate;
+    std::vector<int64_t> capacity;
+    std::vector<int64_t> residual;
+    std::vector<int> pipe_of;
+    std::unordered_map<int, uint32_t> arc_of;
+
+    bool built;
+    bool solved;
+    uint32_t source;
+    uint32_t sink;
+    int64_t value;
+    size_t threads;
+
+    std::vector<int32_t> level;
+    std::vector<uint32_t> cursor;
+    std::vector<uint32_t> path;
+    std::vector<uint32_t> frontier;
+
+    uint32_t tailOf(uint32_t arc) const { return head[mate[arc]]; }
+    // BFS levels from s over arcs with residual capacity; false if t is unreachable.
+    bool buildLevels(uint32_t s, uint32_t t);
+    void expandParallel(std::vector<uint32_t>& next, int32_t depth);
+    int64_t blockingFlow(uint32_t s, uint32_t t, int64_t limit);
+    // Pushes up to 'limit' units from s to t in the residual graph.
+    int64_t augment(uint32_t s, uint32_t t, int64_t limit);
+    int64_t netOutflow(uint32_t node) const;
+
+public:
+    FlowSolver();
+
+    // Throughput units of a pipe, proportional to diameter^2.5 (a 100 mm
+    // pipe carries 100 units).
+    static int64_t capacityFor(double diameter);
+
+    // Worker threads for the level BFS on large graphs (0 = hardware).
+    void setThreads(size_t n);
+    size_t getThreads() const { return threads; }
+
+    // Copies the topology and capacities; forgets any previous flow.
+    void build(const Network& network, const PipeTable& pipes);
+    bool isBuilt() const { return built; }
+    // Drops the current flow but keeps the graph.
+    void reset();
+
+    // Max flow between two nodes of the Network the solver was built from.
+    int64_t solve(uint32_t s, uint32_t t);
+    // Re-reads the capacity of the changed pipes. A solved flow is kept
+    // feasible and maximal: flow over a lost capacity is rerouted around
+    // the pipe or cancelled back to the source and sink, then the graph
+    // is augmented again. Returns the flow value (0 if unsolved).
+    int64_t update(const PipeTable& pipes, const std::vector<int>& changed);
+
+    bool isSolved() const { return solved; }
+    uint32_t getSource() const { return source; }
+    uint32_t getSink() const { return sink; }
+    int64_t flowValue() const { return solved ? value : 0; }
+    int64_t flowOn(int pipe) const;
+    // Saturated pipes separating the source side from the sink side, ascending.
+    std::vector<int> minCut() const;
+};
+
+#endif // FLOWSOLVER_H
@@ -0,0 +1,53 @@
+#include "IdleIndex.h"
+
+IdleIndex::Key IdleIndex::makeKey(int id, int total, int working) {
+    // Matches CompressorStation::percentIdle(): no workshops means 0% idle.
+    if (total <= 0) return Key{ 0, 1, id };
+    return Key{ static_cast<int64_t>(total) - working, total, id };
+}
+
+void IdleIndex::clear() {
+    keys.clear();
+}
+
+void IdleIndex::add(int id, int total, int working) {
+    keys.insert(makeKey(id, total, working));
+}
+
+void IdleIndex::remove(int id, int total, int working) {
+    keys.erase(makeKey(id, total, working));
+}
+
+void IdleIndex::update(int id, int total, int oldWorking, int newWorking) {
+    auto it = keys.find(makeKey(id, total, oldWorking));
+    if (it != keys.end()) keys.erase(it);
+    keys.insert(makeKey(id, total, newWorking));
+}
+
+void IdleIndex::rebuild(const std::vector<int>& ids, const std::vector<int32_t>& totals, const std::vector<int32_t>& workings) {
+    keys.clear();
+    for (size_t row = 0; row < ids.size(); ++row) {
+        keys.insert(makeKey(ids[row], totals[row], workings[row]));
+    }
+}
+
+std::vector<int> IdleIndex::range(double minPercent, double maxPercent) const {
+    std::vector<int> result;
+    if (minPercent > maxPercent) return result;
+    auto first = keys.lower_bound(Bound{ minPercent });
+    auto last = keys.upper_bound(Bound{ maxPercent });
+    for (auto it = first; it != last; ++it) result.push_back(it->id);
+    return result;
+}
+
+std::vector<int> IdleIndex::atLeast(double minPercent) const {
+    std::vector<int> result;
+    for (auto it = keys.lower_bound(Bound{ minPercent }); it != keys.end(); ++it) result.push_back(it->id);
+    return result;
+}
+
+std::vector<int> IdleIndex::top(size_t k) const {
+    std::vector<int> result;
+    for (auto it = keys.rbegin(); it != keys.rend() && result.size() < k; ++it) result.push_back(it->id);
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef IDLEINDEX_H
+#define IDLEINDEX_H
+
+#include <set>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Stations ordered by the exact idle/total ratio (compared by integer
+// cross-multiplication), ties broken by id.
+class IdleIndex {
+private:
+    struct Key {
+        int64_t idle;
+        int64_t total;
+        int id;
+    };
+    // Percent bound used for range lookups.
+    struct Bound {
+        double percent;
+    };
+    struct Less {
+        using is_transparent = void;
+        bool operator()(const Key& a, const Key& b) const {
+            int64_t l = a.idle * b.total, r = b.idle * a.total;
+            return l != r ? l < r : a.id < b.id;
+        }
+        bool operator()(const Key& a, const Bound& b) const { return 100.0 * a.idle < b.percent * a.total; }
+        bool operator()(const Bound& a, const Key& b) const { return a.percent * b.total < 100.0 * b.idle; }
+    };
+
+    std::set<Key, Less> keys;
+
+    static Key makeKey(int id, int total, int working);
+
+public:
+    void clear();
+    void add(int id, int total, int working);
+    void remove(int id, int total, int working);
+    void update(int id, int total, int oldWorking, int newWorking);
+    void rebuild(const std::vector<int>& ids, const std::vector<int32_t>& totals, const std::vector<int32_t>& workings);
+
+    size_t size() const { return keys.size(); }
+
+    // Ids with minPercent <= idle% <= maxPercent, least idle first.
+    std::vector<int> range(double minPercent, double maxPercent) const;
+    // Ids with idle% >= minPercent, least idle first.
+    std::vector<int> atLeast(double minPercent) const;
+    // The k most idle stations, most idle first.
+    std::vector<int> top(size_t k) const;
+};
+
+#endif // IDLEINDEX_H
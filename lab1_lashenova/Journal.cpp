@@ -0,0 +1,261 @@
+#include "Journal.h"
+#include <cstring>
+#include "Checksum.h"
+
+namespace {
+
+const char JOURNAL_MAGIC[8] = { 'L', 'J', 'N', 'L', '0', '0', '0', '1' };
+const size_t DEFAULT_GROUP_BYTES = 64 * 1024;
+const uint32_t MAX_ENTRY_BYTES = 1u << 30;
+
+class PayloadReader {
+private:
+    const char* p;
+    const char* end;
+public:
+    bool ok;
+    PayloadReader(const char* data, size_t size) : p(data), end(data + size), ok(true) {}
+
+    int32_t getInt() {
+        int32_t v = 0;
+        if (end - p < 4) { ok = false; return 0; }
+        std::memcpy(&v, p, 4);
+        p += 4;
+        return v;
+    }
+    double getDouble() {
+        double v = 0;
+        if (end - p < 8) { ok = false; return 0; }
+        std::memcpy(&v, p, 8);
+        p += 8;
+        return v;
+    }
+    std::string getString() {
+        uint32_t len = static_cast<uint32_t>(getInt());
+        if (!ok || static_cast<size_t>(end - p) < len) { ok = false; return std::string(); }
+        std::string s(p, len);
+        p += len;
+        return s;
+    }
+};
+
+}
+
+Journal::Journal() : group_bytes(DEFAULT_GROUP_BYTES), written_bytes(0) {}
+
+Journal::~Journal() { close(); }
+
+bool Journal::open(const std::string& filename_) {
+    close();
+    filename = filename_;
+    bool fresh;
+    {
+        std::ifstream probe(filename, std::ios::binary | std::ios::ate);
+        fresh = !probe || probe.tellg() <= 0;
+        written_bytes = fresh ? 0 : static_cast<uint64_t>(probe.tellg());
+    }
+    os.open(filename, std::ios::binary | std::ios::app);
+    if (!os) return false;
+    if (fresh) {
+        os.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        os.flush();
+        written_bytes = sizeof(JOURNAL_MAGIC);
+    }
+    return static_cast<bool>(os);
+}
+
+void Journal::close() {
+    if (!os.is_open()) return;
+    flush();
+    os.close();
+}
+
+bool Journal::reset() {
+    buffer.clear();
+    if (os.is_open()) os.close();
+    os.open(filename, std::ios::binary | std::ios::trunc);
+    if (!os) return false;
+    os.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    os.flush();
+    os.close();
+    os.open(filename, std::ios::binary | std::ios::app);
+    written_bytes = sizeof(JOURNAL_MAGIC);
+    return static_cast<bool>(os);
+}
+
+bool Journal::flush() {
+    if (!os.is_open()) return false;
+    if (!buffer.empty()) {
+        os.write(buffer.data(), buffer.size());
+        written_bytes += buffer.size();
+        buffer.clear();
+    }
+    os.flush();
+    return static_cast<bool>(os);
+}
+
+void Journal::begin(JournalOp op) {
+    buffer.append(4, '\0');
+    buffer.push_back(static_cast<char>(op));
+}
+
+void Journal::end(size_t start) {
+    uint32_t size = static_cast<uint32_t>(buffer.size() - start - 4);
+    std::memcpy(&buffer[start], &size, 4);
+    uint32_t sum = checksum(buffer.data() + start + 4, size);
+    buffer.append(reinterpret_cast<const char*>(&sum), 4);
+    if (buffer.size() >= group_bytes) flush();
+}
+
+void Journal::putInt(int32_t v) { buffer.append(reinterpret_cast<const char*>(&v), 4); }
+void Journal::putDouble(double v) { buffer.append(reinterpret_cast<const char*>(&v), 8); }
+
+void Journal::putString(std::string_view s) {
+    putInt(static_cast<int32_t>(s.size()));
+    buffer.append(s);
+}
+
+void Journal::logAddPipe(int id, std::string_view name, double diameter, bool in_repair) {
+    size_t start = buffer.size();
+    begin(JournalOp::AddPipe);
+    putInt(id);
+    putDouble(diameter);
+    putInt(in_repair ? 1 : 0);
+    putString(name);
+    end(start);
+}
+
+void Journal::logRemovePipe(int id) {
+    size_t start = buffer.size();
+    begin(JournalOp::RemovePipe);
+    putInt(id);
+    end(start);
+}
+
+void Journal::logSetPipeRepair(int id, bool in_repair) {
+    size_t start = buffer.size();
+    begin(JournalOp::SetPipeRepair);
+    putInt(id);
+    putInt(in_repair ? 1 : 0);
+    end(start);
+}
+
+void Journal::logBatchPipes(const std::vector<int>& ids, int flag) {
+    size_t start = buffer.size();
+    begin(JournalOp::BatchPipes);
+    putInt(flag);
+    putInt(static_cast<int32_t>(ids.size()));
+    buffer.append(reinterpret_cast<const char*>(ids.data()), ids.size() * sizeof(int32_t));
+    end(start);
+}
+
+void Journal::logAddStation(int id, std::string_view name, int total, int working, std::string_view classification) {
+    size_t start = buffer.size();
+    begin(JournalOp::AddStation);
+    putInt(id);
+    putInt(total);
+    putInt(working);
+    putString(name);
+    putString(classification);
+    end(start);
+}
+
+void Journal::logRemoveStation(int id) {
+    size_t start = buffer.size();
+    begin(JournalOp::RemoveStation);
+    putInt(id);
+    end(start);
+}
+
+void Journal::logSetStationWorking(int id, int working) {
+    size_t start = buffer.size();
+    begin(JournalOp::SetStationWorking);
+    putInt(id);
+    putInt(working);
+    end(start);
+}
+
+void Journal::logConnectPipe(int id, int in_station, int out_station) {
+    size_t start = buffer.size();
+    begin(JournalOp::ConnectPipe);
+    putInt(id);
+    putInt(in_station);
+    putInt(out_station);
+    end(start);
+}
+
+JournalReader::JournalReader() : clean(true) {}
+
+bool JournalReader::open(const std::string& filename) {
+    is.open(filename, std::ios::binary);
+    if (!is) return false;
+    char magic[sizeof(JOURNAL_MAGIC)];
+    if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) != 0) {
+        clean = false;
+        return false;
+    }
+    return true;
+}
+
+bool JournalReader::next(JournalEntry& entry) {
+    uint32_t size = 0;
+    if (!is.read(reinterpret_cast<char*>(&size), 4)) {
+        clean = is.gcount() == 0;
+        return false;
+    }
+    if (size == 0 || size > MAX_ENTRY_BYTES) {
+        clean = false;
+        return false;
+    }
+    std::string body(size, '\0');
+    uint32_t sum = 0;
+    if (!is.read(&body[0], size) || !is.read(reinterpret_cast<char*>(&sum), 4)
+        || sum != checksum(body.data(), body.size())) {
+        clean = false;
+        return false;
+    }
+
+    entry.op = static_cast<JournalOp>(body[0]);
+    PayloadReader r(body.data() + 1, body.size() - 1);
+    switch (entry.op) {
+    case JournalOp::AddPipe:
+        entry.id = r.getInt();
+        entry.diameter = r.getDouble();
+        entry.value = r.getInt();
+        entry.name = r.getString();
+        break;
+    case JournalOp::RemovePipe:
+    case JournalOp::RemoveStation:
+        entry.id = r.getInt();
+        break;
+    case JournalOp::SetPipeRepair:
+    case JournalOp::SetStationWorking:
+        entry.id = r.getInt();
+        entry.value = r.getInt();
+        break;
+    case JournalOp::AddStation:
+        entry.id = r.getInt();
+        entry.total = r.getInt();
+        entry.value = r.getInt();
+        entry.name = r.getString();
+        entry.classification = r.getString();
+        break;
+    case JournalOp::ConnectPipe:
+        entry.id = r.getInt();
+        entry.value = r.getInt();
+        entry.total = r.getInt();
+        break;
+    case JournalOp::BatchPipes:
+    case JournalOp::BatchStations: {
+        entry.value = r.getInt();
+        int count = r.getInt();
+        entry.ids.clear();
+        for (int i = 0; i < count && r.ok; ++i) entry.ids.push_back(r.getInt());
+        break;
+    }
+    default:
+        r.ok = false;
+    }
+    if (!r.ok) clean = false;
+    return r.ok;
+}
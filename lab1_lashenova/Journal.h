@@ -0,0 +1,98 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+enum class JournalOp : uint8_t {
+    AddPipe = 1,
+    RemovePipe = 2,
+    SetPipeRepair = 3,
+    BatchPipes = 4,
+    AddStation = 5,
+    RemoveStation = 6,
+    SetStationWorking = 7,
+    // Relative +1/-1 steps; only read, from journals of older builds. New
+    // ones log each station's resulting count, which replays idempotently.
+    BatchStations = 8,
+    // Station ids in value / total; both 0 disconnect the pipe.
+    ConnectPipe = 9
+};
+
+// Decoded journal entry; only the fields of its op are meaningful.
+struct JournalEntry {
+    JournalOp op;
+    int id;
+    int value;
+    int total;
+    double diameter;
+    std::string name;
+    std::string classification;
+    std::vector<int> ids;
+};
+
+// Append-only write-ahead log. Entries are framed as
+//   uint32 size | uint8 op | payload | uint32 checksum
+// and buffered in memory until a group is flushed. A flush hands the
+// group to the OS but does not fsync: flushed entries survive the process
+// crashing, not the machine. Every entry sets absolute values, so
+// replaying entries a snapshot already holds leaves it unchanged.
+class Journal {
+private:
+    std::string filename;
+    std::ofstream os;
+    std::string buffer;
+    size_t group_bytes;
+    uint64_t written_bytes;
+
+    void begin(JournalOp op);
+    void end(size_t start);
+    void putInt(int32_t v);
+    void putDouble(double v);
+    void putString(std::string_view s);
+
+public:
+    Journal();
+    ~Journal();
+
+    bool open(const std::string& filename_);
+    void close();
+    bool isOpen() const { return os.is_open(); }
+    // Drops all entries (after they were compacted into a snapshot).
+    bool reset();
+
+    void setGroupBytes(size_t bytes) { group_bytes = bytes; }
+    // Bytes in the file plus the pending group.
+    uint64_t size() const { return written_bytes + buffer.size(); }
+    bool flush();
+
+    void logAddPipe(int id, std::string_view name, double diameter, bool in_repair);
+    void logRemovePipe(int id);
+    void logSetPipeRepair(int id, bool in_repair);
+    void logBatchPipes(const std::vector<int>& ids, int flag);
+    void logAddStation(int id, std::string_view name, int total, int working, std::string_view classification);
+    void logRemoveStation(int id);
+    void logSetStationWorking(int id, int working);
+    void logConnectPipe(int id, int in_station, int out_station);
+};
+
+// Sequential reader; stops at the first torn or corrupt entry.
+class JournalReader {
+private:
+    std::ifstream is;
+    bool clean;
+
+public:
+    JournalReader();
+
+    bool open(const std::string& filename);
+    bool next(JournalEntry& entry);
+    // False if reading stopped on a damaged tail instead of end of file.
+    bool reachedCleanEnd() const { return clean; }
+};
+
+#endif // JOURNAL_H
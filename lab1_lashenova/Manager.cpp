@@ -2,28 +2,93 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <iomanip>
+#include <cstdio>
 #include "Utils.h"
+#include "Snapshot.h"
+#include "PackedFormat.h"
+#include "TextLoader.h"
+#include "FilterKernels.h"
+#include "RecordPrinter.h"
+
+namespace {
+const uint64_t DEFAULT_COMPACT_THRESHOLD = 64ull * 1024 * 1024;
+}
 
-Manager::Manager() : next_pipe_id(1), next_station_id(1) {}
+Manager::Manager() : next_pipe_id(1), next_station_id(1), history_replay(false), unsaved_changes(0), flow_version(0),
+    lazy_history_limit(0), compact_threshold(DEFAULT_COMPACT_THRESHOLD) {}
 
 int Manager::makePipeId() { return next_pipe_id++; }
 int Manager::makeStationId() { return next_station_id++; }
 
+void Manager::applyAddPipe(int id, string_view name, double diameter, bool in_repair) {
+    ptrdiff_t row = pipes.rowOf(id);
+    if (row >= 0) {
+        pipe_names.remove(id, pipes.nameColumn()[row]);
+        stats.removePipe(pipes.diameterColumn()[row], pipes.repairColumn()[row] != 0);
+        if (flow.isBuilt()) flow_changes.push_back(id);
+    }
+    pipes.insert(id, name, diameter, in_repair);
+    pipe_names.add(id, name);
+    stats.addPipe(diameter, in_repair);
+    trackPipe(id);
+    if (id >= next_pipe_id) next_pipe_id = id + 1;
+}
+
+bool Manager::applyRemovePipe(int id) {
+    ptrdiff_t row = pipes.rowOf(id);
+    if (row < 0) return false;
+    pipe_names.remove(id, pipes.nameColumn()[row]);
+    stats.removePipe(pipes.diameterColumn()[row], pipes.repairColumn()[row] != 0);
+    network.disconnect(id);
+    pipes.erase(id);
+    trackPipe(id);
+    return true;
+}
+
+bool Manager::applyPipeRepair(int id, bool in_repair) {
+    ptrdiff_t row = pipes.rowOf(id);
+    if (row < 0) return false;
+    stats.setPipeRepair(pipes.repairColumn()[row] != 0, in_repair);
+    if (flow.isBuilt() && network.isConnected(id)) flow_changes.push_back(id);
+    pipes.setInRepair(id, in_repair);
+    trackPipe(id);
+    return true;
+}
+
 int Manager::addPipe(const string& name, double diameter, bool in_repair) {
     int id = makePipeId();
-    Pipe pipe(id, name, diameter, in_repair);
-    pipes[id] = pipe;
+    if (journal.isOpen()) journal.logAddPipe(id, name, diameter, in_repair);
+    applyAddPipe(id, name, diameter, in_repair);
+    commitVersion("add pipe " + to_string(id));
     return id;
 }
 
 int Manager::addPipe(const Pipe& pipe) {
-    int id = makePipeId();
-    pipes[id] = pipe;
-    return id;
+    return addPipe(pipe.getName(), pipe.getDiameter(), pipe.isInRepair());
+}
+
+int Manager::addPipes(size_t count, const function<PipeSpec(size_t)>& generator) {
+    int first = next_pipe_id;
+    if (pipes.size() + count > pipes.capacity()) pipes.reserve(max(pipes.size() + count, pipes.size() * 3 / 2));
+    for (size_t i = 0; i < count; ++i) {
+        PipeSpec spec = generator(i);
+        int id = makePipeId();
+        if (journal.isOpen()) journal.logAddPipe(id, spec.name, spec.diameter, spec.in_repair);
+        applyAddPipe(id, spec.name, spec.diameter, spec.in_repair);
+    }
+    if (count) commitVersion("add " + to_string(count) + " pipes");
+    return first;
 }
 
 bool Manager::removePipeById(int id) {
-    return pipes.erase(id) > 0;
+    if (!faultInPipe(id)) return false;
+    if (journal.isOpen()) journal.logRemovePipe(id);
+    applyRemovePipe(id);
+    commitVersion("remove pipe " + to_string(id));
+    return true;
 }
 //
 //Pipe& Manager::getPipeById(int id) {
@@ -35,106 +100,433 @@ bool Manager::removePipeById(int id) {
 //    return not_found_pipe;
 //}
 
-vector<Pipe> Manager::findPipesByName(const string& substring) {
-    vector<Pipe> result;
-    for (const auto& pair : pipes) {
-        if (pair.second.getName().find(substring) != string::npos) {
-            result.push_back(pair.second);
-        }
+namespace {
+
+// Keeps the candidates whose name really contains the substring.
+template <typename Table>
+void verifyNameCandidates(const Table& table, const string& substring, vector<int>& ids) {
+    const vector<string_view>& names = table.nameColumn();
+    ids.erase(remove_if(ids.begin(), ids.end(), [&](int id) {
+        return names[table.rowOf(id)].find(substring) == string::npos;
+    }), ids.end());
+}
+
+template <typename Table, typename Pred>
+IdList scanRows(const Table& table, Pred pred) {
+    const vector<int>& idColumn = table.idColumn();
+    size_t count = 0;
+    for (size_t row = 0; row < idColumn.size(); ++row) count += pred(row) ? 1 : 0;
+    IdList ids;
+    ids.reserve(count);
+    for (size_t row = 0; row < idColumn.size(); ++row) {
+        if (pred(row)) ids.push_back(idColumn[row]);
     }
-    return result;
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Narrows to trigram candidates when the expression requires a name
+// substring, otherwise scans every row; either way one pass evaluates it.
+template <typename Table>
+IdList runQuery(const Table& table, const TrigramIndex& names, QueryExpr& expr) {
+    expr.optimize(table);
+    string needle;
+    IdList ids;
+    if (!expr.requiredName(needle) || !names.candidates(needle, ids)) return expr.select(table);
+
+    size_t kept = 0;
+    for (int id : ids) {
+        ptrdiff_t row = table.rowOf(id);
+        if (row >= 0 && expr.matches(table, static_cast<size_t>(row))) ids[kept++] = id;
+    }
+    ids.resize(kept);
+    return ids;
+}
+
+}
+
+IdList Manager::findPipeIdsByName(const string& substring) {
+    ensureLoaded();
+    IdList ids;
+    if (pipe_names.candidates(substring, ids)) {
+        verifyNameCandidates(pipes, substring, ids);
+        return ids;
+    }
+    const vector<string_view>& names = pipes.nameColumn();
+    return scanRows(pipes, [&](size_t row) { return names[row].find(substring) != string::npos; });
+}
+
+IdList Manager::findPipeIdsByRepairFlag(bool in_repair) {
+    ensureLoaded();
+    const vector<uint8_t>& repair = pipes.repairColumn();
+    filter::Bitmap bits(filter::wordCount(repair.size()));
+    filter::repairEquals(repair.data(), repair.size(), in_repair, bits.data());
+    return filter::selectIds(bits.data(), pipes.idColumn());
+}
+
+IdList Manager::findPipeIds(QueryExpr expr) {
+    ensureLoaded();
+    return runQuery(pipes, pipe_names, expr);
+}
+
+vector<Pipe> Manager::findPipesByName(const string& substring) {
+    return getPipesByIds(findPipeIdsByName(substring));
 }
 
 vector<Pipe> Manager::findPipesByRepairFlag(bool in_repair) {
+    return getPipesByIds(findPipeIdsByRepairFlag(in_repair));
+}
+
+optional<Pipe> Manager::getPipeById(int id) const {
+    // A lazy record is read through the page cache without joining the tables.
+    Pipe p;
+    if (!pipes.contains(id) && lazyPipe(id, p)) return p;
+    return pipes.get(id);
+}
+
+vector<Pipe> Manager::getPipesByIds(const IdList& ids) const {
     vector<Pipe> result;
-    for (const auto& pair : pipes) {
-        if (pair.second.isInRepair() == in_repair) {
-            result.push_back(pair.second);
-        }
+    result.reserve(ids.size());
+    for (int id : ids) {
+        if (optional<Pipe> p = getPipeById(id)) result.push_back(std::move(*p));
     }
     return result;
 }
 
-const unordered_map<int, Pipe>& Manager::getPipes() const { return pipes; }
-size_t Manager::getPipeCount() const { return pipes.size(); }
+bool Manager::setPipeInRepair(int id, bool in_repair) {
+    if (!faultInPipe(id)) return false;
+    if (journal.isOpen()) journal.logSetPipeRepair(id, in_repair);
+    applyPipeRepair(id, in_repair);
+    commitVersion("set repair of pipe " + to_string(id));
+    return true;
+}
+
+const PipeTable& Manager::getPipes() {
+    ensureLoaded();
+    return pipes;
+}
+
+size_t Manager::getPipeCount() const {
+    return pipes.size() + lazyPipeCount();
+}
+
+bool Manager::applyConnectPipe(int id, int in_station, int out_station) {
+    if (!pipes.contains(id)) return false;
+    if (in_station == 0 && out_station == 0) {
+        network.disconnect(id);
+    }
+    else {
+        if (in_station == out_station || !stations.contains(in_station) || !stations.contains(out_station)) return false;
+        network.connect(id, in_station, out_station);
+    }
+    pipes.setEndpoints(id, in_station, out_station);
+    trackPipe(id);
+    return true;
+}
+
+bool Manager::connectPipe(int id, int in_station, int out_station) {
+    if (in_station == out_station || !faultInPipe(id)
+        || !faultInStation(in_station) || !faultInStation(out_station)) return false;
+    if (journal.isOpen()) journal.logConnectPipe(id, in_station, out_station);
+    applyConnectPipe(id, in_station, out_station);
+    commitVersion("connect pipe " + to_string(id));
+    return true;
+}
+
+bool Manager::disconnectPipe(int id) {
+    faultInPipe(id);
+    if (!network.isConnected(id)) return false;
+    if (journal.isOpen()) journal.logConnectPipe(id, 0, 0);
+    applyConnectPipe(id, 0, 0);
+    commitVersion("disconnect pipe " + to_string(id));
+    return true;
+}
+
+IdList Manager::findReachableStationIds(int stationId) {
+    ensureLoaded();
+    return network.reachableFrom(stationId);
+}
+
+bool Manager::findStationTopologicalOrder(IdList& order) {
+    ensureLoaded();
+    return network.topologicalOrder(order);
+}
+
+vector<IdList> Manager::findConnectedStationGroups() {
+    ensureLoaded();
+    return network.components();
+}
+
+int64_t Manager::findMaxFlow(int source, int sink, IdList* bottleneck) {
+    ensureLoaded();
+    ptrdiff_t s = network.nodeOf(source), t = network.nodeOf(sink);
+    if (s < 0 || t < 0) return -1;
+    if (bottleneck) bottleneck->clear();
+    if (s == t) return 0;
+
+    // Past a few percent of the pipes a fresh solve is cheaper than repair.
+    if (!flow.isBuilt() || flow_version != network.version() || flow_changes.size() > pipes.size() / 16 + 64) {
+        flow.build(network, pipes);
+        flow_version = network.version();
+    }
+    else if (!flow_changes.empty()) {
+        flow.update(pipes, flow_changes);
+    }
+    flow_changes.clear();
+
+    if (!flow.isSolved() || flow.getSource() != static_cast<uint32_t>(s) || flow.getSink() != static_cast<uint32_t>(t)) {
+        flow.solve(static_cast<uint32_t>(s), static_cast<uint32_t>(t));
+    }
+    if (bottleneck) *bottleneck = flow.minCut();
+    return flow.flowValue();
+}
+
+const Network& Manager::getNetwork() {
+    ensureLoaded();
+    return network;
+}
+
+const NetworkStats& Manager::getStats() {
+    ensureLoaded();
+    return stats;
+}
+
+void Manager::applyAddStation(int id, string_view name, int total, int working, ClassId classification) {
+    ptrdiff_t row = stations.rowOf(id);
+    if (row >= 0) {
+        station_names.remove(id, stations.nameColumn()[row]);
+        station_idle.remove(id, stations.totalColumn()[row], stations.workingColumn()[row]);
+        stats.removeStation(stations.totalColumn()[row], stations.workingColumn()[row]);
+    }
+    stations.insert(id, name, total, working, classification);
+    station_names.add(id, name);
+    station_idle.add(id, total, working);
+    stats.addStation(total, working);
+    network.addStation(id);
+    trackStation(id);
+    if (id >= next_station_id) next_station_id = id + 1;
+}
+
+bool Manager::applyRemoveStation(int id) {
+    ptrdiff_t row = stations.rowOf(id);
+    if (row < 0) return false;
+    station_names.remove(id, stations.nameColumn()[row]);
+    station_idle.remove(id, stations.totalColumn()[row], stations.workingColumn()[row]);
+    stats.removeStation(stations.totalColumn()[row], stations.workingColumn()[row]);
+    // Pipes attached to the station become unconnected.
+    for (int pipe : network.pipesAt(id)) {
+        network.disconnect(pipe);
+        pipes.setEndpoints(pipe, 0, 0);
+        trackPipe(pipe);
+    }
+    network.removeStation(id);
+    stations.erase(id);
+    trackStation(id);
+    return true;
+}
+
+bool Manager::applyStationWorking(int id, int working) {
+    ptrdiff_t row = stations.rowOf(id);
+    if (row < 0) return false;
+    station_idle.update(id, stations.totalColumn()[row], stations.workingColumn()[row], working);
+    stats.setStationWorking(stations.totalColumn()[row], stations.workingColumn()[row], working);
+    stations.setWorkingWorkshops(id, working);
+    trackStation(id);
+    return true;
+}
 
 int Manager::addStation(const string& name, int total, int working, const string& classification) {
     int id = makeStationId();
-    stations.emplace(id, CompressorStation(id, name, total, working, classification));
+    if (journal.isOpen()) journal.logAddStation(id, name, total, working, classification);
+    applyAddStation(id, name, total, working, ClassRegistry::intern(classification));
+    commitVersion("add station " + to_string(id));
     return id;
 }
 
 int Manager::addStation(const CompressorStation& station) {
-    int id = makeStationId();
-    stations.emplace(id, CompressorStation(id, station.getName(), station.getTotalWorkshops(),
-        station.getWorkingWorkshops(), station.getClassification()));
-    return id;
+    return addStation(station.getName(), station.getTotalWorkshops(),
+        station.getWorkingWorkshops(), station.getClassification());
+}
+
+int Manager::addStations(size_t count, const function<StationSpec(size_t)>& generator) {
+    int first = next_station_id;
+    if (stations.size() + count > stations.capacity()) stations.reserve(max(stations.size() + count, stations.size() * 3 / 2));
+    for (size_t i = 0; i < count; ++i) {
+        StationSpec spec = generator(i);
+        int id = makeStationId();
+        if (journal.isOpen()) journal.logAddStation(id, spec.name, spec.total, spec.working, spec.classification);
+        applyAddStation(id, spec.name, spec.total, spec.working, ClassRegistry::intern(spec.classification));
+    }
+    if (count) commitVersion("add " + to_string(count) + " stations");
+    return first;
 }
 
 bool Manager::removeStationById(int id) {
-    auto it = stations.find(id);
-    if (it == stations.end()) return false;
-    stations.erase(it);
+    if (!faultInStation(id)) return false;
+    if (journal.isOpen()) journal.logRemoveStation(id);
+    applyRemoveStation(id);
+    commitVersion("remove station " + to_string(id));
+    return true;
+}
+
+optional<CompressorStation> Manager::getStationById(int id) const {
+    CompressorStation s;
+    if (!stations.contains(id) && lazyStation(id, s)) return s;
+    return stations.get(id);
+}
+
+bool Manager::setStationWorking(int id, int working) {
+    if (!faultInStation(id)) return false;
+    if (journal.isOpen()) journal.logSetStationWorking(id, working);
+    applyStationWorking(id, working);
+    commitVersion("set working of station " + to_string(id));
     return true;
 }
 
-CompressorStation& Manager::getStationById(int id) {
-    static CompressorStation emptyStation;
-    auto it = stations.find(id);
-    if (it != stations.end()) {
-        return it->second;
+IdList Manager::findStationIdsByName(const string& substring) {
+    ensureLoaded();
+    IdList ids;
+    if (station_names.candidates(substring, ids)) {
+        verifyNameCandidates(stations, substring, ids);
+        return ids;
     }
-    return emptyStation;
+    const vector<string_view>& names = stations.nameColumn();
+    return scanRows(stations, [&](size_t row) { return names[row].find(substring) != string::npos; });
+}
+
+IdList Manager::findStationIdsByClass(const string& classification) {
+    ensureLoaded();
+    ClassId cls;
+    if (!ClassRegistry::find(classification, cls)) return IdList();
+    const vector<ClassId>& classes = stations.classColumn();
+    return scanRows(stations, [&](size_t row) { return classes[row] == cls; });
+}
+
+IdList Manager::findStationIdsByIdlePercent(double minIdlePercent) {
+    ensureLoaded();
+    IdList ids = station_idle.atLeast(minIdlePercent);
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+IdList Manager::findStationIdsByIdleRange(double minIdlePercent, double maxIdlePercent) {
+    ensureLoaded();
+    IdList ids = station_idle.range(minIdlePercent, maxIdlePercent);
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+IdList Manager::findMostIdleStationIds(size_t k) {
+    ensureLoaded();
+    return station_idle.top(k);
+}
+
+IdList Manager::findStationIds(QueryExpr expr) {
+    ensureLoaded();
+    return runQuery(stations, station_names, expr);
 }
 
 vector<CompressorStation> Manager::findStationsByName(const string& substring) {
-    vector<CompressorStation> result;
-    for (const auto& pair : stations) {
-        if (pair.second.getName().find(substring) != string::npos) {
-            result.push_back(pair.second);
-        }
-    }
-    return result;
+    return getStationsByIds(findStationIdsByName(substring));
+}
+
+vector<CompressorStation> Manager::findStationsByClass(const string& classification) {
+    return getStationsByIds(findStationIdsByClass(classification));
 }
 
 vector<CompressorStation> Manager::findStationsByIdlePercent(double minIdlePercent) {
+    return getStationsByIds(findStationIdsByIdlePercent(minIdlePercent));
+}
+
+vector<CompressorStation> Manager::findStationsByIdleRange(double minIdlePercent, double maxIdlePercent) {
+    return getStationsByIds(findStationIdsByIdleRange(minIdlePercent, maxIdlePercent));
+}
+
+vector<CompressorStation> Manager::findMostIdleStations(size_t k) {
+    return getStationsByIds(findMostIdleStationIds(k));
+}
+
+vector<CompressorStation> Manager::getStationsByIds(const IdList& ids) const {
     vector<CompressorStation> result;
-    for (const auto& pair : stations) {
-        if (pair.second.percentIdle() >= minIdlePercent) {
-            result.push_back(pair.second);
-        }
+    result.reserve(ids.size());
+    for (int id : ids) {
+        if (optional<CompressorStation> s = getStationById(id)) result.push_back(std::move(*s));
     }
     return result;
 }
 
-const unordered_map<int, CompressorStation>& Manager::getStations() const { return stations; }
-size_t Manager::getStationCount() const { return stations.size(); }
+const StationTable& Manager::getStations() {
+    ensureLoaded();
+    return stations;
+}
+
+size_t Manager::getStationCount() const {
+    return stations.size() + lazyStationCount();
+}
 
 bool Manager::saveToFile(const string& filename) {
+    if (!ensureLoaded()) return false;
     ofstream os(filename);
     if (!os) return false;
 
-    for (const auto& p : pipes) {
-        os << "PIPE|" << p.second.getId() << "|"
-            << p.second.getName() << "|"
-            << p.second.getDiameter() << "|"
-            << p.second.isInRepair() << "\n";
+    for (size_t row = 0; row < pipes.size(); ++row) {
+        os << "PIPE|" << pipes.idColumn()[row] << "|"
+            << pipes.nameColumn()[row] << "|"
+            << pipes.diameterColumn()[row] << "|"
+            << (pipes.repairColumn()[row] != 0) << "|"
+            << pipes.inColumn()[row] << "|"
+            << pipes.outColumn()[row] << "\n";
     }
-    for (const auto& s : stations) {
-        os << "STATION|" << s.second.getId() << "|"
-            << s.second.getName() << "|"
-            << s.second.getTotalWorkshops() << "|"
-            << s.second.getWorkingWorkshops() << "|"
-            << s.second.getClassification() << "\n";
+    for (size_t row = 0; row < stations.size(); ++row) {
+        os << "STATION|" << stations.idColumn()[row] << "|"
+            << stations.nameColumn()[row] << "|"
+            << stations.totalColumn()[row] << "|"
+            << stations.workingColumn()[row] << "|"
+            << stations.classificationOf(row) << "\n";
     }
     os.close();
     return true;
 }
 
 bool Manager::loadFromFile(const string& filename) {
+    TextLoader loader;
+    if (!loader.load(filename)) return false;
+    closeLazy();
+
+    size_t pipeCount = 0, stationCount = 0;
+    for (const auto& chunk : loader.getChunks()) {
+        pipeCount += chunk.pipes.size();
+        stationCount += chunk.stations.size();
+    }
+
+    pipes.clear();
+    stations.clear();
+    pipes.reserve(pipeCount);
+    stations.reserve(stationCount);
+
+    ClassResolver classes;
+    for (const auto& chunk : loader.getChunks()) {
+        for (const TextPipe& p : chunk.pipes) {
+            if (!pipes.contains(p.id)) pipes.insert(p.id, p.name, p.diameter, p.in_repair, p.in_station, p.out_station);
+            if (p.id >= next_pipe_id) next_pipe_id = p.id + 1;
+        }
+        for (const TextStation& s : chunk.stations) {
+            if (!stations.contains(s.id)) {
+                stations.insert(s.id, s.name, s.total, s.working, classes(s.classification));
+            }
+            if (s.id >= next_station_id) next_station_id = s.id + 1;
+        }
+    }
+    afterBulkLoad();
+    return true;
+}
+
+// Line-by-line reference loader, kept for comparison with loadFromFile.
+bool Manager::loadFromFileSerial(const string& filename) {
     ifstream is(filename);
     if (!is) return false;
 
+    closeLazy();
     pipes.clear();
     stations.clear();
     string line;
@@ -147,17 +539,21 @@ bool Manager::loadFromFile(const string& filename) {
         getline(iss, type, '|');
 
         if (type == "PIPE") {
-            string id_str, name, diam_str, repair_str;
+            string id_str, name, diam_str, repair_str, in_str, out_str;
             getline(iss, id_str, '|');
             getline(iss, name, '|');
             getline(iss, diam_str, '|');
             getline(iss, repair_str, '|');
+            getline(iss, in_str, '|');
+            getline(iss, out_str, '|');
 
             int id = stoi(id_str);
             double diameter = stod(diam_str);
             bool in_repair = (repair_str == "1");
+            int in_station = in_str.empty() || out_str.empty() ? 0 : stoi(in_str);
+            int out_station = in_station == 0 ? 0 : stoi(out_str);
 
-            pipes.emplace(id, Pipe(id, name, diameter, in_repair));
+            if (!pipes.contains(id)) pipes.insert(Pipe(id, name, diameter, in_repair, in_station, out_station));
             if (id >= next_pipe_id) next_pipe_id = id + 1;
         }
         else if (type == "STATION") {
@@ -172,51 +568,503 @@ bool Manager::loadFromFile(const string& filename) {
             int total = stoi(total_str);
             int working = stoi(working_str);
 
-            stations.emplace(id, CompressorStation(id, name, total, working, classification));
+            if (!stations.contains(id)) stations.insert(CompressorStation(id, name, total, working, classification));
             if (id >= next_station_id) next_station_id = id + 1;
         }
     }
 
     is.close();
+    afterBulkLoad();
     return true;
 }
 
-void Manager::batchEditPipes(const vector<int>& ids, int changeRepairFlag) {
-    for (int id : ids) {
-        auto it = pipes.find(id);
-        if (it != pipes.end()) {
-            Pipe& p = it->second;
-            if (changeRepairFlag == 0) p.setInRepair(false);
-            else if (changeRepairFlag == 1) p.setInRepair(true);
+bool Manager::saveSnapshot(const string& filename) {
+    if (!ensureLoaded()) return false;
+    return writeSnapshot(filename, pipes, stations, next_pipe_id, next_station_id);
+}
+
+bool Manager::loadSnapshot(const string& filename) {
+    SnapshotReader reader;
+    if (!reader.open(filename)) return false;
+
+    closeLazy();
+    pipes.clear();
+    stations.clear();
+    if (reader.nextPipeId() > next_pipe_id) next_pipe_id = reader.nextPipeId();
+    if (reader.nextStationId() > next_station_id) next_station_id = reader.nextStationId();
+    // Replay and autosave work on the tables, so they get every record now.
+    if (journal.isOpen() || autosaver.isRunning()) {
+        copySnapshot(reader);
+        afterBulkLoad();
+        return true;
+    }
+
+    // The validated mapping becomes the lazy source; nothing is reopened.
+    lazy_snapshot.swap(reader);
+    // Versions would miss the records still in the file.
+    lazy_history_limit = history.getLimit();
+    history.setLimit(0);
+    rebuildIndexes();
+    return true;
+}
+
+void Manager::copySnapshot(const SnapshotReader& reader) {
+    pipes.reserve(pipes.size() + reader.pipeCount());
+    stations.reserve(stations.size() + reader.stationCount());
+    for (size_t i = 0; i < reader.pipeCount(); ++i) {
+        const PipeRecord& r = reader.pipeRecord(i);
+        if (lazy_taken_pipes.count(r.id) || pipes.contains(r.id)) continue;
+        PipeEndpoints e = reader.pipeEndpoints(i);
+        pipes.insert(r.id, reader.pipeName(i), r.diameter, r.in_repair != 0, e.in_station, e.out_station);
+    }
+    // Each distinct classification is stored once in the heap, so the
+    // offset identifies it without hashing the string again.
+    unordered_map<uint32_t, ClassId> classes;
+    for (size_t i = 0; i < reader.stationCount(); ++i) {
+        const StationRecord& r = reader.stationRecord(i);
+        if (lazy_taken_stations.count(r.id) || stations.contains(r.id)) continue;
+        auto cls = classes.find(r.class_offset);
+        if (cls == classes.end()) {
+            cls = classes.emplace(r.class_offset, ClassRegistry::intern(reader.stationClassification(i))).first;
+        }
+        stations.insert(r.id, reader.stationName(i), r.total_workshops, r.working_workshops, cls->second);
+    }
+}
+
+bool Manager::savePacked(const string& filename) {
+    if (!ensureLoaded()) return false;
+    return writePacked(filename, pipes, stations, next_pipe_id, next_station_id);
+}
+
+bool Manager::loadPacked(const string& filename) {
+    PackedReader reader;
+    if (!reader.load(filename)) return false;
+
+    closeLazy();
+    pipes.clear();
+    stations.clear();
+    pipes.reserve(reader.pipeCount());
+    stations.reserve(reader.stationCount());
+    for (size_t i = 0; i < reader.pipeCount(); ++i) {
+        pipes.insert(reader.pipeId(i), reader.pipeName(i), reader.pipeDiameter(i), reader.pipeInRepair(i),
+            reader.pipeIn(i), reader.pipeOut(i));
+    }
+    for (size_t i = 0; i < reader.stationCount(); ++i) {
+        stations.insert(reader.stationId(i), reader.stationName(i), reader.stationTotal(i), reader.stationWorking(i),
+            reader.stationClass(i));
+    }
+
+    if (reader.nextPipeId() > next_pipe_id) next_pipe_id = reader.nextPipeId();
+    if (reader.nextStationId() > next_station_id) next_station_id = reader.nextStationId();
+    afterBulkLoad();
+    return true;
+}
+
+bool Manager::saveAnyFormat(const string& filename) {
+    auto endsWith = [&](const char* suffix) {
+        size_t n = char_traits<char>::length(suffix);
+        return filename.size() > n && filename.compare(filename.size() - n, n, suffix) == 0;
+    };
+    if (endsWith(".snap")) return saveSnapshot(filename);
+    if (endsWith(".lpk")) return savePacked(filename);
+    return saveToFile(filename);
+}
+
+bool Manager::openLazy(const string& filename, size_t cacheBytes) {
+    if (journal.isOpen() || autosaver.isRunning()) return loadFromFile(filename);
+    closeLazy();
+    if (!lazy.open(filename, cacheBytes)) return false;
+
+    pipes.clear();
+    stations.clear();
+    // Versions would miss the records still in the file.
+    lazy_history_limit = history.getLimit();
+    history.setLimit(0);
+    if (lazy.maxPipeId() >= next_pipe_id) next_pipe_id = lazy.maxPipeId() + 1;
+    if (lazy.maxStationId() >= next_station_id) next_station_id = lazy.maxStationId() + 1;
+    rebuildIndexes();
+    return true;
+}
+
+bool Manager::isLazy() const { return lazy.isOpen() || lazy_snapshot.isOpen(); }
+
+const PagedStore& Manager::getLazyStore() const { return lazy; }
+
+bool Manager::lazyPipe(int id, Pipe& p) const {
+    if (lazy_taken_pipes.count(id)) return false;
+    if (lazy.isOpen()) return lazy.findPipe(id, p);
+    ptrdiff_t i = lazy_snapshot.isOpen() ? lazy_snapshot.findPipe(id) : -1;
+    if (i < 0) return false;
+    p = lazy_snapshot.pipeAt(static_cast<size_t>(i));
+    return true;
+}
+
+bool Manager::lazyStation(int id, CompressorStation& s) const {
+    if (lazy_taken_stations.count(id)) return false;
+    if (lazy.isOpen()) return lazy.findStation(id, s);
+    ptrdiff_t i = lazy_snapshot.isOpen() ? lazy_snapshot.findStation(id) : -1;
+    if (i < 0) return false;
+    s = lazy_snapshot.stationAt(static_cast<size_t>(i));
+    return true;
+}
+
+size_t Manager::lazyPipeCount() const {
+    size_t onFile = lazy.isOpen() ? lazy.pipeCount() : lazy_snapshot.pipeCount();
+    return onFile - min(onFile, lazy_taken_pipes.size());
+}
+
+size_t Manager::lazyStationCount() const {
+    size_t onFile = lazy.isOpen() ? lazy.stationCount() : lazy_snapshot.stationCount();
+    return onFile - min(onFile, lazy_taken_stations.size());
+}
+
+bool Manager::faultInPipe(int id) {
+    if (pipes.contains(id)) return true;
+    Pipe p;
+    if (!lazyPipe(id, p)) return false;
+    lazy_taken_pipes.insert(id);
+    applyAddPipe(id, p.getName(), p.getDiameter(), p.isInRepair());
+    // Endpoints need both stations in the tables as well.
+    if (p.getInStation() != 0 && faultInStation(p.getInStation()) && faultInStation(p.getOutStation())) {
+        applyConnectPipe(id, p.getInStation(), p.getOutStation());
+    }
+    return true;
+}
+
+bool Manager::faultInStation(int id) {
+    if (stations.contains(id)) return true;
+    CompressorStation s;
+    if (!lazyStation(id, s)) return false;
+    lazy_taken_stations.insert(id);
+    applyAddStation(id, s.getName(), s.getTotalWorkshops(), s.getWorkingWorkshops(), s.getClassId());
+    return true;
+}
+
+bool Manager::ensureLoaded() {
+    if (!isLazy()) return true;
+    if (lazy_snapshot.isOpen()) {
+        copySnapshot(lazy_snapshot);
+        closeLazy();
+        afterBulkLoad();
+        return true;
+    }
+    TextLoader loader;
+    if (!loader.load(lazy.getPath())) return false;
+    // Records already in the tables (or removed from them) win over the file.
+    pipes.reserve(pipes.size() + lazy.pipeCount());
+    stations.reserve(stations.size() + lazy.stationCount());
+    ClassResolver classes;
+    for (const auto& chunk : loader.getChunks()) {
+        for (const TextPipe& p : chunk.pipes) {
+            if (lazy_taken_pipes.count(p.id) || pipes.contains(p.id)) continue;
+            pipes.insert(p.id, p.name, p.diameter, p.in_repair, p.in_station, p.out_station);
+        }
+        for (const TextStation& s : chunk.stations) {
+            if (lazy_taken_stations.count(s.id) || stations.contains(s.id)) continue;
+            stations.insert(s.id, s.name, s.total, s.working, classes(s.classification));
         }
     }
+    closeLazy();
+    afterBulkLoad();
+    return true;
+}
+
+void Manager::closeLazy() {
+    if (!isLazy()) return;
+    lazy.close();
+    lazy_snapshot.close();
+    lazy_taken_pipes.clear();
+    lazy_taken_stations.clear();
+    history.setLimit(lazy_history_limit);
+}
+
+bool Manager::loadAnyFormat(const string& filename) {
+    if (isSnapshotFile(filename)) return loadSnapshot(filename);
+    if (isPackedFile(filename)) return loadPacked(filename);
+    return loadFromFile(filename);
+}
+
+void Manager::applyBatchPipes(const vector<int>& ids, int changeRepairFlag) {
+    if (changeRepairFlag != 0 && changeRepairFlag != 1) return;
+    for (int id : ids) {
+        applyPipeRepair(id, changeRepairFlag == 1);
+    }
+}
+
+void Manager::batchEditPipes(const vector<int>& ids, int changeRepairFlag) {
+    if (changeRepairFlag != 0 && changeRepairFlag != 1) return;
+    for (int id : ids) faultInPipe(id);
+    if (journal.isOpen()) journal.logBatchPipes(ids, changeRepairFlag);
+    applyBatchPipes(ids, changeRepairFlag);
+    commitVersion(string(changeRepairFlag ? "repair " : "unrepair ") + to_string(ids.size()) + " pipes");
 }
 
 void Manager::batchEditStations(const vector<int>& ids, int workingStationsFlag) {
+    if (workingStationsFlag == 0) return;
     for (int id : ids) {
-        auto it = stations.find(id);
-        if (it != stations.end()) {
-            CompressorStation& cs = it->second;
-
-            if (workingStationsFlag != 0) {
-                int currentWorking = cs.getWorkingWorkshops();
-                int total = cs.getTotalWorkshops();
-
-                if (workingStationsFlag == 1) {
-                    if (currentWorking < total) {
-                        cs.setWorkingWorkshops(currentWorking + 1);
-                    }
-                }
-                else if (workingStationsFlag == -1) {
-                    if (currentWorking > 0) {
-                        cs.setWorkingWorkshops(currentWorking - 1);
-                    }
-                }
-            }
+        faultInStation(id);
+        int working = steppedWorking(id, workingStationsFlag);
+        if (working < 0) continue;
+        if (journal.isOpen()) journal.logSetStationWorking(id, working);
+        applyStationWorking(id, working);
+    }
+    commitVersion(string(workingStationsFlag > 0 ? "start a workshop at " : "stop a workshop at ") + to_string(ids.size()) + " stations");
+}
+
+void Manager::applyBatchStations(const vector<int>& ids, int workingStationsFlag) {
+    for (int id : ids) {
+        int working = steppedWorking(id, workingStationsFlag);
+        if (working >= 0) applyStationWorking(id, working);
+    }
+}
+
+int Manager::steppedWorking(int id, int workingStationsFlag) const {
+    ptrdiff_t row = stations.rowOf(id);
+    if (row < 0) return -1;
+    int currentWorking = stations.workingColumn()[row];
+    int total = stations.totalColumn()[row];
+    if (workingStationsFlag == 1 && currentWorking < total) return currentWorking + 1;
+    if (workingStationsFlag == -1 && currentWorking > 0) return currentWorking - 1;
+    return -1;
+}
+
+void Manager::applyJournalEntry(const JournalEntry& e) {
+    switch (e.op) {
+    case JournalOp::AddPipe: applyAddPipe(e.id, e.name, e.diameter, e.value != 0); break;
+    case JournalOp::RemovePipe: applyRemovePipe(e.id); break;
+    case JournalOp::SetPipeRepair: applyPipeRepair(e.id, e.value != 0); break;
+    case JournalOp::BatchPipes: applyBatchPipes(e.ids, e.value); break;
+    case JournalOp::AddStation: applyAddStation(e.id, e.name, e.total, e.value, ClassRegistry::intern(e.classification)); break;
+    case JournalOp::RemoveStation: applyRemoveStation(e.id); break;
+    case JournalOp::SetStationWorking: applyStationWorking(e.id, e.value); break;
+    case JournalOp::BatchStations: applyBatchStations(e.ids, e.value); break;
+    case JournalOp::ConnectPipe: applyConnectPipe(e.id, e.value, e.total); break;
+    }
+}
+
+// A whole-network load is not journaled: the store is compacted right away.
+void Manager::afterBulkLoad() {
+    rebuildIndexes();
+    if (journal.isOpen()) compact();
+}
+
+void Manager::rebuildIndexes() {
+    pipe_names.rebuild(pipes.idColumn(), pipes.nameColumn());
+    station_names.rebuild(stations.idColumn(), stations.nameColumn());
+    station_idle.rebuild(stations.idColumn(), stations.totalColumn(), stations.workingColumn());
+    stats.rebuild(pipes.diameterColumn(), pipes.repairColumn(), stations.totalColumn(), stations.workingColumn());
+    // Endpoints naming a missing station (or the same one twice) are dropped.
+    network.assign(stations.idColumn(), pipes.idColumn(), pipes.inColumn(), pipes.outColumn());
+    for (size_t row = 0; row < pipes.size(); ++row) {
+        int id = pipes.idColumn()[row];
+        if ((pipes.inColumn()[row] != 0 || pipes.outColumn()[row] != 0) && !network.isConnected(id)) pipes.setEndpoints(id, 0, 0);
+    }
+    if (history.isEnabled()) {
+        trackAll();
+        history.reset("load");
+        publishVersion();
+    }
+}
+
+void Manager::trackPipe(int id) {
+    if (!history.isEnabled() || history_replay) return;
+    ++unsaved_changes;
+    ptrdiff_t row = pipes.rowOf(id);
+    if (row < 0) {
+        history.pipes.erase(id);
+        return;
+    }
+    history.pipes.set(id, PipeState{ string(pipes.nameColumn()[row]), pipes.diameterColumn()[row],
+        pipes.repairColumn()[row] != 0, pipes.inColumn()[row], pipes.outColumn()[row] });
+}
+
+void Manager::trackStation(int id) {
+    if (!history.isEnabled() || history_replay) return;
+    ++unsaved_changes;
+    ptrdiff_t row = stations.rowOf(id);
+    if (row < 0) {
+        history.stations.erase(id);
+        return;
+    }
+    history.stations.set(id, StationState{ string(stations.nameColumn()[row]), stations.totalColumn()[row],
+        stations.workingColumn()[row], stations.classColumn()[row] });
+}
+
+void Manager::trackAll() {
+    history.pipes.clear();
+    history.stations.clear();
+    for (int id : pipes.idColumn()) trackPipe(id);
+    for (int id : stations.idColumn()) trackStation(id);
+}
+
+void Manager::commitVersion(const string& label) {
+    if (!history.isEnabled()) return;
+    history.commit(label);
+    publishVersion();
+}
+
+void Manager::publishVersion() {
+    if (!autosaver.isRunning()) return;
+    autosaver.publish(history.currentVersion(), next_pipe_id, next_station_id, unsaved_changes);
+    unsaved_changes = 0;
+}
+
+bool Manager::setHistoryLimit(size_t versions) {
+    if (versions > 0 && !ensureLoaded()) return false;
+    // The autosaver reads the current version.
+    if (autosaver.isRunning()) versions = max<size_t>(versions, 1);
+    bool start = !history.isEnabled() && versions > 0;
+    history.setLimit(versions);
+    if (start) {
+        trackAll();
+        history.reset("start");
+    }
+    return true;
+}
+
+size_t Manager::getHistoryLimit() const { return history.getLimit(); }
+
+bool Manager::undo() { return stepHistory(false); }
+bool Manager::redo() { return stepHistory(true); }
+
+// Replays the difference to the neighbouring version through the apply*
+// helpers, then adopts that version's maps so it stays shared.
+bool Manager::stepHistory(bool forward) {
+    shared_ptr<const StoreVersion> from = history.currentVersion();
+    shared_ptr<const StoreVersion> to = forward ? history.redoTarget() : history.undoTarget();
+    if (!from || !to) return false;
+    history_replay = true;
+
+    // Stations first so that pipes can be reconnected to them, removals last.
+    vector<int> removedStations;
+    size_t changed = 0;
+    PersistentMap<StationState>::diff(from->stationMap(), to->stationMap(),
+        [&](int id, const StationState* before, const StationState* after) {
+        ++changed;
+        if (!after) {
+            removedStations.push_back(id);
+        }
+        else if (before && before->name == after->name && before->total == after->total
+            && before->classification == after->classification) {
+            if (journal.isOpen()) journal.logSetStationWorking(id, after->working);
+            applyStationWorking(id, after->working);
+        }
+        else {
+            if (journal.isOpen()) journal.logAddStation(id, after->name, after->total, after->working,
+                ClassRegistry::name(after->classification));
+            applyAddStation(id, after->name, after->total, after->working, after->classification);
+        }
+    });
+    PersistentMap<PipeState>::diff(from->pipeMap(), to->pipeMap(),
+        [&](int id, const PipeState* before, const PipeState* after) {
+        ++changed;
+        if (!after) {
+            if (journal.isOpen()) journal.logRemovePipe(id);
+            applyRemovePipe(id);
+            return;
+        }
+        if (!before || before->name != after->name || before->diameter != after->diameter) {
+            if (journal.isOpen()) journal.logAddPipe(id, after->name, after->diameter, after->in_repair);
+            applyAddPipe(id, after->name, after->diameter, after->in_repair);
+        }
+        else if (before->in_repair != after->in_repair) {
+            if (journal.isOpen()) journal.logSetPipeRepair(id, after->in_repair);
+            applyPipeRepair(id, after->in_repair);
+        }
+        if (before ? before->in_station != after->in_station || before->out_station != after->out_station
+            : after->in_station != 0) {
+            if (journal.isOpen()) journal.logConnectPipe(id, after->in_station, after->out_station);
+            applyConnectPipe(id, after->in_station, after->out_station);
         }
+    });
+    for (int id : removedStations) {
+        if (journal.isOpen()) journal.logRemoveStation(id);
+        applyRemoveStation(id);
     }
+
+    history_replay = false;
+    history.moveTo(forward);
+    unsaved_changes += changed;
+    publishVersion();
+    return true;
+}
+
+const vector<shared_ptr<const StoreVersion>>& Manager::getVersions() const { return history.all(); }
+
+shared_ptr<const StoreVersion> Manager::getVersion(uint64_t number) const { return history.find(number); }
+
+shared_ptr<const StoreVersion> Manager::getCurrentVersion() const { return history.currentVersion(); }
+
+bool Manager::diffVersions(uint64_t from, uint64_t to, VersionDiff& out) const {
+    shared_ptr<const StoreVersion> a = history.find(from), b = history.find(to);
+    if (!a || !b) return false;
+    VersionHistory::diff(*a, *b, out);
+    return true;
+}
+
+bool Manager::startAutosave(const string& path, chrono::milliseconds interval, size_t dirtyRecords) {
+    if (!ensureLoaded() || (!history.isEnabled() && !setHistoryLimit(1))) return false;
+    autosaver.start(path, interval, dirtyRecords);
+    // The first save covers the whole store.
+    unsaved_changes = max<size_t>(unsaved_changes, 1);
+    publishVersion();
+    return true;
+}
+
+void Manager::stopAutosave() { autosaver.stop(); }
+
+bool Manager::isAutosaving() const { return autosaver.isRunning(); }
+
+bool Manager::flushAutosave() { return autosaver.flush(); }
+
+bool Manager::openStore(const string& basePath) {
+    if (!ensureLoaded()) return false;
+    journal.close();
+    store_path = basePath;
+    const string snapFile = basePath + ".snap";
+    const string walFile = basePath + ".wal";
+
+    if (filesystem::exists(snapFile) && !(loadSnapshot(snapFile) && ensureLoaded())) return false;
+
+    bool clean = true;
+    JournalReader reader;
+    if (reader.open(walFile)) {
+        JournalEntry entry;
+        while (reader.next(entry)) applyJournalEntry(entry);
+        clean = reader.reachedCleanEnd();
+    }
+    else if (filesystem::exists(walFile)) {
+        clean = false;
+    }
+    if (history.isEnabled()) {
+        history.reset("open " + basePath);
+        publishVersion();
+    }
+
+    if (!journal.open(walFile)) return false;
+    // Entries after a torn tail would be unreachable, so start a fresh journal.
+    if (!clean) return compact();
+    return true;
+}
+
+bool Manager::compact() {
+    if (store_path.empty() || !journal.isOpen()) return false;
+    journal.flush();
+    // saveSnapshot replaces the file in one rename. A crash before the reset
+    // leaves the old journal beside it; its entries set absolute values, so
+    // replaying them over the new snapshot changes nothing.
+    if (!saveSnapshot(store_path + ".snap")) return false;
+    return journal.reset();
 }
 
+void Manager::flushJournal() {
+    if (!journal.isOpen()) return;
+    journal.flush();
+    if (journal.size() > compact_threshold) compact();
+}
+
+void Manager::setCompactThreshold(uint64_t bytes) { compact_threshold = bytes; }
+
 void Manager::addPipe() {
     cout << "Pipe name: ";
     string name;
@@ -236,15 +1084,16 @@ void Manager::editPipe() {
     cout << "Pipe ID to edit: ";
     int id = GetCorrectNumber(1, 10000);
 
-    if (!pipes.contains(id)) {
+    optional<Pipe> p = getPipeById(id);
+    if (!p) {
         cout << "Pipe with this ID not found\n";
         return;
     }
-    cout << "Current data:\n" << pipes[id] << "\n";
+    cout << "Current data:\n" << *p << "\n";
 
     cout << "In repair? (1-yes/0-no/2-no change): ";
     int repairChoice = GetCorrectNumber(0, 2);
-    pipes[id].setInRepair(repairChoice);
+    if (repairChoice != 2) setPipeInRepair(id, repairChoice == 1);
     //if (repairChoice == 0) {
     //    p.setInRepair(false);
     //    cout << "Repair status set to: NO\n";
@@ -262,35 +1111,45 @@ void Manager::deletePipe() {
     if (removePipeById(id)) cout << "Deleted.\n"; else cout << "Not found.\n";
 }
 
+bool Manager::readQuery(QueryTarget target, IdList& ids) {
+    cout << "Query: ";
+    string text;
+    INPUT_LINE(cin, text);
+
+    QueryExpr expr;
+    string error;
+    if (!expr.parse(text, target, &error)) {
+        cout << "Bad query: " << error << "\n";
+        return false;
+    }
+    ids = target == QueryTarget::Pipes ? findPipeIds(expr) : findStationIds(expr);
+    return true;
+}
+
 void Manager::batchEditPipesUI() {
     cout << "Search pipes for batch editing:\n";
     cout << "1. By name\n";
     cout << "2. By repair status\n";
     cout << "3. By IDs\n";
+    cout << "4. By query (e.g. in repair AND diameter > 1000 AND name contains north)\n";
     cout << "Choice: ";
 
-    int choice = GetCorrectNumber(1, 3);
+    int choice = GetCorrectNumber(1, 4);
 
-    set<int> ids;
+    IdList ids;
 
     if (choice == 1) {
         cout << "Enter substring of name: ";
         string q;
         INPUT_LINE(cin, q);
 
-        vector<Pipe> found = findPipesByName(q);
-        for (const auto& pipe : found) {
-            ids.insert(pipe.getId());
-        }
+        ids = findPipeIdsByName(q);
     }
     else if (choice == 2) {
         cout << "Search pipes in repair? (1-yes, 0-no): ";
         bool inRepair = GetCorrectNumber(0, 1) == 1;
 
-        vector<Pipe> found = findPipesByRepairFlag(inRepair);
-        for (const auto& pipe : found) {
-            ids.insert(pipe.getId());
-        }
+        ids = findPipeIdsByRepairFlag(inRepair);
     }
     else if (choice == 3) {
         cout << "Enter IDs (0 to finish):\n";
@@ -299,14 +1158,19 @@ void Manager::batchEditPipesUI() {
             int id = GetCorrectNumber(0, 10000);
             if (id == 0) break;
 
-            if (!pipes.contains(id)) {
+            if (!faultInPipe(id)) {
                 cout << "Pipe with ID " << id << " not found!\n";
             }
             else {
-                ids.insert(id);
+                ids.push_back(id);
                 cout << "Added pipe ID: " << id << "\n";
             }
         }
+        sort(ids.begin(), ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+    }
+    else if (choice == 4) {
+        if (!readQuery(QueryTarget::Pipes, ids)) return;
     }
     else {
         cout << "Invalid choice.\n";
@@ -326,15 +1190,129 @@ void Manager::batchEditPipesUI() {
 
     cout << "Confirm? (1-yes, 0-no): ";
     if (GetCorrectNumber(0, 1) == 1) {
-        vector<int> idVector(ids.begin(), ids.end());
-        batchEditPipes(idVector, newStatus ? 1 : 0);
+        batchEditPipes(ids, newStatus ? 1 : 0);
         cout << "Updated " << ids.size() << " pipes.\n";
     }
 }
 
+void Manager::connectPipeUI() {
+    cout << "Pipe ID to connect: ";
+    int id = GetCorrectNumber(1, 10000);
+    if (!faultInPipe(id)) {
+        cout << "Pipe with this ID not found\n";
+        return;
+    }
+    cout << "From station ID (0 to disconnect): ";
+    int from = GetCorrectNumber(0, 10000);
+    if (from == 0) {
+        if (disconnectPipe(id)) cout << "Disconnected.\n"; else cout << "Pipe was not connected.\n";
+        return;
+    }
+    cout << "To station ID: ";
+    int to = GetCorrectNumber(1, 10000);
+    if (connectPipe(id, from, to)) cout << "Connected.\n";
+    else cout << "Both stations must exist and be different.\n";
+}
+
+void Manager::networkUI() {
+    cout << "Network queries:\n";
+    cout << "1. Stations reachable from a station\n";
+    cout << "2. Topological order\n";
+    cout << "3. Connected groups\n";
+    cout << "4. Max throughput between stations\n";
+    cout << "Choice: ";
+    int choice = GetCorrectNumber(1, 4);
+
+    if (choice == 1) {
+        cout << "Station ID: ";
+        IdList ids = findReachableStationIds(GetCorrectNumber(1, 10000));
+        cout << "Reachable stations: " << ids.size() << "\n";
+        print_by_ids(cout, stations, ids);
+    }
+    else if (choice == 2) {
+        IdList order;
+        if (!findStationTopologicalOrder(order)) {
+            cout << "The network has a cycle.\n";
+            return;
+        }
+        for (int id : order) cout << id << " ";
+        cout << "\n";
+    }
+    else if (choice == 4) {
+        cout << "From station ID: ";
+        int from = GetCorrectNumber(1, 10000);
+        cout << "To station ID: ";
+        int to = GetCorrectNumber(1, 10000);
+        IdList bottleneck;
+        int64_t value = findMaxFlow(from, to, &bottleneck);
+        if (value < 0) {
+            cout << "Both stations must exist.\n";
+            return;
+        }
+        cout << "Max throughput: " << value << "\n";
+        if (!bottleneck.empty()) {
+            cout << "Bottleneck pipes:\n";
+            print_by_ids(cout, pipes, bottleneck);
+        }
+    }
+    else {
+        vector<IdList> groups = findConnectedStationGroups();
+        cout << "Groups: " << groups.size() << "\n";
+        for (const IdList& group : groups) {
+            for (int id : group) cout << id << " ";
+            cout << "\n";
+        }
+    }
+}
+
+namespace {
+
+// Standard output's descriptor in both the POSIX and the MSVC runtime.
+const int STDOUT_FD = 1;
+
+// Prints everything in one go.
+template <typename Print>
+void listAll(Print print) {
+    cout.flush();
+    fflush(stdout);
+    OutputBuffer out(STDOUT_FD);
+    print(ListOptions(), out);
+}
+
+// Asks for order and page size, then prints page after page while the user wants more.
+template <typename Print>
+void listPaged(size_t total, Print print) {
+    ListOptions options;
+    cout << "Sorted by ID? (1 - yes/0 - no): ";
+    options.sorted_by_id = GetCorrectNumber(0, 1) == 1;
+    cout << "Records per page (0 - all): ";
+    options.limit = static_cast<size_t>(GetCorrectNumber(0, 100000000));
+    while (true) {
+        // Whatever cout holds must come out before the direct writes.
+        cout.flush();
+        fflush(stdout);
+        {
+            OutputBuffer out(STDOUT_FD);
+            options.offset += print(options, out);
+        }
+        if (options.limit == 0 || options.offset >= total) break;
+        cout << "Shown " << options.offset << " of " << total << ". Next page? (1 - yes/0 - no): ";
+        if (GetCorrectNumber(0, 1) != 1) break;
+    }
+}
+
+}
+
 void Manager::listAllPipes() {
     cout << "Total pipes: " << getPipeCount() << "\n";
-    for (const auto& pair : getPipes()) cout << pair.second << "\n";
+    const PipeTable& table = getPipes();
+    listAll([&](const ListOptions& options, OutputBuffer& out) { return printPipes(table, options, out); });
+}
+
+void Manager::listPipePagesUI() {
+    cout << "Total pipes: " << getPipeCount() << "\n";
+    const PipeTable& table = getPipes();
+    listPaged(table.size(), [&](const ListOptions& options, OutputBuffer& out) { return printPipes(table, options, out); });
 }
 
 void Manager::addStation() {
@@ -369,12 +1347,12 @@ void Manager::addStation() {
 void Manager::editStation() {
     cout << "Compressor Station ID to edit: ";
     int id = GetCorrectNumber(1, 10000);
-    CompressorStation& s = getStationById(id);
-    if (s.getId() == 0) {
+    optional<CompressorStation> s = getStationById(id);
+    if (!s) {
         cout << "Not found.\n";
         return;
     }
-    cout << s << "\n";
+    cout << *s << "\n";
 
     cout << "New working: ";
     string work;
@@ -383,12 +1361,12 @@ void Manager::editStation() {
     if (!work.empty()) {
         try {
             int new_working = stoi(work);
-            if (new_working > s.getTotalWorkshops()) {
+            if (new_working > s->getTotalWorkshops()) {
                 cout << "Error: Working workshops (" << new_working
-                    << ") cannot be more than total workshops (" << s.getTotalWorkshops() << ")\n";
+                    << ") cannot be more than total workshops (" << s->getTotalWorkshops() << ")\n";
             }
             else {
-                s.setWorkingWorkshops(new_working);
+                setStationWorking(id, new_working);
                 cout << "Working workshops updated to: " << new_working << endl;
             }
         }
@@ -410,48 +1388,55 @@ void Manager::batchEditStationsUI() {
     cout << "Search stations by:\n";
     cout << "1. By name\n";
     cout << "2. By idle percent\n";
-    cout << "3. By IDs\n";
+    cout << "3. By classification\n";
+    cout << "4. By IDs\n";
+    cout << "5. By query (e.g. idle >= 50 AND NOT class = main)\n";
     cout << "Choice: ";
 
-    int choice = GetCorrectNumber(1, 3);
+    int choice = GetCorrectNumber(1, 5);
 
-    set<int> ids;
+    IdList ids;
 
     if (choice == 1) {
         cout << "Enter substring of name: ";
         string q;
         INPUT_LINE(cin, q);
 
-        vector<CompressorStation> found = findStationsByName(q);
-        for (const auto& station : found) {
-            ids.insert(station.getId());
-        }
+        ids = findStationIdsByName(q);
     }
     else if (choice == 2) {
         cout << "Minimum idle percent (0-100): ";
         double perc = GetCorrectNumber(0.0, 100.0);
 
-        vector<CompressorStation> found = findStationsByIdlePercent(perc);
-        for (const auto& station : found) {
-            ids.insert(station.getId());
-        }
+        ids = findStationIdsByIdlePercent(perc);
     }
     else if (choice == 3) {
+        cout << "Enter classification: ";
+        string cls;
+        INPUT_LINE(cin, cls);
+
+        ids = findStationIdsByClass(cls);
+    }
+    else if (choice == 4) {
         cout << "Enter IDs (0 to finish):\n";
         while (true) {
             cout << "ID: ";
             int inputId = GetCorrectNumber(0, 10000);
             if (inputId == 0) break;
 
-            CompressorStation& station = getStationById(inputId);
-            if (station.getId() == 0) {
+            if (!faultInStation(inputId)) {
                 cout << "Station with ID " << inputId << " not found!\n";
             }
             else {
-                ids.insert(inputId);
+                ids.push_back(inputId);
                 cout << "Added station ID: " << inputId << "\n";
             }
         }
+        sort(ids.begin(), ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+    }
+    else if (choice == 5) {
+        if (!readQuery(QueryTarget::Stations, ids)) return;
     }
 
     if (ids.empty()) {
@@ -460,8 +1445,8 @@ void Manager::batchEditStationsUI() {
     }
 
     cout << "\nSelected " << ids.size() << " stations:\n";
-    for (int id : ids) {
-        cout << getStationById(id) << "\n";
+    for (const CompressorStation& s : getStationsByIds(ids)) {
+        cout << s << "\n";
     }
 
     cout << "\nChange working workshops:\n";
@@ -481,8 +1466,7 @@ void Manager::batchEditStationsUI() {
 
     cout << "Confirm? (1-yes, 0-no): ";
     if (GetCorrectNumber(0, 1) == 1) {
-        vector<int> idVector(ids.begin(), ids.end());
-        batchEditStations(idVector, workingStationsFlag);
+        batchEditStations(ids, workingStationsFlag);
         cout << "Updated " << ids.size() << " stations.\n";
     }
     else {
@@ -492,19 +1476,142 @@ void Manager::batchEditStationsUI() {
 
 void Manager::listAllStations() {
     cout << "Total stations: " << getStationCount() << "\n";
-    for (const auto& pair : getStations()) cout << pair.second << "\n";
+    const StationTable& table = getStations();
+    listAll([&](const ListOptions& options, OutputBuffer& out) { return printStations(table, options, out); });
+}
+
+void Manager::listStationPagesUI() {
+    cout << "Total stations: " << getStationCount() << "\n";
+    const StationTable& table = getStations();
+    listPaged(table.size(), [&](const ListOptions& options, OutputBuffer& out) { return printStations(table, options, out); });
+}
+
+void Manager::statisticsUI() {
+    const NetworkStats& st = getStats();
+    cout << fixed << setprecision(1);
+    cout << "Pipes: " << st.pipeCount() << " (in repair " << st.pipesInRepair()
+        << ", working " << st.workingPipes() << ")\n";
+    cout << "Average diameter: " << st.averageDiameter() << " mm\n";
+    for (size_t i = 0; i < NetworkStats::DIAMETER_BUCKETS; ++i) {
+        int low = i ? static_cast<int>(NetworkStats::DIAMETER_BOUNDS[i - 1]) : 0;
+        cout << "  " << low;
+        if (i + 1 < NetworkStats::DIAMETER_BUCKETS) cout << "-" << static_cast<int>(NetworkStats::DIAMETER_BOUNDS[i]);
+        else cout << "+";
+        cout << " mm: " << st.diameterHistogram()[i] << "\n";
+    }
+    cout << "Stations: " << st.stationCount() << ", workshops " << st.workingWorkshops()
+        << " working of " << st.totalWorkshops() << "\n";
+    cout << "Average idle: " << st.averageIdlePercent() << "% per station, "
+        << st.overallIdlePercent() << "% of all workshops\n";
+    for (size_t i = 0; i < NetworkStats::IDLE_BUCKETS; ++i) {
+        cout << "  idle " << i * 10 << "-" << (i + 1) * 10 << "%: " << st.idleHistogram()[i] << "\n";
+    }
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+}
+
+void Manager::historyUI() {
+    if (!history.isEnabled()) {
+        cout << "History is off (start with --history <versions>).\n";
+        return;
+    }
+    shared_ptr<const StoreVersion> current = getCurrentVersion();
+    for (const shared_ptr<const StoreVersion>& v : getVersions()) {
+        cout << (v == current ? "* " : "  ") << v->getNumber() << ": " << v->getLabel()
+            << " (" << v->pipeCount() << " pipes, " << v->stationCount() << " stations)\n";
+    }
+    cout << "1. Undo\n";
+    cout << "2. Redo\n";
+    cout << "3. Compare two versions\n";
+    cout << "0. Back\n";
+    cout << "Choice: ";
+    int choice = GetCorrectNumber(0, 3);
+
+    if (choice == 1) {
+        cout << (undo() ? "Undone.\n" : "Nothing to undo.\n");
+    }
+    else if (choice == 2) {
+        cout << (redo() ? "Redone.\n" : "Nothing to redo.\n");
+    }
+    else if (choice == 3) {
+        cout << "From version: ";
+        int from = GetCorrectNumber(1, 1000000);
+        cout << "To version: ";
+        int to = GetCorrectNumber(1, 1000000);
+        VersionDiff diff;
+        if (!diffVersions(from, to, diff)) {
+            cout << "No such version.\n";
+            return;
+        }
+        auto show = [](const char* what, const IdList& ids) {
+            if (ids.empty()) return;
+            cout << what << ":";
+            for (int id : ids) cout << " " << id;
+            cout << "\n";
+        };
+        cout << "Changed records: " << diff.size() << "\n";
+        show("Pipes added", diff.pipes_added);
+        show("Pipes removed", diff.pipes_removed);
+        show("Pipes changed", diff.pipes_changed);
+        show("Stations added", diff.stations_added);
+        show("Stations removed", diff.stations_removed);
+        show("Stations changed", diff.stations_changed);
+    }
+}
+
+void Manager::autosaveUI() {
+    if (isAutosaving()) {
+        cout << "Autosaving to " << autosaver.getPath() << ", " << autosaver.saveCount() << " saves so far"
+            << (autosaver.lastSaveOk() ? "" : ", the last one FAILED") << ".\n";
+        cout << "1. Change\n";
+        cout << "2. Turn off\n";
+        cout << "0. Back\n";
+        cout << "Choice: ";
+        int choice = GetCorrectNumber(0, 2);
+        if (choice == 0) return;
+        if (choice == 2) {
+            stopAutosave();
+            cout << "Autosave off.\n";
+            return;
+        }
+    }
+    cout << "Autosave file (*.snap for binary snapshot, *.lpk for packed): ";
+    string fname;
+    INPUT_LINE(cin, fname);
+    cout << "Interval in seconds (0 = by changes only): ";
+    int seconds = GetCorrectNumber(0, 86400);
+    cout << "Save after this many changed records (0 = by time only): ";
+    int records = GetCorrectNumber(0, 100000000);
+    if (seconds == 0 && records == 0) {
+        cout << "Either an interval or a record count is needed.\n";
+        return;
+    }
+    if (startAutosave(fname, chrono::seconds(seconds), static_cast<size_t>(records))) cout << "Autosave on.\n";
+    else cout << "Error: the rest of the lazily opened file could not be read.\n";
 }
 
 void Manager::saveToFileUI() {
-    cout << "Enter filename to save: ";
+    cout << "Enter filename to save (*.snap for binary snapshot, *.lpk for packed): ";
     string fname;
     INPUT_LINE(cin, fname);
-    if (saveToFile(fname)) cout << "Saved.\n"; else cout << "Error saving.\n";
+    bool ok = saveAnyFormat(fname);
+    if (ok) cout << "Saved.\n"; else cout << "Error saving.\n";
 }
 
 void Manager::loadFromFileUI() {
     cout << "Enter filename to load: ";
     string fname;
     INPUT_LINE(cin, fname);
-    if (loadFromFile(fname)) cout << "Loaded.\n"; else cout << "Error loading.\n";
+    bool ok = loadAnyFormat(fname);
+    if (ok) cout << "Loaded.\n"; else cout << "Error loading.\n";
+}
+
+void Manager::openLazyUI() {
+    cout << "Enter text file to open (records are read on demand): ";
+    string fname;
+    INPUT_LINE(cin, fname);
+    cout << "Page cache in MB: ";
+    size_t mb = static_cast<size_t>(GetCorrectNumber(1, 1 << 20));
+    bool ok = !isSnapshotFile(fname) && !isPackedFile(fname) && openLazy(fname, mb << 20);
+    if (ok) cout << "Opened.\n"; else cout << "Error opening.\n";
 }
\ No newline at end of file
@@ -3,22 +3,130 @@
 
 #include "Pipe.h"
 #include "CompressorStation.h"
+#include "PipeTable.h"
+#include "StationTable.h"
+#include "Journal.h"
+#include "TrigramIndex.h"
+#include "IdleIndex.h"
+#include "Network.h"
+#include "FlowSolver.h"
+#include "NetworkStats.h"
+#include "VersionHistory.h"
+#include "AutoSave.h"
+#include "PagedStore.h"
+#include "Snapshot.h"
+#include "Query.h"
+#include "QueryExpr.h"
 #include <vector>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <iterator>
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
 #include "Utils.h"
 
 using namespace std;
 
+// Query result: ids sorted ascending unless a function says otherwise.
+typedef std::vector<int> IdList;
+
+// Bulk-ingest records; the views only have to outlive the add call.
+struct PipeSpec {
+    std::string_view name;
+    double diameter;
+    bool in_repair;
+};
+
+struct StationSpec {
+    std::string_view name;
+    int total;
+    int working;
+    std::string_view classification;
+};
+
 class Manager {
+    // Shards are plain Managers filled through the apply* helpers.
+    friend class ConcurrentManager;
+
 private:
-    std::unordered_map<int, Pipe> pipes;
-    std::unordered_map<int, CompressorStation> stations;
+    PipeTable pipes;
+    StationTable stations;
 
     int next_pipe_id;
     int next_station_id;
 
+    TrigramIndex pipe_names;
+    TrigramIndex station_names;
+    IdleIndex station_idle;
+    NetworkStats stats;
+    // Off until setHistoryLimit(); 'history_replay' pauses tracking while
+    // undo/redo rewrites the tables.
+    VersionHistory history;
+    bool history_replay;
+    // Records tracked since the last version went to the autosaver.
+    size_t unsaved_changes;
+    Network network;
+    // Max-flow state reused between queries: rebuilt when the topology
+    // changes, updated in place for repair flag changes.
+    FlowSolver flow;
+    uint64_t flow_version;
+    std::vector<int> flow_changes;
+
+    // Lazy-open mode: records of 'lazy' (a text file) or 'lazy_snapshot'
+    // (a mapped snapshot) not yet in the tables are read on demand. Ids in
+    // the 'taken' sets moved into the tables (and may have been removed
+    // since); the file's copy no longer counts.
+    PagedStore lazy;
+    SnapshotReader lazy_snapshot;
+    std::unordered_set<int> lazy_taken_pipes;
+    std::unordered_set<int> lazy_taken_stations;
+    size_t lazy_history_limit;
+
+    Journal journal;
+    std::string store_path;
+    uint64_t compact_threshold;
+    // Last member: its worker stops before anything it could read goes away.
+    AutoSaver autosaver;
+
+    // Mutations without journaling; used directly by journal replay.
+    void applyAddPipe(int id, std::string_view name, double diameter, bool in_repair);
+    bool applyRemovePipe(int id);
+    bool applyPipeRepair(int id, bool in_repair);
+    void applyBatchPipes(const std::vector<int>& ids, int changeRepairFlag);
+    bool applyConnectPipe(int id, int in_station, int out_station);
+    void applyAddStation(int id, std::string_view name, int total, int working, ClassId classification);
+    bool applyRemoveStation(int id);
+    bool applyStationWorking(int id, int working);
+    void applyBatchStations(const std::vector<int>& ids, int workingStationsFlag);
+    // Working count after one +1/-1 step at the station, or -1 if it stays.
+    int steppedWorking(int id, int workingStationsFlag) const;
+    void applyJournalEntry(const JournalEntry& entry);
+    void afterBulkLoad();
+    void rebuildIndexes();
+    // Mirror one record (or its absence) into the live history maps.
+    void trackPipe(int id);
+    void trackStation(int id);
+    void trackAll();
+    void commitVersion(const std::string& label);
+    void publishVersion();
+    bool stepHistory(bool forward);
+    // A record still only in the lazy file; false if there is none.
+    bool lazyPipe(int id, Pipe& p) const;
+    bool lazyStation(int id, CompressorStation& s) const;
+    size_t lazyPipeCount() const;
+    size_t lazyStationCount() const;
+    // Copies the snapshot's records that are not in the tables and were not taken.
+    void copySnapshot(const SnapshotReader& reader);
+    // Move a lazily opened record into the tables; true if it is there now.
+    bool faultInPipe(int id);
+    bool faultInStation(int id);
+    // Whole-store operations call this first; it reads whatever is left in
+    // the lazy file. False if that failed: the manager stays lazy, holding
+    // only the records faulted in so far, and a later call tries again.
+    bool ensureLoaded();
+    void closeLazy();
 
 public:
     Manager();
@@ -28,40 +136,169 @@ public:
 
     int addPipe(const std::string& name, double diameter, bool in_repair);
     int addPipe(const Pipe& pipe);
+    // Bulk add: generator(i) is called once per record in order, the new
+    // records get consecutive ids. Returns the first id.
+    int addPipes(size_t count, const std::function<PipeSpec(size_t)>& generator);
+    template <typename Range>
+    int addPipes(const Range& specs) {
+        auto it = std::begin(specs);
+        return addPipes(static_cast<size_t>(std::distance(std::begin(specs), std::end(specs))),
+            [&](size_t) { return PipeSpec(*it++); });
+    }
     bool removePipeById(int id);
 
+    IdList findPipeIdsByName(const std::string& substring);
+    IdList findPipeIdsByRepairFlag(bool in_repair);
+    // Fused scan with a query:: combinator, e.g. query::inRepair() && query::nameContains("x").
+    template <typename P>
+    IdList findPipeIdsWhere(const query::Predicate<P>& pred) {
+        ensureLoaded();
+        return query::select(pipes, pred);
+    }
+    // Runtime query; a name substring required by the whole expression is
+    // looked up in the trigram index first.
+    IdList findPipeIds(QueryExpr expr);
     std::vector<Pipe> findPipesByName(const std::string& substring);
     std::vector<Pipe> findPipesByRepairFlag(bool in_repair);
-    const std::unordered_map<int, Pipe>& getPipes() const;
+    // Empty when there is no such pipe.
+    std::optional<Pipe> getPipeById(int id) const;
+    std::vector<Pipe> getPipesByIds(const IdList& ids) const;
+    bool setPipeInRepair(int id, bool in_repair);
+    const PipeTable& getPipes();
     size_t getPipeCount() const;
 
+    // Pipe runs from in_station to out_station; both must exist and differ.
+    // Reconnecting replaces the previous endpoints.
+    bool connectPipe(int id, int in_station, int out_station);
+    bool disconnectPipe(int id);
+    // Stations reachable along pipe direction, the start included.
+    IdList findReachableStationIds(int stationId);
+    // Every pipe runs forward in the order; false if the network has a cycle.
+    bool findStationTopologicalOrder(IdList& order);
+    // Stations linked by pipes in either direction, grouped.
+    std::vector<IdList> findConnectedStationGroups();
+    // Max gas throughput from source to sink over working pipes (capacity
+    // grows with diameter^2.5); -1 if a station is unknown. 'bottleneck'
+    // receives the saturated pipes of a minimum cut.
+    int64_t findMaxFlow(int source, int sink, IdList* bottleneck = nullptr);
+    const Network& getNetwork();
+
+    // Counts, sums and histograms maintained on every change; O(1) to read.
+    const NetworkStats& getStats();
+
     int addStation(const std::string& name, int total, int working, const std::string& classification);
     int addStation(const CompressorStation& station);
+    int addStations(size_t count, const std::function<StationSpec(size_t)>& generator);
+    template <typename Range>
+    int addStations(const Range& specs) {
+        auto it = std::begin(specs);
+        return addStations(static_cast<size_t>(std::distance(std::begin(specs), std::end(specs))),
+            [&](size_t) { return StationSpec(*it++); });
+    }
     bool removeStationById(int id);
-    CompressorStation& getStationById(int id);
+    std::optional<CompressorStation> getStationById(int id) const;
+    bool setStationWorking(int id, int working);
+    IdList findStationIdsByName(const std::string& substring);
+    // Exact classification match; compares interned handles only.
+    IdList findStationIdsByClass(const std::string& classification);
+    IdList findStationIdsByIdlePercent(double minIdlePercent);
+    IdList findStationIdsByIdleRange(double minIdlePercent, double maxIdlePercent);
+    // Most idle first.
+    IdList findMostIdleStationIds(size_t k);
+    template <typename P>
+    IdList findStationIdsWhere(const query::Predicate<P>& pred) {
+        ensureLoaded();
+        return query::select(stations, pred);
+    }
+    IdList findStationIds(QueryExpr expr);
     std::vector<CompressorStation> findStationsByName(const std::string& substring);
+    std::vector<CompressorStation> findStationsByClass(const std::string& classification);
     std::vector<CompressorStation> findStationsByIdlePercent(double minIdlePercent);
-    const std::unordered_map<int, CompressorStation>& getStations() const;
+    std::vector<CompressorStation> findStationsByIdleRange(double minIdlePercent, double maxIdlePercent);
+    std::vector<CompressorStation> findMostIdleStations(size_t k);
+    std::vector<CompressorStation> getStationsByIds(const IdList& ids) const;
+    const StationTable& getStations();
     size_t getStationCount() const;
 
     bool saveToFile(const std::string& filename);
     bool loadFromFile(const std::string& filename);
+    bool loadFromFileSerial(const std::string& filename);
+    bool saveSnapshot(const std::string& filename);
+    // Maps the snapshot and reads records from it like openLazy until a
+    // whole-store operation copies the rest; with a journal or autosave
+    // active everything is copied at once.
+    bool loadSnapshot(const std::string& filename);
+    bool savePacked(const std::string& filename);
+    bool loadPacked(const std::string& filename);
+    // Format by extension (.snap binary snapshot, .lpk packed, else text)
+    // on save and by the file's magic on load.
+    bool saveAnyFormat(const std::string& filename);
+    bool loadAnyFormat(const std::string& filename);
+    // Opens a text file without reading its records: lookups and edits by
+    // id read the pages they need through a cache of 'cacheBytes'; queries
+    // over the whole store, saves and the history load the rest first.
+    // With a journal or autosave active this is a plain loadFromFile.
+    bool openLazy(const std::string& filename, size_t cacheBytes);
+    bool isLazy() const;
+    const PagedStore& getLazyStore() const;
 
     void batchEditPipes(const std::vector<int>& ids, int changeRepairFlag);
     void batchEditStations(const std::vector<int>& ids, int workingStationsFlag);
 
+    // Undo history: every public edit (a whole batch or bulk add counts as
+    // one) commits a version that shares all unchanged records with its
+    // predecessor. Loading a file starts a new history. 0 turns it off.
+    // False if a lazily opened file could not be read in full.
+    bool setHistoryLimit(size_t versions);
+    size_t getHistoryLimit() const;
+    // Rewrite the tables to the previous/next version, journaled like
+    // ordinary edits; cost follows the number of changed records.
+    bool undo();
+    bool redo();
+    // Versions stay readable after undo, later edits, or from other threads.
+    const std::vector<std::shared_ptr<const StoreVersion>>& getVersions() const;
+    std::shared_ptr<const StoreVersion> getVersion(uint64_t number) const;
+    std::shared_ptr<const StoreVersion> getCurrentVersion() const;
+    bool diffVersions(uint64_t from, uint64_t to, VersionDiff& out) const;
+
+    // Background saves of the current version to 'path' (see AutoSaver),
+    // after 'interval' or once 'dirtyRecords' records changed. Needs the
+    // history, which is turned on with one version if it was off. False if
+    // a lazily opened file could not be read in full.
+    bool startAutosave(const std::string& path, std::chrono::milliseconds interval, size_t dirtyRecords);
+    void stopAutosave();
+    bool isAutosaving() const;
+    // Waits for pending autosave writes; false if the last one failed.
+    bool flushAutosave();
+
+    // Persistent store: <base>.snap snapshot plus <base>.wal journal of later edits.
+    bool openStore(const std::string& basePath);
+    bool compact();
+    void flushJournal();
+    void setCompactThreshold(uint64_t bytes);
+
     void addPipe();
     void editPipe();
     void deletePipe();
+    // Reads a query line and runs it; false (after a message) if it does not parse.
+    bool readQuery(QueryTarget target, IdList& ids);
     void batchEditPipesUI();
+    void connectPipeUI();
+    void networkUI();
     void listAllPipes();
+    void listPipePagesUI();
     void addStation();
     void editStation();
     void deleteStation();
     void batchEditStationsUI();
     void listAllStations();
+    void listStationPagesUI();
+    void statisticsUI();
+    void historyUI();
+    void autosaveUI();
     void saveToFileUI();
     void loadFromFileUI();
+    void openLazyUI();
 };   
 
 #endif // MANAGER_H
@@ -0,0 +1,278 @@
+#include "Network.h"
+#include <algorithm>
+
+namespace {
+
+const size_t MIN_OVERLAY = 1024;
+const uint32_t NO_LABEL = UINT32_MAX;
+
+}
+
+Network::Network() : ordered(true), dead_nodes(0), built_nodes(0), dropped_count(0), overlay_size(0), changes(0) {
+    out_offsets.push_back(0);
+    in_offsets.push_back(0);
+}
+
+void Network::clear() {
+    ++changes;
+    node_ids.clear();
+    node_of.clear();
+    pipes.clear();
+    ordered = true;
+    dead_nodes = 0;
+    built_nodes = 0;
+    out_offsets.assign(1, 0);
+    in_offsets.assign(1, 0);
+    out_arcs.clear();
+    in_arcs.clear();
+    extra_out.clear();
+    extra_in.clear();
+    out_dropped.assign(out_arcs.size(), 0);
+    in_dropped.assign(in_arcs.size(), 0);
+    dropped_count = 0;
+    overlay_size = 0;
+}
+
+// Counting sort of the arcs by source (and by target for the reverse
+// direction). Nodes are only renumbered when stations were removed or added
+// out of id order.
+void Network::rebuild() {
+    ++changes;
+    if (dead_nodes > 0 || !ordered) {
+        std::vector<int> live;
+        live.reserve(node_of.size());
+        for (int id : node_ids) if (id != 0) live.push_back(id);
+        if (!ordered) std::sort(live.begin(), live.end());
+        for (uint32_t n = 0; n < live.size(); ++n) node_of[live[n]] = n;
+        std::vector<uint32_t> renumber(node_ids.size());
+        for (uint32_t n = 0; n < node_ids.size(); ++n) {
+            if (node_ids[n] != 0) renumber[n] = node_of[node_ids[n]];
+        }
+        for (auto& pair : pipes) {
+            pair.second.from = renumber[pair.second.from];
+            pair.second.to = renumber[pair.second.to];
+        }
+        node_ids.swap(live);
+        dead_nodes = 0;
+        ordered = true;
+    }
+
+    size_t n = node_ids.size();
+    out_offsets.assign(n + 1, 0);
+    in_offsets.assign(n + 1, 0);
+    for (const auto& pair : pipes) {
+        ++out_offsets[pair.second.from + 1];
+        ++in_offsets[pair.second.to + 1];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        out_offsets[i + 1] += out_offsets[i];
+        in_offsets[i + 1] += in_offsets[i];
+    }
+
+    out_arcs.resize(pipes.size());
+    in_arcs.resize(pipes.size());
+    std::vector<uint32_t> outPos(out_offsets.begin(), out_offsets.end() - 1);
+    std::vector<uint32_t> inPos(in_offsets.begin(), in_offsets.end() - 1);
+    for (const auto& pair : pipes) {
+        out_arcs[outPos[pair.second.from]++] = { pair.second.to, pair.first };
+        in_arcs[inPos[pair.second.to]++] = { pair.second.from, pair.first };
+    }
+
+    built_nodes = n;
+    extra_out.clear();
+    extra_in.clear();
+    out_dropped.assign(out_arcs.size(), 0);
+    in_dropped.assign(in_arcs.size(), 0);
+    dropped_count = 0;
+    overlay_size = 0;
+}
+
+void Network::assign(const std::vector<int>& stations, const std::vector<int>& pipeIds,
+    const std::vector<int>& from, const std::vector<int>& to) {
+    clear();
+    node_ids = stations;
+    node_of.reserve(stations.size());
+    for (uint32_t n = 0; n < stations.size(); ++n) node_of.emplace(stations[n], n);
+    pipes.reserve(pipeIds.size());
+    for (size_t i = 0; i < pipeIds.size(); ++i) {
+        if (from[i] == to[i]) continue;
+        auto f = node_of.find(from[i]), t = node_of.find(to[i]);
+        if (f != node_of.end() && t != node_of.end()) pipes[pipeIds[i]] = { f->second, t->second };
+    }
+    ordered = std::is_sorted(node_ids.begin(), node_ids.end());
+    rebuild();
+}
+
+void Network::noteChange() {
+    ++changes;
+    ++overlay_size;
+    if (overlay_size > std::max(MIN_OVERLAY, (built_nodes + out_arcs.size()) / 4)) rebuild();
+}
+
+void Network::dropArc(const std::vector<uint32_t>& offsets, const std::vector<Arc>& arcs,
+    std::vector<uint8_t>& dropped, uint32_t node, int pipe) {
+    for (uint32_t i = offsets[node]; i < offsets[node + 1]; ++i) {
+        if (arcs[i].pipe == pipe && !dropped[i]) {
+            dropped[i] = 1;
+            return;
+        }
+    }
+}
+
+bool Network::eraseArc(std::unordered_map<uint32_t, std::vector<Arc>>& extra, uint32_t node, int pipe) {
+    auto it = extra.find(node);
+    if (it == extra.end()) return false;
+    std::vector<Arc>& arcs = it->second;
+    for (size_t i = 0; i < arcs.size(); ++i) {
+        if (arcs[i].pipe == pipe) {
+            arcs[i] = arcs.back();
+            arcs.pop_back();
+            if (arcs.empty()) extra.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Network::addStation(int station) {
+    if (node_of.count(station)) return;
+    for (auto it = node_ids.rbegin(); it != node_ids.rend(); ++it) {
+        if (*it != 0) {
+            if (*it > station) ordered = false;
+            break;
+        }
+    }
+    node_of.emplace(station, static_cast<uint32_t>(node_ids.size()));
+    node_ids.push_back(station);
+    noteChange();
+}
+
+void Network::removeStation(int station) {
+    auto it = node_of.find(station);
+    if (it == node_of.end()) return;
+    node_ids[it->second] = 0;
+    node_of.erase(it);
+    ++dead_nodes;
+    noteChange();
+}
+
+void Network::connect(int pipe, int from, int to) {
+    disconnect(pipe);
+    uint32_t f = node_of.at(from), t = node_of.at(to);
+    pipes[pipe] = { f, t };
+    extra_out[f].push_back({ t, pipe });
+    extra_in[t].push_back({ f, pipe });
+    noteChange();
+}
+
+bool Network::disconnect(int pipe) {
+    auto it = pipes.find(pipe);
+    if (it == pipes.end()) return false;
+    Endpoints e = it->second;
+    if (eraseArc(extra_out, e.from, pipe)) {
+        eraseArc(extra_in, e.to, pipe);
+    } else {
+        dropArc(out_offsets, out_arcs, out_dropped, e.from, pipe);
+        dropArc(in_offsets, in_arcs, in_dropped, e.to, pipe);
+        ++dropped_count;
+    }
+    pipes.erase(it);
+    noteChange();
+    return true;
+}
+
+ptrdiff_t Network::nodeOf(int station) const {
+    auto it = node_of.find(station);
+    return it == node_of.end() ? -1 : static_cast<ptrdiff_t>(it->second);
+}
+
+std::vector<int> Network::pipesAt(int station) const {
+    std::vector<int> result;
+    auto it = node_of.find(station);
+    if (it == node_of.end()) return result;
+    auto collect = [&](const Arc& a) { result.push_back(a.pipe); };
+    forEachArc(out_offsets, out_arcs, out_dropped, extra_out, it->second, collect);
+    forEachArc(in_offsets, in_arcs, in_dropped, extra_in, it->second, collect);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<int> Network::reachableFrom(int station) const {
+    std::vector<int> result;
+    auto it = node_of.find(station);
+    if (it == node_of.end()) return result;
+
+    std::vector<uint8_t> seen(node_ids.size(), 0);
+    std::vector<uint32_t> queue(1, it->second);
+    seen[it->second] = 1;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        forEachArc(out_offsets, out_arcs, out_dropped, extra_out, queue[head], [&](const Arc& a) {
+            if (!seen[a.node]) {
+                seen[a.node] = 1;
+                queue.push_back(a.node);
+            }
+        });
+    }
+    result.reserve(queue.size());
+    for (uint32_t n : queue) result.push_back(node_ids[n]);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// Kahn's algorithm over the in-degrees.
+bool Network::topologicalOrder(std::vector<int>& order) const {
+    order.clear();
+    std::vector<uint32_t> indegree(node_ids.size(), 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(node_of.size());
+    for (uint32_t n = 0; n < node_ids.size(); ++n) {
+        if (node_ids[n] == 0) continue;
+        forEachArc(out_offsets, out_arcs, out_dropped, extra_out, n, [&](const Arc& a) { ++indegree[a.node]; });
+    }
+    for (uint32_t n = 0; n < node_ids.size(); ++n) {
+        if (node_ids[n] != 0 && indegree[n] == 0) queue.push_back(n);
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        forEachArc(out_offsets, out_arcs, out_dropped, extra_out, queue[head], [&](const Arc& a) {
+            if (--indegree[a.node] == 0) queue.push_back(a.node);
+        });
+    }
+    if (queue.size() != node_of.size()) return false;
+    order.reserve(queue.size());
+    for (uint32_t n : queue) order.push_back(node_ids[n]);
+    return true;
+}
+
+std::vector<std::vector<int>> Network::components() const {
+    std::vector<uint32_t> label(node_ids.size(), NO_LABEL);
+    std::vector<uint32_t> queue;
+    uint32_t count = 0;
+    for (uint32_t start = 0; start < node_ids.size(); ++start) {
+        if (node_ids[start] == 0 || label[start] != NO_LABEL) continue;
+        label[start] = count;
+        queue.assign(1, start);
+        auto visit = [&](const Arc& a) {
+            if (label[a.node] == NO_LABEL) {
+                label[a.node] = count;
+                queue.push_back(a.node);
+            }
+        };
+        for (size_t head = 0; head < queue.size(); ++head) {
+            forEachArc(out_offsets, out_arcs, out_dropped, extra_out, queue[head], visit);
+            forEachArc(in_offsets, in_arcs, in_dropped, extra_in, queue[head], visit);
+        }
+        ++count;
+    }
+
+    // Labels were handed out in node order, so with ordered nodes both the
+    // components and their members come out ascending without sorting.
+    std::vector<std::vector<int>> result(count);
+    for (uint32_t n = 0; n < node_ids.size(); ++n) {
+        if (node_ids[n] != 0) result[label[n]].push_back(node_ids[n]);
+    }
+    if (!ordered) {
+        for (std::vector<int>& c : result) std::sort(c.begin(), c.end());
+        std::sort(result.begin(), result.end());
+    }
+    return result;
+}
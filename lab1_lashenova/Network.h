@@ -0,0 +1,124 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+// Pipeline topology: stations are nodes, every connected pipe is an arc
+// from its in station to its out station. Arcs are kept in CSR form (one
+// array per direction, indexed by dense node number) plus an overlay of the
+// changes since the last build; the overlay is folded into a fresh CSR once
+// it outgrows a fraction of the graph, so each change costs amortized O(1)
+// and the queries below stay linear in nodes + arcs.
+class Network {
+public:
+    struct Arc {
+        uint32_t node;
+        int pipe;
+    };
+
+private:
+    struct Endpoints {
+        uint32_t from;
+        uint32_t to;
+    };
+
+    // Dense node -> station id, 0 for stations removed since the last build.
+    std::vector<int> node_ids;
+    std::unordered_map<int, uint32_t> node_of;
+    // Connected pipe -> its end nodes.
+    std::unordered_map<int, Endpoints> pipes;
+    // Node numbers follow station ids (true right after a build).
+    bool ordered;
+    size_t dead_nodes;
+
+    // CSR over nodes [0, built_nodes).
+    size_t built_nodes;
+    std::vector<uint32_t> out_offsets;
+    std::vector<Arc> out_arcs;
+    std::vector<uint32_t> in_offsets;
+    std::vector<Arc> in_arcs;
+
+    // Overlay: arcs added since the build, and tombstones for built arcs
+    // that are gone (parallel to out_arcs / in_arcs).
+    std::unordered_map<uint32_t, std::vector<Arc>> extra_out;
+    std::unordered_map<uint32_t, std::vector<Arc>> extra_in;
+    std::vector<uint8_t> out_dropped;
+    std::vector<uint8_t> in_dropped;
+    size_t dropped_count;
+    size_t overlay_size;
+    uint64_t changes;
+
+    void noteChange();
+    static bool eraseArc(std::unordered_map<uint32_t, std::vector<Arc>>& extra, uint32_t node, int pipe);
+    static void dropArc(const std::vector<uint32_t>& offsets, const std::vector<Arc>& arcs,
+        std::vector<uint8_t>& dropped, uint32_t node, int pipe);
+
+    template <typename F>
+    void forEachArc(const std::vector<uint32_t>& offsets, const std::vector<Arc>& arcs, const std::vector<uint8_t>& dropped,
+        const std::unordered_map<uint32_t, std::vector<Arc>>& extra, uint32_t node, F f) const {
+        if (node < built_nodes) {
+            for (uint32_t i = offsets[node]; i < offsets[node + 1]; ++i) {
+                if (dropped_count == 0 || !dropped[i]) f(arcs[i]);
+            }
+        }
+        if (!extra.empty()) {
+            auto it = extra.find(node);
+            if (it != extra.end()) for (const Arc& a : it->second) f(a);
+        }
+    }
+
+public:
+    Network();
+
+    void clear();
+    // Folds the overlay in: nodes are renumbered by ascending station id.
+    void rebuild();
+    // Replaces the whole graph in one build. Pipes with a zero or unknown
+    // endpoint are left unconnected.
+    void assign(const std::vector<int>& stations, const std::vector<int>& pipeIds,
+        const std::vector<int>& from, const std::vector<int>& to);
+
+    void addStation(int station);
+    // The station must not have connected pipes left.
+    void removeStation(int station);
+    bool hasStation(int station) const { return node_of.count(station) > 0; }
+
+    // Replaces any previous connection of the pipe. Both stations must exist.
+    void connect(int pipe, int from, int to);
+    bool disconnect(int pipe);
+    bool isConnected(int pipe) const { return pipes.count(pipe) > 0; }
+
+    size_t stationCount() const { return node_of.size(); }
+    size_t arcCount() const { return pipes.size(); }
+    // Bumped by every change; node numbers below stay valid while it holds.
+    uint64_t version() const { return changes; }
+
+    // Dense node numbers (removed stations keep a slot until the next build).
+    size_t nodeCount() const { return node_ids.size(); }
+    // Node of the station or -1.
+    ptrdiff_t nodeOf(int station) const;
+    int stationAt(uint32_t node) const { return node_ids[node]; }
+    // f(from node, to node, pipe id) for every connected pipe.
+    template <typename F>
+    void forEachPipe(F f) const {
+        for (uint32_t n = 0; n < node_ids.size(); ++n) {
+            if (node_ids[n] == 0) continue;
+            forEachArc(out_offsets, out_arcs, out_dropped, extra_out, n, [&](const Arc& a) { f(n, a.node, a.pipe); });
+        }
+    }
+
+    // Pipes entering or leaving the station.
+    std::vector<int> pipesAt(int station) const;
+    // Stations reachable from 'station' along pipe direction, itself included; ascending.
+    std::vector<int> reachableFrom(int station) const;
+    // Stations ordered so that every pipe runs forward; false if the network
+    // has a cycle.
+    bool topologicalOrder(std::vector<int>& order) const;
+    // Weakly connected components, each ascending, ordered by smallest id.
+    std::vector<std::vector<int>> components() const;
+};
+
+#endif // NETWORK_H
@@ -0,0 +1,117 @@
+#include "NetworkStats.h"
+#include <algorithm>
+#include <cmath>
+
+const double NetworkStats::DIAMETER_BOUNDS[NetworkStats::DIAMETER_BUCKETS - 1] = { 300, 500, 700, 1000, 1400 };
+
+namespace {
+
+const int64_t MILLION = 1000000;
+
+int64_t micrometres(double diameter) {
+    return std::llround(diameter * 1000.0);
+}
+
+}
+
+NetworkStats::NetworkStats() {
+    clear();
+}
+
+size_t NetworkStats::diameterBucket(double diameter) {
+    return std::upper_bound(DIAMETER_BOUNDS, DIAMETER_BOUNDS + DIAMETER_BUCKETS - 1, diameter) - DIAMETER_BOUNDS;
+}
+
+size_t NetworkStats::idleBucket(int total, int working) {
+    if (total <= 0) return 0;
+    int64_t bucket = (static_cast<int64_t>(total) - working) * IDLE_BUCKETS / total;
+    return static_cast<size_t>(std::clamp<int64_t>(bucket, 0, IDLE_BUCKETS - 1));
+}
+
+int64_t NetworkStats::idleMillionths(int total, int working) {
+    return total > 0 ? (static_cast<int64_t>(total) - working) * MILLION / total : 0;
+}
+
+void NetworkStats::clear() {
+    pipe_count = 0;
+    pipes_in_repair = 0;
+    diameter_um = 0;
+    diameter_hist.fill(0);
+    station_count = 0;
+    total_workshops = 0;
+    working_workshops = 0;
+    idle_millionths = 0;
+    idle_hist.fill(0);
+}
+
+void NetworkStats::addPipe(double diameter, bool in_repair) {
+    ++pipe_count;
+    pipes_in_repair += in_repair;
+    diameter_um += micrometres(diameter);
+    ++diameter_hist[diameterBucket(diameter)];
+}
+
+void NetworkStats::removePipe(double diameter, bool in_repair) {
+    --pipe_count;
+    pipes_in_repair -= in_repair;
+    diameter_um -= micrometres(diameter);
+    --diameter_hist[diameterBucket(diameter)];
+}
+
+void NetworkStats::setPipeRepair(bool was_in_repair, bool in_repair) {
+    pipes_in_repair += static_cast<int>(in_repair) - static_cast<int>(was_in_repair);
+}
+
+void NetworkStats::addStation(int total, int working) {
+    ++station_count;
+    total_workshops += total;
+    working_workshops += working;
+    idle_millionths += idleMillionths(total, working);
+    ++idle_hist[idleBucket(total, working)];
+}
+
+void NetworkStats::removeStation(int total, int working) {
+    --station_count;
+    total_workshops -= total;
+    working_workshops -= working;
+    idle_millionths -= idleMillionths(total, working);
+    --idle_hist[idleBucket(total, working)];
+}
+
+void NetworkStats::setStationWorking(int total, int oldWorking, int newWorking) {
+    working_workshops += newWorking - oldWorking;
+    idle_millionths += idleMillionths(total, newWorking) - idleMillionths(total, oldWorking);
+    --idle_hist[idleBucket(total, oldWorking)];
+    ++idle_hist[idleBucket(total, newWorking)];
+}
+
+void NetworkStats::rebuild(const std::vector<double>& diameters, const std::vector<uint8_t>& repair,
+    const std::vector<int32_t>& totals, const std::vector<int32_t>& workings) {
+    clear();
+    for (size_t i = 0; i < diameters.size(); ++i) addPipe(diameters[i], repair[i] != 0);
+    for (size_t i = 0; i < totals.size(); ++i) addStation(totals[i], workings[i]);
+}
+
+void NetworkStats::merge(const NetworkStats& other) {
+    pipe_count += other.pipe_count;
+    pipes_in_repair += other.pipes_in_repair;
+    diameter_um += other.diameter_um;
+    for (size_t i = 0; i < DIAMETER_BUCKETS; ++i) diameter_hist[i] += other.diameter_hist[i];
+    station_count += other.station_count;
+    total_workshops += other.total_workshops;
+    working_workshops += other.working_workshops;
+    idle_millionths += other.idle_millionths;
+    for (size_t i = 0; i < IDLE_BUCKETS; ++i) idle_hist[i] += other.idle_hist[i];
+}
+
+double NetworkStats::averageDiameter() const {
+    return pipe_count ? diameter_um / 1000.0 / pipe_count : 0.0;
+}
+
+double NetworkStats::averageIdlePercent() const {
+    return station_count ? idle_millionths / 10000.0 / station_count : 0.0;
+}
+
+double NetworkStats::overallIdlePercent() const {
+    return total_workshops > 0 ? 100.0 * (total_workshops - working_workshops) / total_workshops : 0.0;
+}
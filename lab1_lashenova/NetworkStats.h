@@ -0,0 +1,68 @@
+#ifndef NETWORKSTATS_H
+#define NETWORKSTATS_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Aggregates over all pipes and stations, kept exact by Manager's apply*
+// helpers so reading them never scans the tables. Every value is an
+// integer sum (diameters in micrometres, idle ratios in millionths), so
+// removing a record subtracts exactly what adding it contributed.
+class NetworkStats {
+public:
+    // Pipe diameter buckets in mm: [0, 300), [300, 500), ... [1400, inf).
+    static const size_t DIAMETER_BUCKETS = 6;
+    static const double DIAMETER_BOUNDS[DIAMETER_BUCKETS - 1];
+    // Station idle % buckets of 10%; 100% idle falls into the last one.
+    static const size_t IDLE_BUCKETS = 10;
+
+private:
+    uint64_t pipe_count;
+    uint64_t pipes_in_repair;
+    int64_t diameter_um;
+    std::array<uint64_t, DIAMETER_BUCKETS> diameter_hist;
+
+    uint64_t station_count;
+    int64_t total_workshops;
+    int64_t working_workshops;
+    int64_t idle_millionths;
+    std::array<uint64_t, IDLE_BUCKETS> idle_hist;
+
+    static size_t diameterBucket(double diameter);
+    static size_t idleBucket(int total, int working);
+    static int64_t idleMillionths(int total, int working);
+
+public:
+    NetworkStats();
+
+    void clear();
+    void addPipe(double diameter, bool in_repair);
+    void removePipe(double diameter, bool in_repair);
+    void setPipeRepair(bool was_in_repair, bool in_repair);
+    void addStation(int total, int working);
+    void removeStation(int total, int working);
+    void setStationWorking(int total, int oldWorking, int newWorking);
+    void rebuild(const std::vector<double>& diameters, const std::vector<uint8_t>& repair,
+        const std::vector<int32_t>& totals, const std::vector<int32_t>& workings);
+    // Adds the counters of another set (e.g. one shard of many).
+    void merge(const NetworkStats& other);
+
+    uint64_t pipeCount() const { return pipe_count; }
+    uint64_t pipesInRepair() const { return pipes_in_repair; }
+    uint64_t workingPipes() const { return pipe_count - pipes_in_repair; }
+    double averageDiameter() const;
+    const std::array<uint64_t, DIAMETER_BUCKETS>& diameterHistogram() const { return diameter_hist; }
+
+    uint64_t stationCount() const { return station_count; }
+    int64_t totalWorkshops() const { return total_workshops; }
+    int64_t workingWorkshops() const { return working_workshops; }
+    // Mean of the per-station idle percentages.
+    double averageIdlePercent() const;
+    // Idle share of all workshops together.
+    double overallIdlePercent() const;
+    const std::array<uint64_t, IDLE_BUCKETS>& idleHistogram() const { return idle_hist; }
+};
+
+#endif // NETWORKSTATS_H
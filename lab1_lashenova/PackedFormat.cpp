@@ -0,0 +1,330 @@
+#include "PackedFormat.h"
+#include "BlockCodec.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+
+void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+void putString(std::string& out, std::string_view s) {
+    putVarint(out, s.size());
+    out.append(s);
+}
+
+// Bounds-checked reads from the payload; any overrun clears 'ok'.
+struct Cursor {
+    const unsigned char* pos;
+    const unsigned char* end;
+    bool ok = true;
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (pos == end) break;
+            unsigned char b = *pos++;
+            v |= uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    const char* bytes(size_t n) {
+        if (static_cast<size_t>(end - pos) < n) {
+            ok = false;
+            return nullptr;
+        }
+        const char* p = reinterpret_cast<const char*>(pos);
+        pos += n;
+        return p;
+    }
+
+    // Element counts are checked against the bytes left so a corrupt
+    // count cannot trigger a huge allocation.
+    size_t count(size_t minBytesEach) {
+        uint64_t n = varint();
+        if (minBytesEach && n > static_cast<uint64_t>(end - pos) / minBytesEach) ok = false;
+        return ok ? static_cast<size_t>(n) : 0;
+    }
+};
+
+// Front coding: names of neighbouring ids usually share a prefix.
+class NameColumn {
+private:
+    std::string out;
+    std::string previous;
+
+public:
+    void add(std::string_view name) {
+        size_t shared = 0, limit = std::min(previous.size(), name.size());
+        while (shared < limit && previous[shared] == name[shared]) ++shared;
+        putVarint(out, shared);
+        putString(out, name.substr(shared));
+        previous.assign(name);
+    }
+    const std::string& bytes() const { return out; }
+};
+
+bool readNames(Cursor& in, size_t n, std::string& names, std::vector<uint32_t>& ends) {
+    ends.resize(n);
+    size_t previousStart = 0;
+    for (size_t i = 0; i < n && in.ok; ++i) {
+        size_t start = names.size();
+        size_t shared = in.varint();
+        size_t length = in.varint();
+        const char* suffix = in.bytes(length);
+        if (!in.ok || shared > start - previousStart) return false;
+        names.append(names, previousStart, shared);
+        names.append(suffix, length);
+        ends[i] = static_cast<uint32_t>(names.size());
+        previousStart = start;
+    }
+    return in.ok;
+}
+
+class Encoder {
+private:
+    std::string pipeIds, pipeRepair, pipeDiameters, pipeEnds;
+    NameColumn pipeNames;
+    int lastPipe = 0;
+    size_t pipeCount = 0;
+
+    std::string stationIds, stationCounts, stationClasses;
+    NameColumn stationNames;
+    int lastStation = 0;
+    size_t stationCount = 0;
+    std::vector<ClassId> dictionary;
+    std::unordered_map<ClassId, size_t> dictionaryIndex;
+
+public:
+    // Calls must come in ascending id order.
+    void addPipe(int id, std::string_view name, double diameter, bool inRepair, int in, int out) {
+        putVarint(pipeIds, static_cast<uint32_t>(id - lastPipe));
+        lastPipe = id;
+        if (pipeCount % 8 == 0) pipeRepair += '\0';
+        if (inRepair) pipeRepair.back() = static_cast<char>(pipeRepair.back() | (1 << (pipeCount % 8)));
+        ++pipeCount;
+
+        double hundredths = std::round(diameter * 100);
+        if (hundredths >= 0 && hundredths < 4e18 && hundredths / 100 == diameter) {
+            putVarint(pipeDiameters, static_cast<uint64_t>(hundredths) << 1);
+        }
+        else {
+            putVarint(pipeDiameters, 1);
+            pipeDiameters.append(reinterpret_cast<const char*>(&diameter), sizeof(diameter));
+        }
+        putVarint(pipeEnds, static_cast<uint32_t>(in));
+        if (in != 0) putVarint(pipeEnds, static_cast<uint32_t>(out));
+        pipeNames.add(name);
+    }
+
+    void addStation(int id, std::string_view name, int total, int working, ClassId cls) {
+        putVarint(stationIds, static_cast<uint32_t>(id - lastStation));
+        lastStation = id;
+        ++stationCount;
+        putVarint(stationCounts, static_cast<uint32_t>(total));
+        putVarint(stationCounts, static_cast<uint32_t>(working));
+        auto known = dictionaryIndex.find(cls);
+        if (known == dictionaryIndex.end()) {
+            known = dictionaryIndex.emplace(cls, dictionary.size()).first;
+            dictionary.push_back(cls);
+        }
+        putVarint(stationClasses, known->second);
+        stationNames.add(name);
+    }
+
+    bool write(const std::string& filename, int nextPipeId, int nextStationId, size_t threads) const {
+        std::string payload;
+        payload.reserve(pipeIds.size() + pipeRepair.size() + pipeDiameters.size() + pipeEnds.size()
+            + pipeNames.bytes().size() + stationIds.size() + stationCounts.size() + stationClasses.size()
+            + stationNames.bytes().size() + 64);
+        putVarint(payload, static_cast<uint32_t>(nextPipeId));
+        putVarint(payload, static_cast<uint32_t>(nextStationId));
+        putVarint(payload, pipeCount);
+        payload += pipeIds;
+        payload += pipeRepair;
+        payload += pipeDiameters;
+        payload += pipeEnds;
+        payload += pipeNames.bytes();
+        putVarint(payload, stationCount);
+        payload += stationIds;
+        payload += stationCounts;
+        putVarint(payload, dictionary.size());
+        for (ClassId cls : dictionary) putString(payload, ClassRegistry::name(cls));
+        payload += stationClasses;
+        payload += stationNames.bytes();
+
+        PackedHeader h;
+        std::memcpy(h.magic, PACKED_MAGIC, sizeof(h.magic));
+        h.version = PACKED_VERSION;
+        std::string file(reinterpret_cast<const char*>(&h), sizeof(h));
+        BlockCodec::packStream(payload, file, BlockCodec::DEFAULT_BLOCK_SIZE, threads);
+
+        std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+        if (!os) return false;
+        os.write(file.data(), file.size());
+        return static_cast<bool>(os);
+    }
+};
+
+template <typename Table>
+std::vector<size_t> rowsSortedById(const Table& table) {
+    std::vector<size_t> order(table.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    const std::vector<int>& ids = table.idColumn();
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ids[a] < ids[b]; });
+    return order;
+}
+
+}
+
+bool writePacked(const std::string& filename, const PipeTable& pipes, const StationTable& stations,
+    int next_pipe_id, int next_station_id, size_t threads) {
+    Encoder enc;
+    for (size_t row : rowsSortedById(pipes)) {
+        enc.addPipe(pipes.idColumn()[row], pipes.nameColumn()[row], pipes.diameterColumn()[row],
+            pipes.repairColumn()[row] != 0, pipes.inColumn()[row], pipes.outColumn()[row]);
+    }
+    for (size_t row : rowsSortedById(stations)) {
+        enc.addStation(stations.idColumn()[row], stations.nameColumn()[row], stations.totalColumn()[row],
+            stations.workingColumn()[row], stations.classColumn()[row]);
+    }
+    return enc.write(filename, next_pipe_id, next_station_id, threads);
+}
+
+bool writePacked(const std::string& filename, const StoreVersion& version, int next_pipe_id, int next_station_id,
+    size_t threads) {
+    Encoder enc;
+    version.forEachPipe([&](int id, const PipeState& p) {
+        enc.addPipe(id, p.name, p.diameter, p.in_repair, p.in_station, p.out_station);
+    });
+    version.forEachStation([&](int id, const StationState& s) {
+        enc.addStation(id, s.name, s.total, s.working, s.classification);
+    });
+    return enc.write(filename, next_pipe_id, next_station_id, threads);
+}
+
+bool isPackedFile(const std::string& filename) {
+    std::ifstream is(filename, std::ios::binary);
+    char magic[4] = {};
+    if (!is.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, PACKED_MAGIC, sizeof(magic)) == 0;
+}
+
+PackedReader::PackedReader() : next_pipe_id(1), next_station_id(1) {}
+
+void PackedReader::clear() {
+    next_pipe_id = 1;
+    next_station_id = 1;
+    pipe_ids.clear();
+    pipe_repair.clear();
+    pipe_diameters.clear();
+    pipe_in.clear();
+    pipe_out.clear();
+    pipe_names.clear();
+    pipe_name_end.clear();
+    station_ids.clear();
+    station_total.clear();
+    station_working.clear();
+    station_class.clear();
+    station_names.clear();
+    station_name_end.clear();
+}
+
+bool PackedReader::load(const std::string& filename, size_t threads) {
+    clear();
+    std::string payload;
+    {
+        MappedFile file;
+        if (!file.open(filename) || file.size() < sizeof(PackedHeader)) return false;
+        PackedHeader h;
+        std::memcpy(&h, file.data(), sizeof(h));
+        if (std::memcmp(h.magic, PACKED_MAGIC, sizeof(h.magic)) != 0 || h.version != PACKED_VERSION) return false;
+        if (!BlockCodec::unpackStream(file.data() + sizeof(h), file.size() - sizeof(h), payload, threads)) return false;
+    }
+
+    Cursor in{ reinterpret_cast<const unsigned char*>(payload.data()),
+        reinterpret_cast<const unsigned char*>(payload.data() + payload.size()) };
+    next_pipe_id = static_cast<int>(in.varint());
+    next_station_id = static_cast<int>(in.varint());
+
+    // Every pipe takes at least one id byte, a diameter byte, an endpoint byte and two name bytes.
+    size_t pipes = in.count(5);
+    pipe_ids.resize(pipes);
+    uint32_t id = 0;
+    for (size_t i = 0; i < pipes; ++i) pipe_ids[i] = static_cast<int>(id += static_cast<uint32_t>(in.varint()));
+    const char* flags = in.bytes((pipes + 7) / 8);
+    pipe_repair.resize(pipes);
+    for (size_t i = 0; flags && i < pipes; ++i) pipe_repair[i] = flags[i / 8] >> (i % 8) & 1;
+    pipe_diameters.resize(pipes);
+    for (size_t i = 0; i < pipes && in.ok; ++i) {
+        uint64_t v = in.varint();
+        if (v & 1) {
+            const char* raw = in.bytes(sizeof(double));
+            if (raw) std::memcpy(&pipe_diameters[i], raw, sizeof(double));
+        }
+        else {
+            pipe_diameters[i] = static_cast<double>(v >> 1) / 100;
+        }
+    }
+    pipe_in.resize(pipes);
+    pipe_out.resize(pipes);
+    for (size_t i = 0; i < pipes && in.ok; ++i) {
+        pipe_in[i] = static_cast<int>(static_cast<uint32_t>(in.varint()));
+        pipe_out[i] = pipe_in[i] != 0 ? static_cast<int>(static_cast<uint32_t>(in.varint())) : 0;
+    }
+    if (!in.ok || !readNames(in, pipes, pipe_names, pipe_name_end)) {
+        clear();
+        return false;
+    }
+
+    size_t stations = in.count(5);
+    station_ids.resize(stations);
+    id = 0;
+    for (size_t i = 0; i < stations; ++i) station_ids[i] = static_cast<int>(id += static_cast<uint32_t>(in.varint()));
+    station_total.resize(stations);
+    station_working.resize(stations);
+    for (size_t i = 0; i < stations && in.ok; ++i) {
+        station_total[i] = static_cast<int>(static_cast<uint32_t>(in.varint()));
+        station_working[i] = static_cast<int>(static_cast<uint32_t>(in.varint()));
+    }
+    std::vector<ClassId> dictionary(in.count(1));
+    for (ClassId& cls : dictionary) {
+        size_t length = in.varint();
+        const char* name = in.bytes(length);
+        if (!name) break;
+        cls = ClassRegistry::intern(std::string_view(name, length));
+    }
+    station_class.resize(stations);
+    for (size_t i = 0; i < stations && in.ok; ++i) {
+        uint64_t index = in.varint();
+        if (index >= dictionary.size()) in.ok = false;
+        else station_class[i] = dictionary[index];
+    }
+    if (!in.ok || !readNames(in, stations, station_names, station_name_end) || in.pos != in.end) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+std::string_view PackedReader::pipeName(size_t i) const {
+    size_t start = i ? pipe_name_end[i - 1] : 0;
+    return std::string_view(pipe_names).substr(start, pipe_name_end[i] - start);
+}
+
+std::string_view PackedReader::stationName(size_t i) const {
+    size_t start = i ? station_name_end[i - 1] : 0;
+    return std::string_view(station_names).substr(start, station_name_end[i] - start);
+}
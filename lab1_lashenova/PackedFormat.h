@@ -0,0 +1,101 @@
+#ifndef PACKEDFORMAT_H
+#define PACKEDFORMAT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "ClassRegistry.h"
+#include "PipeTable.h"
+#include "StationTable.h"
+#include "VersionHistory.h"
+
+// Compact save format: PackedHeader followed by a BlockCodec stream of
+// the payload below, written column by column so similar bytes sit
+// together for the compressor. Records are in ascending id order.
+//   varint next_pipe_id, next_station_id
+//   varint pipe_count
+//     ids as varint deltas from the previous id (the first from 0)
+//     repair flags, one bit per pipe, (pipe_count + 7) / 8 bytes
+//     diameters: varint (hundredths << 1) when the value is an exact
+//       number of hundredths, else varint 1 and the 8 raw double bytes
+//     endpoints: varint in_station, then varint out_station if it is not 0
+//     names, front-coded
+//   varint station_count
+//     ids as deltas, totals, working counts (varints)
+//     classification dictionary: varint size, then each name
+//     per station the varint index into the dictionary
+//     names, front-coded
+// A front-coded name is varint prefix shared with the previous name,
+// varint suffix length and the suffix bytes; other strings are varint
+// length and bytes.
+const char PACKED_MAGIC[4] = { 'L', 'P', 'A', 'K' };
+const uint32_t PACKED_VERSION = 2;
+
+struct PackedHeader {
+    char magic[4];
+    uint32_t version;
+};
+
+static_assert(sizeof(PackedHeader) == 8, "packed header layout");
+
+bool writePacked(const std::string& filename, const PipeTable& pipes, const StationTable& stations,
+    int next_pipe_id, int next_station_id, size_t threads = 0);
+// Same format from a committed version; safe to call on any thread.
+bool writePacked(const std::string& filename, const StoreVersion& version, int next_pipe_id, int next_station_id,
+    size_t threads = 0);
+
+// True if the file starts with the packed magic.
+bool isPackedFile(const std::string& filename);
+
+// Decodes a whole packed file into columns. Blocks are decompressed in
+// parallel; the payload is then read in one pass.
+class PackedReader {
+private:
+    int next_pipe_id;
+    int next_station_id;
+
+    std::vector<int> pipe_ids;
+    std::vector<uint8_t> pipe_repair;
+    std::vector<double> pipe_diameters;
+    std::vector<int> pipe_in;
+    std::vector<int> pipe_out;
+    std::string pipe_names;
+    // End of each name in pipe_names; the start is the previous end.
+    std::vector<uint32_t> pipe_name_end;
+
+    std::vector<int> station_ids;
+    std::vector<int> station_total;
+    std::vector<int> station_working;
+    std::vector<ClassId> station_class;
+    std::string station_names;
+    std::vector<uint32_t> station_name_end;
+
+    void clear();
+
+public:
+    PackedReader();
+
+    bool load(const std::string& filename, size_t threads = 0);
+
+    int nextPipeId() const { return next_pipe_id; }
+    int nextStationId() const { return next_station_id; }
+    size_t pipeCount() const { return pipe_ids.size(); }
+    size_t stationCount() const { return station_ids.size(); }
+
+    int pipeId(size_t i) const { return pipe_ids[i]; }
+    bool pipeInRepair(size_t i) const { return pipe_repair[i] != 0; }
+    double pipeDiameter(size_t i) const { return pipe_diameters[i]; }
+    int pipeIn(size_t i) const { return pipe_in[i]; }
+    int pipeOut(size_t i) const { return pipe_out[i]; }
+    std::string_view pipeName(size_t i) const;
+
+    int stationId(size_t i) const { return station_ids[i]; }
+    int stationTotal(size_t i) const { return station_total[i]; }
+    int stationWorking(size_t i) const { return station_working[i]; }
+    ClassId stationClass(size_t i) const { return station_class[i]; }
+    std::string_view stationName(size_t i) const;
+};
+
+#endif // PACKEDFORMAT_H
@@ -0,0 +1,258 @@
+#include "PagedStore.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+const char INDEX_MAGIC[4] = { 'L', 'I', 'D', 'X' };
+const uint32_t INDEX_VERSION = 1;
+
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t file_size;
+    int64_t file_time;
+    uint64_t page_count;
+};
+
+static_assert(sizeof(IndexHeader) == 32, "page index header layout");
+
+template <typename Record>
+void widen(int32_t& low, int32_t& high, const std::vector<Record>& records) {
+    for (const Record& r : records) {
+        low = std::min(low, static_cast<int32_t>(r.id));
+        high = std::max(high, static_cast<int32_t>(r.id));
+    }
+}
+
+}
+
+PagedStore::PagedStore()
+    : pipes_ordered(true), stations_ordered(true), pipe_count(0), station_count(0), max_pipe_id(0), max_station_id(0),
+    budget(0), cached_bytes(0), hits(0), misses(0), evictions(0) {}
+
+bool PagedStore::open(const std::string& filename, size_t budgetBytes, size_t pageBytes) {
+    close();
+    file.open(filename, std::ios::binary);
+    if (!file) return false;
+
+    std::error_code ec;
+    uint64_t fileSize = std::filesystem::file_size(filename, ec);
+    if (ec) {
+        close();
+        return false;
+    }
+    int64_t fileTime = static_cast<int64_t>(std::filesystem::last_write_time(filename, ec).time_since_epoch().count());
+    const std::string indexFile = filename + ".idx";
+    if (!readIndex(indexFile, fileSize, fileTime)) {
+        if (!buildIndex(std::max<size_t>(pageBytes, 1))) {
+            close();
+            return false;
+        }
+        writeIndex(indexFile, fileSize, fileTime);
+    }
+    path = filename;
+    budget = budgetBytes;
+    summarize();
+    return true;
+}
+
+void PagedStore::close() {
+    if (file.is_open()) file.close();
+    file.clear();
+    path.clear();
+    pages.clear();
+    pipe_pages.clear();
+    station_pages.clear();
+    pipes_ordered = stations_ordered = true;
+    pipe_count = station_count = 0;
+    max_pipe_id = max_station_id = 0;
+    cache.clear();
+    lru.clear();
+    cached_bytes = 0;
+    hits = misses = evictions = 0;
+}
+
+// One sequential pass: pages end at the first line break after pageBytes,
+// and each page is parsed once for its id ranges, then dropped.
+bool PagedStore::buildIndex(size_t pageBytes) {
+    pages.clear();
+    std::string buf;
+    uint64_t offset = 0;
+    bool eof = false;
+    while (!eof || !buf.empty()) {
+        if (!eof) {
+            size_t used = buf.size();
+            buf.resize(used + pageBytes);
+            file.read(buf.data() + used, pageBytes);
+            buf.resize(used + static_cast<size_t>(file.gcount()));
+            eof = !file;
+        }
+        size_t cut = buf.size();
+        if (!eof) {
+            size_t eol = buf.rfind('\n');
+            if (eol == std::string::npos) continue;
+            cut = eol + 1;
+        }
+
+        TextChunk records;
+        TextLoader::parse(buf.data(), buf.data() + cut, records);
+        Page p;
+        p.offset = offset;
+        p.length = static_cast<uint32_t>(cut);
+        p.pipes = static_cast<uint32_t>(records.pipes.size());
+        p.stations = static_cast<uint32_t>(records.stations.size());
+        p.min_pipe = p.min_station = INT32_MAX;
+        p.max_pipe = p.max_station = INT32_MIN;
+        widen(p.min_pipe, p.max_pipe, records.pipes);
+        widen(p.min_station, p.max_station, records.stations);
+        if (p.pipes || p.stations) pages.push_back(p);
+        offset += cut;
+        buf.erase(0, cut);
+    }
+    file.clear();
+    return file.is_open();
+}
+
+bool PagedStore::readIndex(const std::string& indexFile, uint64_t fileSize, int64_t fileTime) {
+    std::ifstream is(indexFile, std::ios::binary);
+    IndexHeader h;
+    if (!is || !is.read(reinterpret_cast<char*>(&h), sizeof(h))) return false;
+    if (std::memcmp(h.magic, INDEX_MAGIC, sizeof(h.magic)) != 0 || h.version != INDEX_VERSION
+        || h.file_size != fileSize || h.file_time != fileTime || h.page_count > fileSize) return false;
+    pages.resize(static_cast<size_t>(h.page_count));
+    if (!is.read(reinterpret_cast<char*>(pages.data()), pages.size() * sizeof(Page))) {
+        pages.clear();
+        return false;
+    }
+    for (const Page& p : pages) {
+        if (p.offset + p.length > fileSize) {
+            pages.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+void PagedStore::writeIndex(const std::string& indexFile, uint64_t fileSize, int64_t fileTime) const {
+    // Best effort: without a writable index the next open scans again.
+    IndexHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, INDEX_MAGIC, sizeof(h.magic));
+    h.version = INDEX_VERSION;
+    h.file_size = fileSize;
+    h.file_time = fileTime;
+    h.page_count = pages.size();
+    std::ofstream os(indexFile, std::ios::binary | std::ios::trunc);
+    os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    os.write(reinterpret_cast<const char*>(pages.data()), pages.size() * sizeof(Page));
+}
+
+void PagedStore::summarize() {
+    pipe_pages.clear();
+    station_pages.clear();
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const Page& p = pages[i];
+        if (p.pipes) {
+            if (!pipe_pages.empty() && p.min_pipe <= pages[pipe_pages.back()].max_pipe) pipes_ordered = false;
+            pipe_pages.push_back(static_cast<uint32_t>(i));
+            pipe_count += p.pipes;
+            max_pipe_id = std::max(max_pipe_id, static_cast<int>(p.max_pipe));
+        }
+        if (p.stations) {
+            if (!station_pages.empty() && p.min_station <= pages[station_pages.back()].max_station) stations_ordered = false;
+            station_pages.push_back(static_cast<uint32_t>(i));
+            station_count += p.stations;
+            max_station_id = std::max(max_station_id, static_cast<int>(p.max_station));
+        }
+    }
+}
+
+const PagedStore::Cached* PagedStore::page(size_t i) const {
+    auto known = cache.find(i);
+    if (known != cache.end()) {
+        ++hits;
+        lru.splice(lru.begin(), lru, known->second.age);
+        return &known->second;
+    }
+
+    ++misses;
+    const Page& p = pages[i];
+    // Filled in place: the records point into 'bytes', which must not move.
+    Cached& c = cache[i];
+    c.bytes.resize(p.length);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(p.offset));
+    if (!file.read(c.bytes.data(), p.length)) {
+        cache.erase(i);
+        return nullptr;
+    }
+    TextLoader::parse(c.bytes.data(), c.bytes.data() + c.bytes.size(), c.records);
+    c.footprint = sizeof(Cached) + c.bytes.capacity() + c.records.pipes.capacity() * sizeof(TextPipe)
+        + c.records.stations.capacity() * sizeof(TextStation);
+    lru.push_front(i);
+    c.age = lru.begin();
+    cached_bytes += c.footprint;
+    evict();
+    return &c;
+}
+
+void PagedStore::evict() const {
+    while (cached_bytes > budget && lru.size() > 1) {
+        auto oldest = cache.find(lru.back());
+        cached_bytes -= oldest->second.footprint;
+        cache.erase(oldest);
+        lru.pop_back();
+        ++evictions;
+    }
+}
+
+void PagedStore::setBudget(size_t bytes) {
+    budget = bytes;
+    evict();
+}
+
+std::vector<uint32_t> PagedStore::candidates(const std::vector<uint32_t>& pageList, bool ordered, int id, bool forPipes) const {
+    auto low = [&](uint32_t i) { return forPipes ? pages[i].min_pipe : pages[i].min_station; };
+    auto high = [&](uint32_t i) { return forPipes ? pages[i].max_pipe : pages[i].max_station; };
+    std::vector<uint32_t> found;
+    if (ordered) {
+        auto it = std::upper_bound(pageList.begin(), pageList.end(), id, [&](int key, uint32_t i) { return key < low(i); });
+        if (it != pageList.begin() && id <= high(*(it - 1))) found.push_back(*(it - 1));
+        return found;
+    }
+    for (uint32_t i : pageList) {
+        if (low(i) <= id && id <= high(i)) found.push_back(i);
+    }
+    return found;
+}
+
+bool PagedStore::findPipe(int id, Pipe& out) const {
+    if (!isOpen()) return false;
+    for (uint32_t i : candidates(pipe_pages, pipes_ordered, id, true)) {
+        const Cached* c = page(i);
+        if (!c) return false;
+        for (const TextPipe& p : c->records.pipes) {
+            if (p.id != id) continue;
+            out = Pipe(id, std::string(p.name), p.diameter, p.in_repair, p.in_station, p.out_station);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PagedStore::findStation(int id, CompressorStation& out) const {
+    if (!isOpen()) return false;
+    for (uint32_t i : candidates(station_pages, stations_ordered, id, false)) {
+        const Cached* c = page(i);
+        if (!c) return false;
+        for (const TextStation& s : c->records.stations) {
+            if (s.id != id) continue;
+            out = CompressorStation(id, std::string(s.name), s.total, s.working, ClassRegistry::intern(s.classification));
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,105 @@
+#ifndef PAGEDSTORE_H
+#define PAGEDSTORE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+#include "TextLoader.h"
+#include "Pipe.h"
+#include "CompressorStation.h"
+
+// Read-on-demand view of a PIPE|/STATION| text file. Opening only builds
+// a sparse index: the file is cut into line-aligned pages and each page
+// keeps its offset and id ranges. The index is saved next to the file as
+// <file>.idx and reused while the file's size and time stay the same.
+// Lookups parse the pages they need and keep them in an LRU cache whose
+// parsed size stays within the budget; the page just read is always kept.
+class PagedStore {
+public:
+    static const size_t DEFAULT_PAGE_BYTES = 64 * 1024;
+
+    struct Page {
+        uint64_t offset;
+        uint32_t length;
+        uint32_t pipes;
+        uint32_t stations;
+        // min > max when the page has no record of that kind.
+        int32_t min_pipe;
+        int32_t max_pipe;
+        int32_t min_station;
+        int32_t max_station;
+    };
+
+private:
+    struct Cached {
+        std::string bytes;
+        TextChunk records;
+        size_t footprint = 0;
+        std::list<size_t>::iterator age;
+    };
+
+    std::string path;
+    std::vector<Page> pages;
+    // Pages holding pipes/stations, in file order; binary searched when
+    // their id ranges ascend without overlap (files written in id order).
+    std::vector<uint32_t> pipe_pages;
+    std::vector<uint32_t> station_pages;
+    bool pipes_ordered;
+    bool stations_ordered;
+    size_t pipe_count;
+    size_t station_count;
+    int max_pipe_id;
+    int max_station_id;
+    size_t budget;
+
+    mutable std::ifstream file;
+    mutable std::unordered_map<size_t, Cached> cache;
+    // Most recently used first.
+    mutable std::list<size_t> lru;
+    mutable size_t cached_bytes;
+    mutable uint64_t hits;
+    mutable uint64_t misses;
+    mutable uint64_t evictions;
+
+    bool buildIndex(size_t pageBytes);
+    bool readIndex(const std::string& indexFile, uint64_t fileSize, int64_t fileTime);
+    void writeIndex(const std::string& indexFile, uint64_t fileSize, int64_t fileTime) const;
+    void summarize();
+    const Cached* page(size_t i) const;
+    void evict() const;
+    // Index into 'pageList' of the pages whose id range holds 'id'.
+    std::vector<uint32_t> candidates(const std::vector<uint32_t>& pageList, bool ordered, int id, bool forPipes) const;
+
+public:
+    PagedStore();
+
+    bool open(const std::string& filename, size_t budgetBytes, size_t pageBytes = DEFAULT_PAGE_BYTES);
+    void close();
+    bool isOpen() const { return !path.empty(); }
+    const std::string& getPath() const { return path; }
+
+    // Record lines in the file; an id repeated in the file counts twice.
+    size_t pipeCount() const { return pipe_count; }
+    size_t stationCount() const { return station_count; }
+    int maxPipeId() const { return max_pipe_id; }
+    int maxStationId() const { return max_station_id; }
+    size_t pageCount() const { return pages.size(); }
+
+    // First record with the id in file order, like loadFromFile keeps.
+    bool findPipe(int id, Pipe& out) const;
+    bool findStation(int id, CompressorStation& out) const;
+
+    void setBudget(size_t bytes);
+    size_t getBudget() const { return budget; }
+    size_t cachedBytes() const { return cached_bytes; }
+    size_t cachedPages() const { return cache.size(); }
+    uint64_t cacheHits() const { return hits; }
+    uint64_t cacheMisses() const { return misses; }
+    uint64_t cacheEvictions() const { return evictions; }
+};
+
+#endif // PAGEDSTORE_H
@@ -0,0 +1,151 @@
+#ifndef PERSISTENTMAP_H
+#define PERSISTENTMAP_H
+
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Map from non-negative ids to T with structural sharing. Copying a map is
+// O(1); a write copies only the nodes on the path to its id (a 32-way trie
+// over the id bits with 16 values per leaf), everything else stays shared.
+// Nodes referenced from one place only are changed in place, so a run of
+// writes after a copy pays for each path once. A copy may be read from
+// other threads while the original keeps changing.
+template <typename T>
+class PersistentMap {
+private:
+    static const unsigned LEAF_BITS = 4;
+    static const unsigned INNER_BITS = 5;
+    static const size_t LEAF_WIDTH = size_t(1) << LEAF_BITS;
+    static const size_t INNER_WIDTH = size_t(1) << INNER_BITS;
+
+    struct Node {};
+    using Ptr = std::shared_ptr<Node>;
+    struct Inner : Node {
+        std::array<Ptr, INNER_WIDTH> kids;
+    };
+    struct Leaf : Node {
+        uint32_t present = 0;
+        std::array<T, LEAF_WIDTH> values;
+    };
+
+    Ptr root;
+    // Levels of inner nodes above the leaves.
+    unsigned height;
+    size_t count;
+
+    static size_t span(unsigned h) { return LEAF_WIDTH << (h * INNER_BITS); }
+    static size_t slot(size_t id, unsigned h) {
+        return h == 0 ? id & (LEAF_WIDTH - 1) : (id >> (LEAF_BITS + (h - 1) * INNER_BITS)) & (INNER_WIDTH - 1);
+    }
+    static const Inner& inner(const Node* n) { return *static_cast<const Inner*>(n); }
+    static const Leaf& leaf(const Node* n) { return *static_cast<const Leaf*>(n); }
+
+    // The node behind p, copied first if another map or version shares it.
+    template <typename N>
+    static N& own(Ptr& p) {
+        if (!p) p = std::make_shared<N>();
+        else if (p.use_count() > 1) p = std::make_shared<N>(static_cast<const N&>(*p));
+        return static_cast<N&>(*p);
+    }
+
+    template <typename F>
+    static void walk(const Node* n, unsigned h, size_t base, F& f) {
+        if (!n) return;
+        if (h == 0) {
+            const Leaf& l = leaf(n);
+            for (size_t i = 0; i < LEAF_WIDTH; ++i) {
+                if (l.present >> i & 1) f(static_cast<int>(base + i), l.values[i]);
+            }
+            return;
+        }
+        for (size_t i = 0; i < INNER_WIDTH; ++i) walk(inner(n).kids[i].get(), h - 1, base + i * span(h - 1), f);
+    }
+
+    // A tree shorter than its counterpart is compared as child 0 of the taller one.
+    template <typename F>
+    static void diffNodes(const Node* a, unsigned ha, const Node* b, unsigned hb, size_t base, F& f) {
+        if ((a == b && ha == hb) || (!a && !b)) return;
+        unsigned h = ha > hb ? ha : hb;
+        if (h == 0) {
+            uint32_t ma = a ? leaf(a).present : 0, mb = b ? leaf(b).present : 0;
+            for (size_t i = 0; i < LEAF_WIDTH; ++i) {
+                const T* pa = ma >> i & 1 ? &leaf(a).values[i] : nullptr;
+                const T* pb = mb >> i & 1 ? &leaf(b).values[i] : nullptr;
+                if ((pa || pb) && (!pa || !pb || !(*pa == *pb))) f(static_cast<int>(base + i), pa, pb);
+            }
+            return;
+        }
+        for (size_t i = 0; i < INNER_WIDTH; ++i) {
+            const Node* ca = ha == h ? (a ? inner(a).kids[i].get() : nullptr) : (i == 0 ? a : nullptr);
+            const Node* cb = hb == h ? (b ? inner(b).kids[i].get() : nullptr) : (i == 0 ? b : nullptr);
+            diffNodes(ca, ha == h ? h - 1 : ha, cb, hb == h ? h - 1 : hb, base + i * span(h - 1), f);
+        }
+    }
+
+public:
+    PersistentMap() : height(0), count(0) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() {
+        root.reset();
+        height = 0;
+        count = 0;
+    }
+
+    const T* find(int id) const {
+        size_t key = static_cast<size_t>(id);
+        if (id < 0 || key >= span(height)) return nullptr;
+        const Node* n = root.get();
+        for (unsigned h = height; n && h > 0; --h) n = inner(n).kids[slot(key, h)].get();
+        if (!n || !(leaf(n).present >> slot(key, 0) & 1)) return nullptr;
+        return &leaf(n).values[slot(key, 0)];
+    }
+
+    void set(int id, const T& value) {
+        size_t key = static_cast<size_t>(id);
+        while (key >= span(height)) {
+            if (root) {
+                Ptr grown = std::make_shared<Inner>();
+                static_cast<Inner&>(*grown).kids[0] = root;
+                root = grown;
+            }
+            ++height;
+        }
+        Ptr* p = &root;
+        for (unsigned h = height; h > 0; --h) p = &own<Inner>(*p).kids[slot(key, h)];
+        Leaf& l = own<Leaf>(*p);
+        uint32_t bit = uint32_t(1) << slot(key, 0);
+        if (!(l.present & bit)) ++count;
+        l.present |= bit;
+        l.values[slot(key, 0)] = value;
+    }
+
+    bool erase(int id) {
+        if (!find(id)) return false;
+        size_t key = static_cast<size_t>(id);
+        Ptr* p = &root;
+        for (unsigned h = height; h > 0; --h) p = &own<Inner>(*p).kids[slot(key, h)];
+        Leaf& l = own<Leaf>(*p);
+        l.present &= ~(uint32_t(1) << slot(key, 0));
+        l.values[slot(key, 0)] = T();
+        --count;
+        return true;
+    }
+
+    // f(id, value) in ascending id order.
+    template <typename F>
+    void forEach(F f) const { walk(root.get(), height, 0, f); }
+
+    // f(id, before, after) for every id whose value differs between the
+    // maps; a missing side is nullptr. Shared subtrees are skipped, so the
+    // cost follows the number of changed paths, not the map size.
+    template <typename F>
+    static void diff(const PersistentMap& a, const PersistentMap& b, F f) {
+        diffNodes(a.root.get(), a.height, b.root.get(), b.height, 0, f);
+    }
+};
+
+#endif // PERSISTENTMAP_H
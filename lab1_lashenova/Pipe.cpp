@@ -3,16 +3,19 @@
 #include <limits>
 
 
-Pipe::Pipe() : id(0), name(""), diameter(0.0), in_repair(false) {}
+Pipe::Pipe() : id(0), name(""), diameter(0.0), in_repair(false), in_station(0), out_station(0) {}
 
-Pipe::Pipe(int id_, const std::string& name_,double diameter_, bool in_repair_)
-    : id(id_), name(name_), diameter(diameter_), in_repair(in_repair_) {
+Pipe::Pipe(int id_, const std::string& name_,double diameter_, bool in_repair_, int in_station_, int out_station_)
+    : id(id_), name(name_), diameter(diameter_), in_repair(in_repair_), in_station(in_station_), out_station(out_station_) {
 }
 
 int Pipe::getId() const { return id; }
 std::string Pipe::getName() const { return name; }
 double Pipe::getDiameter() const { return diameter; }
 bool Pipe::isInRepair() const { return in_repair; }
+int Pipe::getInStation() const { return in_station; }
+int Pipe::getOutStation() const { return out_station; }
+bool Pipe::isConnected() const { return in_station != 0; }
 void Pipe::setInRepair(bool r) { in_repair = r; }
 
 
@@ -21,6 +24,7 @@ std::ostream& operator<<(std::ostream& os, const Pipe& p) {
         << " | Name=\"" << p.name << "\""
         << " | Diameter=" << p.diameter
         << " | InRepair=" << (p.in_repair ? "YES" : "NO");
+    if (p.isConnected()) os << " | Stations=" << p.in_station << "->" << p.out_station;
     return os;
 }
 
@@ -10,15 +10,22 @@ private:
     std::string name;
     double diameter; 
     bool in_repair;
+    // Station ids the pipe runs from and to; 0 while unconnected.
+    int in_station;
+    int out_station;
 
 public:
     Pipe();
-    Pipe(int id_, const std::string& name_, double diameter_, bool in_repair_);
+    Pipe(int id_, const std::string& name_, double diameter_, bool in_repair_,
+        int in_station_ = 0, int out_station_ = 0);
     
     int getId() const;
     std::string getName() const;
     double getDiameter() const;
     bool isInRepair() const;
+    int getInStation() const;
+    int getOutStation() const;
+    bool isConnected() const;
 
     void setInRepair(bool r);
 
@@ -0,0 +1,126 @@
+#include "PipeTable.h"
+
+PipeTable::PipeTable() : live_name_bytes(0) {}
+
+void PipeTable::reserve(size_t n) {
+    ids.reserve(n);
+    diameters.reserve(n);
+    repair.reserve(n);
+    ins.reserve(n);
+    outs.reserve(n);
+    names.reserve(n);
+    rows.reserve(n);
+}
+
+void PipeTable::reserveNames(size_t bytes) {
+    arena.reserve(bytes);
+}
+
+void PipeTable::clear() {
+    ids.clear();
+    diameters.clear();
+    repair.clear();
+    ins.clear();
+    outs.clear();
+    names.clear();
+    rows.clear();
+    arena.clear();
+    live_name_bytes = 0;
+}
+
+void PipeTable::insert(int id, std::string_view name, double diameter, bool in_repair) {
+    if (const uint32_t* known = rows.find(id)) {
+        size_t row = *known;
+        live_name_bytes -= names[row].size();
+        live_name_bytes += name.size();
+        names[row] = arena.store(name);
+        diameters[row] = diameter;
+        repair[row] = in_repair ? 1 : 0;
+        if (arena.bytes() > 2 * live_name_bytes + (1 << 20)) compactNames();
+        return;
+    }
+    rows.insert(id, static_cast<uint32_t>(ids.size()));
+    ids.push_back(id);
+    names.push_back(arena.store(name));
+    diameters.push_back(diameter);
+    repair.push_back(in_repair ? 1 : 0);
+    ins.push_back(0);
+    outs.push_back(0);
+    live_name_bytes += name.size();
+}
+
+void PipeTable::insert(int id, std::string_view name, double diameter, bool in_repair, int in_station, int out_station) {
+    insert(id, name, diameter, in_repair);
+    size_t row = *rows.find(id);
+    ins[row] = in_station;
+    outs[row] = out_station;
+}
+
+void PipeTable::insert(const Pipe& pipe) {
+    insert(pipe.getId(), pipe.getName(), pipe.getDiameter(), pipe.isInRepair(), pipe.getInStation(), pipe.getOutStation());
+}
+
+// Drops the bytes of erased and renamed rows by copying live names into a fresh arena.
+void PipeTable::compactNames() {
+    StringArena fresh;
+    fresh.reserve(live_name_bytes);
+    for (std::string_view& name : names) name = fresh.store(name);
+    arena = std::move(fresh);
+}
+
+bool PipeTable::erase(int id) {
+    const uint32_t* known = rows.find(id);
+    if (!known) return false;
+
+    size_t row = *known;
+    size_t last = ids.size() - 1;
+    live_name_bytes -= names[row].size();
+    if (row != last) {
+        ids[row] = ids[last];
+        names[row] = names[last];
+        diameters[row] = diameters[last];
+        repair[row] = repair[last];
+        ins[row] = ins[last];
+        outs[row] = outs[last];
+        *rows.find(ids[row]) = static_cast<uint32_t>(row);
+    }
+    ids.pop_back();
+    names.pop_back();
+    diameters.pop_back();
+    repair.pop_back();
+    ins.pop_back();
+    outs.pop_back();
+    rows.erase(id);
+    if (arena.bytes() > 2 * live_name_bytes + (1 << 20)) compactNames();
+    return true;
+}
+
+ptrdiff_t PipeTable::rowOf(int id) const {
+    const uint32_t* row = rows.find(id);
+    return row ? static_cast<ptrdiff_t>(*row) : -1;
+}
+
+Pipe PipeTable::at(size_t row) const {
+    return Pipe(ids[row], std::string(names[row]), diameters[row], repair[row] != 0, ins[row], outs[row]);
+}
+
+std::optional<Pipe> PipeTable::get(int id) const {
+    ptrdiff_t row = rowOf(id);
+    if (row < 0) return std::nullopt;
+    return at(static_cast<size_t>(row));
+}
+
+bool PipeTable::setInRepair(int id, bool r) {
+    ptrdiff_t row = rowOf(id);
+    if (row < 0) return false;
+    repair[row] = r ? 1 : 0;
+    return true;
+}
+
+bool PipeTable::setEndpoints(int id, int in_station, int out_station) {
+    ptrdiff_t row = rowOf(id);
+    if (row < 0) return false;
+    ins[row] = in_station;
+    outs[row] = out_station;
+    return true;
+}
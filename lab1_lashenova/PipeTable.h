@@ -0,0 +1,85 @@
+#ifndef PIPETABLE_H
+#define PIPETABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <optional>
+#include "Pipe.h"
+#include "StringArena.h"
+#include "SlotMap.h"
+
+// Column-oriented pipe storage: one dense vector per field, rows are kept
+// contiguous (removal swaps the last row into the hole). Name bytes live in
+// an arena owned by the table.
+class PipeTable {
+private:
+    std::vector<int> ids;
+    std::vector<double> diameters;
+    std::vector<uint8_t> repair;
+    std::vector<int> ins;
+    std::vector<int> outs;
+    std::vector<std::string_view> names;
+    // Row of each id.
+    SlotMap<uint32_t> rows;
+    StringArena arena;
+    size_t live_name_bytes;
+
+    void compactNames();
+
+public:
+    PipeTable();
+    PipeTable(const PipeTable&) = delete;
+    PipeTable& operator=(const PipeTable&) = delete;
+
+    // Map-style facade: iterating yields (id, Pipe) pairs built from the columns.
+    class const_iterator {
+    private:
+        const PipeTable* table;
+        size_t row;
+    public:
+        const_iterator(const PipeTable* t, size_t r) : table(t), row(r) {}
+        std::pair<int, Pipe> operator*() const { return { table->ids[row], table->at(row) }; }
+        const_iterator& operator++() { ++row; return *this; }
+        bool operator==(const const_iterator& o) const { return row == o.row; }
+        bool operator!=(const const_iterator& o) const { return row != o.row; }
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, ids.size()); }
+
+    size_t size() const { return ids.size(); }
+    size_t capacity() const { return ids.capacity(); }
+    bool empty() const { return ids.empty(); }
+    bool contains(int id) const { return rows.contains(id); }
+
+    void reserve(size_t n);
+    // Reserves arena space for the next 'bytes' of names.
+    void reserveNames(size_t bytes);
+    void clear();
+    // Replacing an existing row keeps its endpoints unless given.
+    void insert(int id, std::string_view name, double diameter, bool in_repair);
+    void insert(int id, std::string_view name, double diameter, bool in_repair, int in_station, int out_station);
+    void insert(const Pipe& pipe);
+    bool erase(int id);
+
+    // Row of the given id or -1.
+    ptrdiff_t rowOf(int id) const;
+    Pipe at(size_t row) const;
+    // Empty when the id is not in the table.
+    std::optional<Pipe> get(int id) const;
+    bool setInRepair(int id, bool r);
+    bool setEndpoints(int id, int in_station, int out_station);
+
+    const std::vector<int>& idColumn() const { return ids; }
+    const std::vector<double>& diameterColumn() const { return diameters; }
+    const std::vector<uint8_t>& repairColumn() const { return repair; }
+    const std::vector<int>& inColumn() const { return ins; }
+    const std::vector<int>& outColumn() const { return outs; }
+    const std::vector<std::string_view>& nameColumn() const { return names; }
+};
+
+#endif // PIPETABLE_H
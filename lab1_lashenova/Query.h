@@ -0,0 +1,181 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include "PipeTable.h"
+#include "StationTable.h"
+#include "ClassRegistry.h"
+
+// Compile-time query combinators over the columnar tables. Predicates are
+// small value types evaluated per row; &&, || and ! build And/Or/Not types,
+// so a whole expression compiles into one fused scan without virtual calls:
+//
+//   query::select(pipes, query::inRepair() && query::diameter(query::GT, 1000)
+//                        && query::nameContains("north"));
+//
+// COST is a rough per-row price; And/Or test their cheaper operand first.
+namespace query {
+
+enum CmpOp { LT, LE, GT, GE, EQ, NE };
+
+inline bool compare(double lhs, CmpOp op, double rhs) {
+    switch (op) {
+    case LT: return lhs < rhs;
+    case LE: return lhs <= rhs;
+    case GT: return lhs > rhs;
+    case GE: return lhs >= rhs;
+    case EQ: return lhs == rhs;
+    case NE: return lhs != rhs;
+    }
+    return false;
+}
+
+// percent / 100 as num / den. Percents inside [0, 100] with at most four
+// decimals become integers over 10^6, so idle * den vs num * total is exact
+// in double for any int32 workshop counts; other values keep (percent, 100).
+inline void idleRatio(double percent, double& num, double& den) {
+    double scaled = percent * 10000.0;
+    double rounded = std::nearbyint(scaled);
+    if (percent >= 0.0 && percent <= 100.0 && std::fabs(scaled - rounded) <= 1e-6) {
+        num = rounded;
+        den = 1000000.0;
+    } else {
+        num = percent;
+        den = 100.0;
+    }
+}
+
+template <typename Derived>
+struct Predicate {
+    const Derived& self() const { return static_cast<const Derived&>(*this); }
+};
+
+struct NameContains : Predicate<NameContains> {
+    static constexpr int COST = 16;
+    std::string needle;
+
+    explicit NameContains(std::string needle_) : needle(std::move(needle_)) {}
+    template <typename Table>
+    bool operator()(const Table& t, size_t row) const {
+        return t.nameColumn()[row].find(needle) != std::string_view::npos;
+    }
+};
+
+struct RepairIs : Predicate<RepairIs> {
+    static constexpr int COST = 1;
+    uint8_t wanted;
+
+    explicit RepairIs(bool in_repair) : wanted(in_repair ? 1 : 0) {}
+    bool operator()(const PipeTable& t, size_t row) const { return t.repairColumn()[row] == wanted; }
+};
+
+struct DiameterIs : Predicate<DiameterIs> {
+    static constexpr int COST = 1;
+    CmpOp op;
+    double value;
+
+    DiameterIs(CmpOp op_, double value_) : op(op_), value(value_) {}
+    bool operator()(const PipeTable& t, size_t row) const { return compare(t.diameterColumn()[row], op, value); }
+};
+
+// Idle percent compared without dividing: idle * den vs num * total.
+struct IdleIs : Predicate<IdleIs> {
+    static constexpr int COST = 2;
+    CmpOp op;
+    double value;
+    double num, den;
+
+    IdleIs(CmpOp op_, double value_) : op(op_), value(value_) { idleRatio(value, num, den); }
+    bool operator()(const StationTable& t, size_t row) const {
+        double total = t.totalColumn()[row];
+        if (total <= 0) return compare(0.0, op, value);
+        double idle = total - t.workingColumn()[row];
+        return compare(idle * den, op, num * total);
+    }
+};
+
+// Interns the name, so the predicate also works for classes added after it
+// was built.
+struct ClassIs : Predicate<ClassIs> {
+    static constexpr int COST = 1;
+    ClassId id;
+
+    explicit ClassIs(std::string_view name) : id(ClassRegistry::intern(name)) {}
+    bool operator()(const StationTable& t, size_t row) const { return t.classColumn()[row] == id; }
+};
+
+template <typename A, typename B>
+struct And : Predicate<And<A, B>> {
+    static constexpr int COST = A::COST + B::COST;
+    A a;
+    B b;
+
+    And(const A& a_, const B& b_) : a(a_), b(b_) {}
+    template <typename Table>
+    bool operator()(const Table& t, size_t row) const {
+        if constexpr (B::COST < A::COST) return b(t, row) && a(t, row);
+        else return a(t, row) && b(t, row);
+    }
+};
+
+template <typename A, typename B>
+struct Or : Predicate<Or<A, B>> {
+    static constexpr int COST = A::COST + B::COST;
+    A a;
+    B b;
+
+    Or(const A& a_, const B& b_) : a(a_), b(b_) {}
+    template <typename Table>
+    bool operator()(const Table& t, size_t row) const {
+        if constexpr (B::COST < A::COST) return b(t, row) || a(t, row);
+        else return a(t, row) || b(t, row);
+    }
+};
+
+template <typename A>
+struct Not : Predicate<Not<A>> {
+    static constexpr int COST = A::COST;
+    A a;
+
+    explicit Not(const A& a_) : a(a_) {}
+    template <typename Table>
+    bool operator()(const Table& t, size_t row) const { return !a(t, row); }
+};
+
+template <typename A, typename B>
+And<A, B> operator&&(const Predicate<A>& a, const Predicate<B>& b) { return And<A, B>(a.self(), b.self()); }
+
+template <typename A, typename B>
+Or<A, B> operator||(const Predicate<A>& a, const Predicate<B>& b) { return Or<A, B>(a.self(), b.self()); }
+
+template <typename A>
+Not<A> operator!(const Predicate<A>& a) { return Not<A>(a.self()); }
+
+inline NameContains nameContains(std::string needle) { return NameContains(std::move(needle)); }
+inline RepairIs inRepair(bool in_repair = true) { return RepairIs(in_repair); }
+inline DiameterIs diameter(CmpOp op, double value) { return DiameterIs(op, value); }
+inline IdleIs idlePercent(CmpOp op, double value) { return IdleIs(op, value); }
+inline ClassIs classIs(std::string_view name) { return ClassIs(name); }
+
+// Ids of the rows matching pred, ascending. No I/O.
+template <typename Table, typename P>
+std::vector<int> select(const Table& table, const Predicate<P>& pred) {
+    const P& p = pred.self();
+    const std::vector<int>& ids = table.idColumn();
+    std::vector<int> result;
+    for (size_t row = 0; row < ids.size(); ++row) {
+        if (p(table, row)) result.push_back(ids[row]);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+}
+
+#endif // QUERY_H
@@ -0,0 +1,463 @@
+#include "QueryExpr.h"
+#include "FilterKernels.h"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <type_traits>
+
+namespace {
+
+const size_t SAMPLE_ROWS = 256;
+
+struct Token {
+    enum Type { WORD, TEXT, OP, END } type;
+    std::string value;
+};
+
+std::string lower(std::string s) {
+    for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+bool tokenize(const std::string& text, std::vector<Token>& tokens, std::string& error) {
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        }
+        else if (c == '\'' || c == '"') {
+            size_t close = text.find(c, i + 1);
+            if (close == std::string::npos) {
+                error = "unterminated quote";
+                return false;
+            }
+            tokens.push_back({ Token::TEXT, text.substr(i + 1, close - i - 1) });
+            i = close + 1;
+        }
+        else if (c == '(' || c == ')') {
+            tokens.push_back({ Token::OP, std::string(1, c) });
+            ++i;
+        }
+        else if (c == '<' || c == '>' || c == '=' || c == '!') {
+            size_t len = i + 1 < text.size() && text[i + 1] == '=' ? 2 : 1;
+            std::string op = text.substr(i, len);
+            if (op == "!") {
+                error = "unexpected '!'";
+                return false;
+            }
+            tokens.push_back({ Token::OP, op == "==" ? "=" : op });
+            i += len;
+        }
+        else {
+            size_t end = i;
+            while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end]))
+                && std::string("()<>=!'\"").find(text[end]) == std::string::npos) ++end;
+            tokens.push_back({ Token::WORD, text.substr(i, end - i) });
+            i = end;
+        }
+    }
+    tokens.push_back({ Token::END, "" });
+    return true;
+}
+
+bool toCmpOp(const std::string& s, query::CmpOp& op) {
+    if (s == "<") op = query::LT;
+    else if (s == "<=") op = query::LE;
+    else if (s == ">") op = query::GT;
+    else if (s == ">=") op = query::GE;
+    else if (s == "=") op = query::EQ;
+    else if (s == "!=") op = query::NE;
+    else return false;
+    return true;
+}
+
+bool toNumber(const std::string& s, double& value) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+template <typename Table>
+std::vector<size_t> sampleRows(const Table& t) {
+    std::vector<size_t> rows;
+    size_t n = t.size();
+    size_t count = std::min(n, SAMPLE_ROWS);
+    rows.reserve(count);
+    for (size_t i = 0; i < count; ++i) rows.push_back(i * n / count);
+    return rows;
+}
+
+}
+
+class QueryExpr::Parser {
+private:
+    QueryExpr& expr;
+    std::vector<Token> tokens;
+    size_t pos;
+
+    const Token& peek() const { return tokens[pos]; }
+    bool isWord(const char* keyword) const { return peek().type == Token::WORD && lower(peek().value) == keyword; }
+    bool isOp(const char* op) const { return peek().type == Token::OP && peek().value == op; }
+
+    bool fail(const std::string& message) {
+        if (error.empty()) {
+            error = message;
+            if (peek().type != Token::END) error += " near '" + peek().value + "'";
+        }
+        return false;
+    }
+
+    int addNode(Kind kind, std::vector<int> children) {
+        Node n;
+        n.kind = kind;
+        n.leaf = -1;
+        n.cost = 0;
+        for (int c : children) n.cost += expr.nodes[c].cost;
+        n.children = std::move(children);
+        expr.nodes.push_back(n);
+        return static_cast<int>(expr.nodes.size()) - 1;
+    }
+
+    template <typename P>
+    int addLeaf(const P& pred, std::string text) {
+        Node n;
+        n.kind = LEAF;
+        n.leaf = static_cast<int>(expr.leaves.size());
+        n.cost = P::COST;
+        n.text = std::move(text);
+        expr.leaves.emplace_back(std::in_place_type<P>, pred);
+        expr.nodes.push_back(n);
+        return static_cast<int>(expr.nodes.size()) - 1;
+    }
+
+    // Joins operands of one kind, merging nested nodes of the same kind.
+    int join(Kind kind, const std::vector<int>& operands) {
+        if (operands.size() == 1) return operands[0];
+        std::vector<int> children;
+        for (int o : operands) {
+            if (expr.nodes[o].kind == kind) {
+                const std::vector<int>& inner = expr.nodes[o].children;
+                children.insert(children.end(), inner.begin(), inner.end());
+            }
+            else {
+                children.push_back(o);
+            }
+        }
+        return addNode(kind, children);
+    }
+
+    bool text(std::string& value) {
+        if (peek().type != Token::WORD && peek().type != Token::TEXT) return fail("expected text");
+        value = tokens[pos++].value;
+        return true;
+    }
+
+    bool comparison(query::CmpOp& op, double& value) {
+        if (peek().type != Token::OP || !toCmpOp(peek().value, op)) return fail("expected comparison");
+        ++pos;
+        if (peek().type != Token::WORD || !toNumber(peek().value, value)) return fail("expected number");
+        ++pos;
+        return true;
+    }
+
+    bool leaf(int& node) {
+        bool pipes = expr.target == QueryTarget::Pipes;
+        std::string what = peek().type == Token::WORD ? lower(peek().value) : "";
+        query::CmpOp op;
+        double value;
+
+        if (what == "name") {
+            ++pos;
+            std::string needle;
+            if (!isWord("contains")) return fail("expected 'contains'");
+            ++pos;
+            if (!text(needle)) return false;
+            node = addLeaf(query::NameContains(needle), "name contains '" + needle + "'");
+        }
+        else if (pipes && what == "in") {
+            ++pos;
+            if (!isWord("repair")) return fail("expected 'repair'");
+            ++pos;
+            node = addLeaf(query::RepairIs(true), "repair = 1");
+        }
+        else if (pipes && what == "repair") {
+            ++pos;
+            bool wanted = true;
+            if (peek().type == Token::OP && peek().value != "(" && peek().value != ")") {
+                if (!comparison(op, value) || (op != query::EQ && op != query::NE) || (value != 0 && value != 1))
+                    return fail("expected repair = 0|1");
+                wanted = (value == 1) == (op == query::EQ);
+            }
+            node = addLeaf(query::RepairIs(wanted), wanted ? "repair = 1" : "repair = 0");
+        }
+        else if (pipes && what == "diameter") {
+            ++pos;
+            if (!comparison(op, value)) return false;
+            node = addLeaf(query::DiameterIs(op, value), "diameter " + tokens[pos - 2].value + " " + tokens[pos - 1].value);
+        }
+        else if (!pipes && what == "idle") {
+            ++pos;
+            if (!comparison(op, value)) return false;
+            node = addLeaf(query::IdleIs(op, value), "idle " + tokens[pos - 2].value + " " + tokens[pos - 1].value);
+        }
+        else if (!pipes && what == "class") {
+            ++pos;
+            bool negate = isOp("!=");
+            if (!negate && !isOp("=")) return fail("expected class = <text>");
+            ++pos;
+            std::string name;
+            if (!text(name)) return false;
+            node = addLeaf(query::ClassIs(name), "class = '" + name + "'");
+            if (negate) node = addNode(NOT, { node });
+        }
+        else {
+            return fail(std::string("unknown condition for ") + (pipes ? "pipes" : "stations"));
+        }
+        return true;
+    }
+
+    bool factor(int& node) {
+        if (isWord("not")) {
+            ++pos;
+            int inner;
+            if (!factor(inner)) return false;
+            node = addNode(NOT, { inner });
+            return true;
+        }
+        if (isOp("(")) {
+            ++pos;
+            if (!orExpr(node)) return false;
+            if (!isOp(")")) return fail("expected ')'");
+            ++pos;
+            return true;
+        }
+        return leaf(node);
+    }
+
+    bool andExpr(int& node) {
+        std::vector<int> operands(1);
+        if (!factor(operands[0])) return false;
+        while (isWord("and")) {
+            ++pos;
+            operands.emplace_back();
+            if (!factor(operands.back())) return false;
+        }
+        node = join(AND, operands);
+        return true;
+    }
+
+    bool orExpr(int& node) {
+        std::vector<int> operands(1);
+        if (!andExpr(operands[0])) return false;
+        while (isWord("or")) {
+            ++pos;
+            operands.emplace_back();
+            if (!andExpr(operands.back())) return false;
+        }
+        node = join(OR, operands);
+        return true;
+    }
+
+public:
+    std::string error;
+
+    explicit Parser(QueryExpr& expr_) : expr(expr_), pos(0) {}
+
+    bool run(const std::string& text) {
+        if (!tokenize(text, tokens, error)) return false;
+        if (peek().type == Token::END) return fail("empty query");
+        int node;
+        if (!orExpr(node)) return false;
+        if (peek().type != Token::END) return fail("unexpected input");
+        expr.root = node;
+        return true;
+    }
+};
+
+QueryExpr::QueryExpr() : target(QueryTarget::Pipes), root(-1) {}
+
+bool QueryExpr::parse(const std::string& text, QueryTarget target_, std::string* error) {
+    target = target_;
+    nodes.clear();
+    leaves.clear();
+    root = -1;
+    Parser parser(*this);
+    if (parser.run(text)) return true;
+    nodes.clear();
+    leaves.clear();
+    root = -1;
+    if (error) *error = parser.error;
+    return false;
+}
+
+template <typename Table>
+bool QueryExpr::eval(int node, const Table& t, size_t row) const {
+    const Node& n = nodes[node];
+    switch (n.kind) {
+    case AND:
+        for (int c : n.children) if (!eval(c, t, row)) return false;
+        return true;
+    case OR:
+        for (int c : n.children) if (eval(c, t, row)) return true;
+        return false;
+    case NOT:
+        return !eval(n.children[0], t, row);
+    case LEAF:
+        return std::visit([&](const auto& p) {
+            if constexpr (std::is_invocable_r_v<bool, decltype(p), const Table&, size_t>) return p(t, row);
+            else return false;
+        }, leaves[n.leaf]);
+    }
+    return false;
+}
+
+// AND operands are ranked by cost / (1 - pass rate), OR operands by
+// cost / pass rate: a cheap test that settles most rows goes first.
+template <typename Table>
+void QueryExpr::reorder(int node, const Table& t, const std::vector<size_t>& sample) {
+    Node& n = nodes[node];
+    if (n.kind == LEAF) return;
+    for (int c : n.children) reorder(c, t, sample);
+    if (n.kind == NOT) return;
+
+    std::vector<std::pair<double, int>> ranked;
+    for (int c : n.children) {
+        double pass = 0.5;
+        if (!sample.empty()) {
+            size_t hits = 0;
+            for (size_t row : sample) hits += eval(c, t, row) ? 1 : 0;
+            pass = static_cast<double>(hits) / sample.size();
+        }
+        double decisive = n.kind == AND ? 1.0 - pass : pass;
+        ranked.push_back({ nodes[c].cost / std::max(decisive, 0.001), c });
+    }
+    std::stable_sort(ranked.begin(), ranked.end(),
+        [](const std::pair<double, int>& a, const std::pair<double, int>& b) { return a.first < b.first; });
+    for (size_t i = 0; i < ranked.size(); ++i) n.children[i] = ranked[i].second;
+}
+
+// Numeric leaves run as column kernels producing a bitmap of the whole table.
+template <typename Table>
+bool QueryExpr::scanLeaf(int node, const Table& t, uint64_t* out) const {
+    const Node& n = nodes[node];
+    if (n.kind != LEAF) return false;
+    const Leaf& leaf = leaves[n.leaf];
+    size_t rows = t.size();
+    if constexpr (std::is_same_v<Table, PipeTable>) {
+        if (const query::RepairIs* p = std::get_if<query::RepairIs>(&leaf)) {
+            filter::repairEquals(t.repairColumn().data(), rows, p->wanted != 0, out);
+            return true;
+        }
+        if (const query::DiameterIs* p = std::get_if<query::DiameterIs>(&leaf)) {
+            filter::compareDoubles(t.diameterColumn().data(), rows, p->op, p->value, out);
+            return true;
+        }
+    } else {
+        if (const query::IdleIs* p = std::get_if<query::IdleIs>(&leaf)) {
+            filter::compareIdle(t.totalColumn().data(), t.workingColumn().data(), rows, p->op, p->value, out);
+            return true;
+        }
+    }
+    return false;
+}
+
+// A numeric root leaf, or the numeric operands of a root AND, are combined
+// as bitmaps first; the other operands are only evaluated on surviving rows.
+template <typename Table>
+std::vector<int> QueryExpr::run(const Table& t) const {
+    std::vector<int> result;
+    if (root < 0) return result;
+    const std::vector<int>& ids = t.idColumn();
+    const Node& top = nodes[root];
+    const std::vector<int> single(1, root);
+    const std::vector<int>& operands = top.kind == AND ? top.children : single;
+
+    size_t words = filter::wordCount(ids.size());
+    filter::Bitmap bits, scratch;
+    std::vector<int> rest;
+    for (int c : operands) {
+        if (bits.empty()) {
+            bits.resize(words);
+            if (scanLeaf(c, t, bits.data())) continue;
+            bits.clear();
+        } else {
+            scratch.resize(words);
+            if (scanLeaf(c, t, scratch.data())) {
+                filter::andInto(bits.data(), scratch.data(), words);
+                continue;
+            }
+        }
+        rest.push_back(c);
+    }
+
+    if (bits.empty()) {
+        for (size_t row = 0; row < ids.size(); ++row) {
+            if (eval(root, t, row)) result.push_back(ids[row]);
+        }
+    } else if (rest.empty()) {
+        return filter::selectIds(bits.data(), ids);
+    } else {
+        for (size_t w = 0; w < words; ++w) {
+            for (uint64_t v = bits[w]; v; v &= v - 1) {
+                size_t row = w * 64 + static_cast<size_t>(std::countr_zero(v));
+                bool keep = true;
+                for (int c : rest) {
+                    if (!eval(c, t, row)) { keep = false; break; }
+                }
+                if (keep) result.push_back(ids[row]);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void QueryExpr::optimize(const PipeTable& t) {
+    if (root >= 0) reorder(root, t, sampleRows(t));
+}
+
+void QueryExpr::optimize(const StationTable& t) {
+    if (root >= 0) reorder(root, t, sampleRows(t));
+}
+
+bool QueryExpr::matches(const PipeTable& t, size_t row) const {
+    return root >= 0 && eval(root, t, row);
+}
+
+bool QueryExpr::matches(const StationTable& t, size_t row) const {
+    return root >= 0 && eval(root, t, row);
+}
+
+std::vector<int> QueryExpr::select(const PipeTable& t) const { return run(t); }
+std::vector<int> QueryExpr::select(const StationTable& t) const { return run(t); }
+
+bool QueryExpr::requiredName(std::string& needle) const {
+    if (root < 0) return false;
+    std::vector<int> conjuncts = nodes[root].kind == AND ? nodes[root].children : std::vector<int>{ root };
+    bool found = false;
+    for (int c : conjuncts) {
+        if (nodes[c].kind != LEAF) continue;
+        if (const query::NameContains* p = std::get_if<query::NameContains>(&leaves[nodes[c].leaf])) {
+            if (!found || p->needle.size() > needle.size()) needle = p->needle;
+            found = true;
+        }
+    }
+    return found;
+}
+
+std::string QueryExpr::describe(int node) const {
+    const Node& n = nodes[node];
+    if (n.kind == LEAF) return n.text;
+    if (n.kind == NOT) return "NOT " + describe(n.children[0]);
+    std::string s = "(";
+    for (size_t i = 0; i < n.children.size(); ++i) {
+        if (i > 0) s += n.kind == AND ? " AND " : " OR ";
+        s += describe(n.children[i]);
+    }
+    return s + ")";
+}
+
+std::string QueryExpr::toString() const {
+    return root < 0 ? std::string() : describe(root);
+}
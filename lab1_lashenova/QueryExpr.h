@@ -0,0 +1,86 @@
+#ifndef QUERYEXPR_H
+#define QUERYEXPR_H
+
+#include <string>
+#include <vector>
+#include <variant>
+#include "Query.h"
+
+enum class QueryTarget { Pipes, Stations };
+
+// Runtime counterpart of the query:: combinators, parsed from text:
+//
+//   expr   := term { OR term }
+//   term   := factor { AND factor }
+//   factor := NOT factor | ( expr ) | leaf
+//   leaf   := name contains <text>     (pipes, stations)
+//           | in repair | repair = 0|1 (pipes)
+//           | diameter <op> <number>   (pipes)
+//           | idle <op> <number>       (stations, percent)
+//           | class = <text>           (stations; != also works)
+//
+// <op> is one of < <= > >= = !=. Keywords are case-insensitive, text may be
+// 'quoted' or "quoted". Example: in repair AND diameter > 1000 AND name contains north
+//
+// Before a scan, optimize() orders the operands of every AND/OR by cost and
+// by selectivity sampled from the table, so the cheapest, most decisive test
+// runs first. Evaluation is a single fused pass and does no I/O.
+class QueryExpr {
+private:
+    typedef std::variant<query::NameContains, query::RepairIs, query::DiameterIs,
+        query::IdleIs, query::ClassIs> Leaf;
+
+    enum Kind { AND, OR, NOT, LEAF };
+
+    struct Node {
+        Kind kind;
+        std::vector<int> children;
+        int leaf;
+        int cost;
+        // Leaf text for toString().
+        std::string text;
+    };
+
+    QueryTarget target;
+    std::vector<Node> nodes;
+    std::vector<Leaf> leaves;
+    int root;
+
+    class Parser;
+
+    template <typename Table>
+    bool eval(int node, const Table& t, size_t row) const;
+    template <typename Table>
+    void reorder(int node, const Table& t, const std::vector<size_t>& sample);
+    template <typename Table>
+    bool scanLeaf(int node, const Table& t, uint64_t* out) const;
+    template <typename Table>
+    std::vector<int> run(const Table& t) const;
+    std::string describe(int node) const;
+
+public:
+    QueryExpr();
+
+    // On failure returns false and, if error is given, explains why.
+    bool parse(const std::string& text, QueryTarget target_, std::string* error = nullptr);
+    bool empty() const { return root < 0; }
+    QueryTarget getTarget() const { return target; }
+
+    void optimize(const PipeTable& t);
+    void optimize(const StationTable& t);
+
+    bool matches(const PipeTable& t, size_t row) const;
+    bool matches(const StationTable& t, size_t row) const;
+    // Ids of matching rows, ascending.
+    std::vector<int> select(const PipeTable& t) const;
+    std::vector<int> select(const StationTable& t) const;
+
+    // A substring every match must contain (a name test in the top-level
+    // AND chain), usable to narrow rows with a name index first.
+    bool requiredName(std::string& needle) const;
+
+    // Normalized form in evaluation order.
+    std::string toString() const;
+};
+
+#endif // QUERYEXPR_H
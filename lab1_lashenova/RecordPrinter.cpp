@@ -0,0 +1,133 @@
+#include "RecordPrinter.h"
+#include <algorithm>
+#include <charconv>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Calls print(row) for the selected rows in listing order.
+template <typename Table, typename Print>
+size_t forSelectedRows(const Table& table, const ListOptions& options, Print print) {
+    size_t n = table.size();
+    size_t first = std::min(options.offset, n);
+    size_t last = options.limit ? first + std::min(options.limit, n - first) : n;
+    if (!options.sorted_by_id) {
+        for (size_t row = first; row < last; ++row) print(row);
+        return last - first;
+    }
+    // Only the rows up to the end of the page need to be in order.
+    const std::vector<int>& ids = table.idColumn();
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = static_cast<uint32_t>(i);
+    auto byId = [&](uint32_t a, uint32_t b) { return ids[a] < ids[b]; };
+    if (last < n) std::partial_sort(order.begin(), order.begin() + last, order.end(), byId);
+    else std::sort(order.begin(), order.end(), byId);
+    for (size_t i = first; i < last; ++i) print(order[i]);
+    return last - first;
+}
+
+}
+
+OutputBuffer::OutputBuffer(int fd_) : fd(fd_), os(nullptr), ok(true) {
+    buf.reserve(CHUNK + 4096);
+}
+
+OutputBuffer::OutputBuffer(std::ostream& os_) : fd(-1), os(&os_), ok(true) {
+    buf.reserve(CHUNK + 4096);
+}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+void OutputBuffer::appendInt(long long value) {
+    char tmp[24];
+    std::to_chars_result r = std::to_chars(tmp, tmp + sizeof(tmp), value);
+    buf.append(tmp, r.ptr);
+}
+
+void OutputBuffer::appendDouble(double value) {
+    char tmp[32];
+    std::to_chars_result r = std::to_chars(tmp, tmp + sizeof(tmp), value, std::chars_format::general, 6);
+    buf.append(tmp, r.ptr);
+}
+
+bool OutputBuffer::flush() {
+    if (buf.empty()) return ok;
+    if (os) {
+        os->write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        ok = ok && static_cast<bool>(*os);
+    }
+    else {
+        const char* p = buf.data();
+        size_t left = buf.size();
+        while (left > 0 && ok) {
+#ifdef _WIN32
+            int written = _write(fd, p, static_cast<unsigned>(std::min<size_t>(left, 1u << 30)));
+#else
+            ssize_t written = ::write(fd, p, left);
+#endif
+            if (written <= 0) ok = false;
+            else {
+                p += written;
+                left -= static_cast<size_t>(written);
+            }
+        }
+    }
+    buf.clear();
+    return ok;
+}
+
+size_t printPipes(const PipeTable& pipes, const ListOptions& options, OutputBuffer& out) {
+    const std::vector<int>& ids = pipes.idColumn();
+    const std::vector<std::string_view>& names = pipes.nameColumn();
+    const std::vector<double>& diameters = pipes.diameterColumn();
+    const std::vector<uint8_t>& repair = pipes.repairColumn();
+    const std::vector<int>& ins = pipes.inColumn();
+    const std::vector<int>& outs = pipes.outColumn();
+    return forSelectedRows(pipes, options, [&](size_t row) {
+        out.append("ID=");
+        out.appendInt(ids[row]);
+        out.append(" | Name=\"");
+        out.append(names[row]);
+        out.append("\" | Diameter=");
+        out.appendDouble(diameters[row]);
+        out.append(repair[row] ? " | InRepair=YES" : " | InRepair=NO");
+        if (ins[row] != 0) {
+            out.append(" | Stations=");
+            out.appendInt(ins[row]);
+            out.append("->");
+            out.appendInt(outs[row]);
+        }
+        out.append('\n');
+    });
+}
+
+size_t printStations(const StationTable& stations, const ListOptions& options, OutputBuffer& out) {
+    const std::vector<int>& ids = stations.idColumn();
+    const std::vector<std::string_view>& names = stations.nameColumn();
+    const std::vector<int32_t>& totals = stations.totalColumn();
+    const std::vector<int32_t>& workings = stations.workingColumn();
+    return forSelectedRows(stations, options, [&](size_t row) {
+        int total = totals[row];
+        double idle = total <= 0 ? 0.0 : (100.0 * (total - workings[row])) / total;
+        out.append("ID=");
+        out.appendInt(ids[row]);
+        out.append(" | Name=\"");
+        out.append(names[row]);
+        out.append("\" | Total=");
+        out.appendInt(total);
+        out.append(" | Working=");
+        out.appendInt(workings[row]);
+        out.append(" | Idle%=");
+        out.appendDouble(idle);
+        out.append(" | Class=\"");
+        out.append(stations.classificationOf(row));
+        out.append("\"\n");
+    });
+}
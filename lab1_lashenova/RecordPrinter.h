@@ -0,0 +1,56 @@
+#ifndef RECORDPRINTER_H
+#define RECORDPRINTER_H
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+#include "PipeTable.h"
+#include "StationTable.h"
+
+// Which part of a listing to print. Rows are in table order unless
+// sorted_by_id; 'limit' 0 means everything after 'offset'.
+struct ListOptions {
+    size_t offset = 0;
+    size_t limit = 0;
+    bool sorted_by_id = false;
+};
+
+// Text goes into one reusable buffer and out in large writes, either
+// straight to a file descriptor or to an ostream.
+class OutputBuffer {
+private:
+    std::string buf;
+    int fd;
+    std::ostream* os;
+    bool ok;
+
+public:
+    static const size_t CHUNK = 1 << 20;
+
+    // Flush std::cout before writing to its descriptor directly.
+    explicit OutputBuffer(int fd_);
+    explicit OutputBuffer(std::ostream& os_);
+    ~OutputBuffer();
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void append(std::string_view s) {
+        buf.append(s);
+        if (buf.size() >= CHUNK) flush();
+    }
+    void append(char c) { buf += c; }
+    void appendInt(long long value);
+    // Same digits as ostream's default (%g, 6 significant).
+    void appendDouble(double value);
+    // Writes what is buffered; false once any write has failed.
+    bool flush();
+};
+
+// Same lines as operator<< on Pipe / CompressorStation, one per record.
+// Returns the number of records printed.
+size_t printPipes(const PipeTable& pipes, const ListOptions& options, OutputBuffer& out);
+size_t printStations(const StationTable& stations, const ListOptions& options, OutputBuffer& out);
+
+#endif // RECORDPRINTER_H
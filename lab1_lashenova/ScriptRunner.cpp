@@ -0,0 +1,454 @@
+#include "ScriptRunner.h"
+#include "RecordPrinter.h"
+#include <sstream>
+#include <charconv>
+
+namespace {
+
+const std::streamoff OUTPUT_FLUSH_BYTES = 1 << 20;
+// Same ranges as the interactive prompts.
+const double MAX_DIAMETER = 10000;
+const int MAX_WORKSHOPS = 10000;
+
+std::vector<std::string> tokenize(const std::string& line) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) ++i;
+        if (i >= line.size()) break;
+        std::string token;
+        if (line[i] == '"') {
+            size_t close = line.find('"', i + 1);
+            if (close == std::string::npos) close = line.size();
+            token = line.substr(i + 1, close - i - 1);
+            i = close + 1;
+        }
+        else {
+            size_t end = i;
+            while (end < line.size() && line[end] != ' ' && line[end] != '\t' && line[end] != '\r') ++end;
+            token = line.substr(i, end - i);
+            i = end;
+        }
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+bool toInt(const std::string& s, int& value) {
+    const char* first = s.data();
+    if (!s.empty() && s[0] == '+') ++first;
+    auto res = std::from_chars(first, s.data() + s.size(), value);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+bool toDouble(const std::string& s, double& value) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+bool toFlag(const std::string& s, int& value) {
+    return toInt(s, value) && (value == 0 || value == 1);
+}
+
+}
+
+ScriptRunner::ScriptRunner(Manager& manager_) : manager(manager_) {}
+
+bool ScriptRunner::parse(std::istream& in) {
+    commands.clear();
+    errors.clear();
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        parseLine(line, lineNo);
+    }
+    return errors.empty();
+}
+
+bool ScriptRunner::parseLine(const std::string& line, int lineNo) {
+    std::vector<std::string> t = tokenize(line);
+    if (t.empty() || t[0][0] == '#') return true;
+
+    ScriptCommand cmd;
+    cmd.line = lineNo;
+    cmd.a = cmd.b = cmd.c = 0;
+    cmd.x = cmd.y = 0.0;
+    cmd.use_last = false;
+
+    auto fail = [&](const std::string& why) {
+        errors.push_back("line " + std::to_string(lineNo) + ": " + why);
+        return false;
+    };
+    auto args = [&](size_t n) { return t.size() == n; };
+    auto readIds = [&](size_t from) {
+        if (t.size() == from + 1 && t[from] == "@last") {
+            cmd.use_last = true;
+            return true;
+        }
+        for (size_t i = from; i < t.size(); ++i) {
+            int id;
+            if (!toInt(t[i], id)) return false;
+            cmd.ids.push_back(id);
+        }
+        return true;
+    };
+
+    const std::string& name = t[0];
+    if (name == "add-pipe") {
+        cmd.op = ScriptOp::AddPipe;
+        if (!args(4) || !toDouble(t[2], cmd.x) || !toFlag(t[3], cmd.a)) return fail("usage: add-pipe <name> <diameter> <0|1>");
+        if (!(cmd.x >= 1 && cmd.x <= MAX_DIAMETER)) return fail("diameter must be between 1 and 10000");
+        cmd.text = t[1];
+    }
+    else if (name == "add-station") {
+        cmd.op = ScriptOp::AddStation;
+        if (!args(5) || !toInt(t[2], cmd.a) || !toInt(t[3], cmd.b) || cmd.b > cmd.a)
+            return fail("usage: add-station <name> <total> <working<=total> <class>");
+        if (cmd.a < 1 || cmd.a > MAX_WORKSHOPS || cmd.b < 0) return fail("total must be between 1 and 10000, working at least 0");
+        cmd.text = t[1];
+        cmd.text2 = t[4];
+    }
+    else if (name == "remove-pipe" || name == "remove-station") {
+        cmd.op = name == "remove-pipe" ? ScriptOp::RemovePipe : ScriptOp::RemoveStation;
+        if (!args(2) || !toInt(t[1], cmd.a)) return fail("usage: " + name + " <id>");
+    }
+    else if (name == "repair") {
+        cmd.op = ScriptOp::SetRepair;
+        if (!args(3) || !toInt(t[1], cmd.a) || !toFlag(t[2], cmd.b)) return fail("usage: repair <id> <0|1>");
+    }
+    else if (name == "set-working") {
+        cmd.op = ScriptOp::SetWorking;
+        if (!args(3) || !toInt(t[1], cmd.a) || !toInt(t[2], cmd.b) || cmd.b < 0) return fail("usage: set-working <id> <working>");
+    }
+    else if (name == "batch-repair") {
+        cmd.op = ScriptOp::BatchRepair;
+        if (t.size() < 3 || !toInt(t[1], cmd.a) || (cmd.a != 0 && cmd.a != 1) || !readIds(2))
+            return fail("usage: batch-repair <0|1> <id...|@last>");
+    }
+    else if (name == "batch-workshops") {
+        cmd.op = ScriptOp::BatchWorkshops;
+        if (t.size() < 3 || !toInt(t[1], cmd.a) || (cmd.a != 1 && cmd.a != -1) || !readIds(2))
+            return fail("usage: batch-workshops <1|-1> <id...|@last>");
+    }
+    else if (name == "connect") {
+        cmd.op = ScriptOp::Connect;
+        if (!args(4) || !toInt(t[1], cmd.a) || !toInt(t[2], cmd.b) || !toInt(t[3], cmd.c))
+            return fail("usage: connect <pipe> <from> <to>");
+    }
+    else if (name == "disconnect") {
+        cmd.op = ScriptOp::Disconnect;
+        if (!args(2) || !toInt(t[1], cmd.a)) return fail("usage: disconnect <pipe>");
+    }
+    else if (name == "load" || name == "save") {
+        cmd.op = name == "load" ? ScriptOp::Load : ScriptOp::Save;
+        if (!args(2)) return fail("usage: " + name + " <file>");
+        cmd.text = t[1];
+    }
+    else if (name == "query") {
+        if (t.size() < 2) return fail("usage: query <kind> <args>");
+        const std::string& kind = t[1];
+        if (kind == "pipes-by-name" && args(3)) {
+            cmd.op = ScriptOp::QueryPipesByName;
+            cmd.text = t[2];
+        }
+        else if (kind == "pipes-in-repair" && args(3) && toFlag(t[2], cmd.a)) {
+            cmd.op = ScriptOp::QueryPipesInRepair;
+        }
+        else if (kind == "stations-by-name" && args(3)) {
+            cmd.op = ScriptOp::QueryStationsByName;
+            cmd.text = t[2];
+        }
+        else if (kind == "stations-by-class" && args(3)) {
+            cmd.op = ScriptOp::QueryStationsByClass;
+            cmd.text = t[2];
+        }
+        else if (kind == "stations-idle" && (args(3) || args(4)) && toDouble(t[2], cmd.x)) {
+            cmd.op = ScriptOp::QueryStationsIdle;
+            cmd.y = 100.0;
+            if (args(4) && !toDouble(t[3], cmd.y)) return fail("usage: query stations-idle <min> [max]");
+        }
+        else if (kind == "stations-top" && args(3) && toInt(t[2], cmd.a) && cmd.a >= 0) {
+            cmd.op = ScriptOp::QueryStationsTop;
+        }
+        else if ((kind == "pipes-where" || kind == "stations-where") && args(3)) {
+            bool pipes = kind == "pipes-where";
+            cmd.op = pipes ? ScriptOp::QueryPipesWhere : ScriptOp::QueryStationsWhere;
+            std::string error;
+            if (!cmd.expr.parse(t[2], pipes ? QueryTarget::Pipes : QueryTarget::Stations, &error))
+                return fail("bad query: " + error);
+        }
+        else if (kind == "reachable" && args(3) && toInt(t[2], cmd.a)) {
+            cmd.op = ScriptOp::QueryReachable;
+        }
+        else if (kind == "topo-order" && args(2)) {
+            cmd.op = ScriptOp::QueryTopoOrder;
+        }
+        else if (kind == "components" && args(2)) {
+            cmd.op = ScriptOp::QueryComponents;
+        }
+        else if (kind == "max-flow" && args(4) && toInt(t[2], cmd.a) && toInt(t[3], cmd.b)) {
+            cmd.op = ScriptOp::QueryMaxFlow;
+        }
+        else {
+            return fail("unknown or malformed query '" + kind + "'");
+        }
+    }
+    else if (name == "list") {
+        // list pipes|stations [sorted] [<offset> <limit>]
+        size_t next = 2;
+        cmd.a = cmd.b = cmd.c = 0;
+        if (t.size() > next && t[next] == "sorted") {
+            cmd.c = 1;
+            ++next;
+        }
+        bool paged = t.size() == next + 2 && toInt(t[next], cmd.a) && toInt(t[next + 1], cmd.b) && cmd.a >= 0 && cmd.b >= 0;
+        if (t.size() < 2 || (t[1] != "pipes" && t[1] != "stations") || (t.size() != next && !paged))
+            return fail("usage: list pipes|stations [sorted] [<offset> <limit>]");
+        cmd.op = t[1] == "pipes" ? ScriptOp::ListPipes : ScriptOp::ListStations;
+    }
+    else if (name == "count") {
+        cmd.op = ScriptOp::Count;
+    }
+    else if (name == "stats") {
+        cmd.op = ScriptOp::Stats;
+    }
+    else if (name == "undo" || name == "redo" || name == "versions") {
+        cmd.op = name == "undo" ? ScriptOp::Undo : name == "redo" ? ScriptOp::Redo : ScriptOp::Versions;
+        if (!args(1)) return fail("usage: " + name);
+    }
+    else if (name == "history") {
+        cmd.op = ScriptOp::History;
+        if (!args(2) || !toInt(t[1], cmd.a) || cmd.a < 0) return fail("usage: history <versions>");
+    }
+    else if (name == "autosave") {
+        cmd.op = ScriptOp::Autosave;
+        if (args(2) && t[1] == "off") cmd.text.clear();
+        else if (args(4) && toInt(t[2], cmd.a) && toInt(t[3], cmd.b) && cmd.a >= 0 && cmd.b >= 0) cmd.text = t[1];
+        else return fail("usage: autosave <file> <ms> <records> | autosave off");
+    }
+    else if (name == "lazy") {
+        cmd.op = ScriptOp::Lazy;
+        if (!args(3) || !toInt(t[2], cmd.a) || cmd.a < 0) return fail("usage: lazy <file> <cache-mb>");
+        cmd.text = t[1];
+    }
+    else if (name == "show") {
+        if (!args(3) || (t[1] != "pipe" && t[1] != "station") || !toInt(t[2], cmd.a)) return fail("usage: show pipe|station <id>");
+        cmd.op = t[1] == "pipe" ? ScriptOp::ShowPipe : ScriptOp::ShowStation;
+    }
+    else if (name == "diff") {
+        cmd.op = ScriptOp::Diff;
+        if (!args(3) || !toInt(t[1], cmd.a) || !toInt(t[2], cmd.b)) return fail("usage: diff <version> <version>");
+    }
+    else {
+        return fail("unknown command '" + name + "'");
+    }
+
+    commands.push_back(cmd);
+    return true;
+}
+
+bool ScriptRunner::execute(const ScriptCommand& cmd, std::ostream& out) {
+    const std::vector<int>& ids = cmd.use_last ? last_ids : cmd.ids;
+
+    switch (cmd.op) {
+    case ScriptOp::AddPipe:
+        out << "pipe " << manager.addPipe(cmd.text, cmd.x, cmd.a != 0) << "\n";
+        return true;
+    case ScriptOp::AddStation:
+        out << "station " << manager.addStation(cmd.text, cmd.a, cmd.b, cmd.text2) << "\n";
+        return true;
+    case ScriptOp::RemovePipe:
+        return manager.removePipeById(cmd.a);
+    case ScriptOp::RemoveStation:
+        return manager.removeStationById(cmd.a);
+    case ScriptOp::SetRepair:
+        return manager.setPipeInRepair(cmd.a, cmd.b != 0);
+    case ScriptOp::SetWorking: {
+        std::optional<CompressorStation> s = manager.getStationById(cmd.a);
+        if (!s || cmd.b < 0 || cmd.b > s->getTotalWorkshops()) return false;
+        return manager.setStationWorking(cmd.a, cmd.b);
+    }
+    case ScriptOp::BatchRepair:
+        manager.batchEditPipes(ids, cmd.a);
+        out << "updated " << ids.size() << "\n";
+        return true;
+    case ScriptOp::BatchWorkshops:
+        manager.batchEditStations(ids, cmd.a);
+        out << "updated " << ids.size() << "\n";
+        return true;
+    case ScriptOp::Connect:
+        return manager.connectPipe(cmd.a, cmd.b, cmd.c);
+    case ScriptOp::Disconnect:
+        return manager.disconnectPipe(cmd.a);
+    case ScriptOp::Load:
+        return manager.loadAnyFormat(cmd.text);
+    case ScriptOp::Save:
+        return manager.saveAnyFormat(cmd.text);
+    case ScriptOp::QueryPipesByName:
+    case ScriptOp::QueryPipesInRepair:
+    case ScriptOp::QueryPipesWhere:
+        if (cmd.op == ScriptOp::QueryPipesByName) last_ids = manager.findPipeIdsByName(cmd.text);
+        else if (cmd.op == ScriptOp::QueryPipesInRepair) last_ids = manager.findPipeIdsByRepairFlag(cmd.a != 0);
+        else last_ids = manager.findPipeIds(cmd.expr);
+        out << "found " << last_ids.size() << "\n";
+        for (const Pipe& p : manager.getPipesByIds(last_ids)) out << p << "\n";
+        return true;
+    case ScriptOp::QueryStationsByName:
+    case ScriptOp::QueryStationsByClass:
+    case ScriptOp::QueryStationsIdle:
+    case ScriptOp::QueryStationsTop:
+    case ScriptOp::QueryStationsWhere:
+        if (cmd.op == ScriptOp::QueryStationsByName) last_ids = manager.findStationIdsByName(cmd.text);
+        else if (cmd.op == ScriptOp::QueryStationsByClass) last_ids = manager.findStationIdsByClass(cmd.text);
+        else if (cmd.op == ScriptOp::QueryStationsIdle) last_ids = manager.findStationIdsByIdleRange(cmd.x, cmd.y);
+        else if (cmd.op == ScriptOp::QueryStationsTop) last_ids = manager.findMostIdleStationIds(static_cast<size_t>(cmd.a));
+        else last_ids = manager.findStationIds(cmd.expr);
+        out << "found " << last_ids.size() << "\n";
+        for (const CompressorStation& s : manager.getStationsByIds(last_ids)) out << s << "\n";
+        return true;
+    case ScriptOp::QueryReachable:
+        last_ids = manager.findReachableStationIds(cmd.a);
+        out << "found " << last_ids.size() << "\n";
+        for (const CompressorStation& s : manager.getStationsByIds(last_ids)) out << s << "\n";
+        return !last_ids.empty();
+    case ScriptOp::QueryTopoOrder: {
+        if (!manager.findStationTopologicalOrder(last_ids)) {
+            out << "cycle\n";
+            return false;
+        }
+        out << "order";
+        for (int id : last_ids) out << " " << id;
+        out << "\n";
+        return true;
+    }
+    case ScriptOp::QueryComponents: {
+        std::vector<IdList> groups = manager.findConnectedStationGroups();
+        out << "components " << groups.size() << "\n";
+        for (const IdList& group : groups) {
+            for (size_t i = 0; i < group.size(); ++i) out << (i ? " " : "") << group[i];
+            out << "\n";
+        }
+        return true;
+    }
+    case ScriptOp::QueryMaxFlow: {
+        int64_t value = manager.findMaxFlow(cmd.a, cmd.b, &last_ids);
+        if (value < 0) return false;
+        out << "flow " << value << "\n";
+        for (const Pipe& p : manager.getPipesByIds(last_ids)) out << p << "\n";
+        return true;
+    }
+    case ScriptOp::ListPipes:
+    case ScriptOp::ListStations: {
+        ListOptions options;
+        options.offset = static_cast<size_t>(cmd.a);
+        options.limit = static_cast<size_t>(cmd.b);
+        options.sorted_by_id = cmd.c != 0;
+        OutputBuffer buffer(out);
+        if (cmd.op == ScriptOp::ListPipes) printPipes(manager.getPipes(), options, buffer);
+        else printStations(manager.getStations(), options, buffer);
+        return buffer.flush();
+    }
+    case ScriptOp::Count:
+        out << "pipes " << manager.getPipeCount() << " stations " << manager.getStationCount() << "\n";
+        return true;
+    case ScriptOp::Stats: {
+        const NetworkStats& st = manager.getStats();
+        out << "pipes " << st.pipeCount() << " in-repair " << st.pipesInRepair()
+            << " avg-diameter " << st.averageDiameter() << " diameters";
+        for (uint64_t c : st.diameterHistogram()) out << " " << c;
+        out << "\nstations " << st.stationCount() << " workshops " << st.workingWorkshops() << "/" << st.totalWorkshops()
+            << " avg-idle " << st.averageIdlePercent() << " idle";
+        for (uint64_t c : st.idleHistogram()) out << " " << c;
+        out << "\n";
+        return true;
+    }
+    case ScriptOp::Undo:
+    case ScriptOp::Redo: {
+        bool done = cmd.op == ScriptOp::Undo ? manager.undo() : manager.redo();
+        std::shared_ptr<const StoreVersion> v = manager.getCurrentVersion();
+        if (done) out << "version " << v->getNumber() << " " << v->getLabel() << "\n";
+        return done;
+    }
+    case ScriptOp::History:
+        return manager.setHistoryLimit(static_cast<size_t>(cmd.a));
+    case ScriptOp::Versions: {
+        std::shared_ptr<const StoreVersion> current = manager.getCurrentVersion();
+        for (const std::shared_ptr<const StoreVersion>& v : manager.getVersions()) {
+            out << (v == current ? "* " : "  ") << v->getNumber() << " " << v->getLabel() << "\n";
+        }
+        return true;
+    }
+    case ScriptOp::Autosave:
+        if (cmd.text.empty()) {
+            bool ok = manager.flushAutosave();
+            manager.stopAutosave();
+            return ok;
+        }
+        return manager.startAutosave(cmd.text, std::chrono::milliseconds(cmd.a), static_cast<size_t>(cmd.b));
+    case ScriptOp::Lazy:
+        return manager.openLazy(cmd.text, static_cast<size_t>(cmd.a) << 20);
+    case ScriptOp::ShowPipe: {
+        std::optional<Pipe> p = manager.getPipeById(cmd.a);
+        if (!p) return false;
+        out << *p << "\n";
+        return true;
+    }
+    case ScriptOp::ShowStation: {
+        std::optional<CompressorStation> s = manager.getStationById(cmd.a);
+        if (!s) return false;
+        out << *s << "\n";
+        return true;
+    }
+    case ScriptOp::Diff: {
+        VersionDiff diff;
+        if (cmd.a < 0 || cmd.b < 0 || !manager.diffVersions(cmd.a, cmd.b, diff)) return false;
+        auto show = [&](const char* what, const IdList& ids) {
+            out << what << " " << ids.size();
+            for (int id : ids) out << " " << id;
+            out << "\n";
+        };
+        show("pipes-added", diff.pipes_added);
+        show("pipes-removed", diff.pipes_removed);
+        show("pipes-changed", diff.pipes_changed);
+        show("stations-added", diff.stations_added);
+        show("stations-removed", diff.stations_removed);
+        show("stations-changed", diff.stations_changed);
+        return true;
+    }
+    }
+    return false;
+}
+
+bool ScriptRunner::runLine(const std::string& line, std::ostream& out) {
+    commands.clear();
+    errors.clear();
+    if (!parseLine(line, 1)) {
+        // Drop the "line 1: " prefix, there is only the one.
+        out << errors.back().substr(errors.back().find(": ") + 2);
+        return false;
+    }
+    if (commands.empty()) return true;
+    if (execute(commands.back(), out)) return true;
+    out << "failed";
+    return false;
+}
+
+size_t ScriptRunner::run(std::ostream& os) {
+    std::ostringstream out;
+    size_t failed = 0;
+    for (const ScriptCommand& cmd : commands) {
+        if (!execute(cmd, out)) {
+            ++failed;
+            out << "error: line " << cmd.line << " failed\n";
+        }
+        if (out.tellp() >= OUTPUT_FLUSH_BYTES) {
+            os << out.str();
+            out.str(std::string());
+        }
+    }
+    manager.flushJournal();
+    os << out.str();
+    os.flush();
+    return failed;
+}
@@ -0,0 +1,116 @@
+#ifndef SCRIPTRUNNER_H
+#define SCRIPTRUNNER_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "Manager.h"
+
+enum class ScriptOp {
+    AddPipe,
+    AddStation,
+    RemovePipe,
+    RemoveStation,
+    SetRepair,
+    SetWorking,
+    BatchRepair,
+    BatchWorkshops,
+    Connect,
+    Disconnect,
+    Load,
+    Save,
+    QueryPipesByName,
+    QueryPipesInRepair,
+    QueryStationsByName,
+    QueryStationsByClass,
+    QueryStationsIdle,
+    QueryStationsTop,
+    QueryPipesWhere,
+    QueryStationsWhere,
+    QueryReachable,
+    QueryTopoOrder,
+    QueryComponents,
+    QueryMaxFlow,
+    ListPipes,
+    ListStations,
+    Count,
+    Stats,
+    Undo,
+    Redo,
+    Versions,
+    History,
+    Diff,
+    Autosave,
+    Lazy,
+    ShowPipe,
+    ShowStation
+};
+
+struct ScriptCommand {
+    ScriptOp op;
+    int line;
+    std::string text;
+    std::string text2;
+    int a;
+    int b;
+    int c;
+    double x;
+    double y;
+    std::vector<int> ids;
+    QueryExpr expr;
+    // Batch commands given "@last" act on the ids of the previous query.
+    bool use_last;
+};
+
+// Non-interactive driver: the whole script is parsed up front, then run
+// against Manager's programmatic API with output collected in one buffer.
+//
+//   add-pipe <name> <diameter> <0|1>        add-station <name> <total> <working> <class>
+//   remove-pipe <id>                        remove-station <id>
+//   repair <id> <0|1>                       set-working <id> <working>
+//   batch-repair <0|1> <id...|@last>        batch-workshops <1|-1> <id...|@last>
+//   connect <pipe> <from> <to>              disconnect <pipe>
+//   load <file>                             save <file>
+//   query pipes-by-name <text>              query pipes-in-repair <0|1>
+//   query stations-by-name <text>           query stations-idle <min> [max]
+//   query stations-by-class <class>         query stations-top <k>
+//   query pipes-where "<expr>"              query stations-where "<expr>"
+//   query reachable <station>               query topo-order
+//   query components                        query max-flow <from> <to>
+//   list pipes|stations [sorted] [<offset> <limit>]
+//   count                                   stats
+//   history <versions>                      versions
+//   undo                                    redo
+//   diff <version> <version>               autosave <file> <ms> <records> | off
+//   lazy <file> <cache-mb>                  show pipe|station <id>
+// Undo history is off until "history" (or --history) sets its depth.
+// <expr> uses the QueryExpr syntax, e.g. "in repair AND name contains 'north'".
+// Tokens are separated by spaces; use "double quotes" for names with spaces.
+// Empty lines and lines starting with # are ignored.
+class ScriptRunner {
+private:
+    Manager& manager;
+    std::vector<ScriptCommand> commands;
+    std::vector<std::string> errors;
+    std::vector<int> last_ids;
+
+    bool parseLine(const std::string& line, int lineNo);
+    bool execute(const ScriptCommand& cmd, std::ostream& out);
+
+public:
+    ScriptRunner(Manager& manager_);
+
+    // Parses the whole script; false if any line is invalid.
+    bool parse(std::istream& in);
+    const std::vector<std::string>& getErrors() const { return errors; }
+    size_t size() const { return commands.size(); }
+
+    // Runs all parsed commands; returns the number of failed ones.
+    size_t run(std::ostream& os);
+
+    // Parses and runs one line on its own, keeping "@last" between calls.
+    // On failure 'out' receives the reason; blank and comment lines succeed.
+    bool runLine(const std::string& line, std::ostream& out);
+};
+
+#endif // SCRIPTRUNNER_H
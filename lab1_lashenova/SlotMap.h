@@ -0,0 +1,129 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Map from ids to T kept in a vector indexed by the id itself: a lookup is
+// a bounds check and one load, no hashing. Each slot has a generation that
+// is odd while the slot is live and moves on at every insert and erase, so
+// a Handle taken earlier can tell that its id was removed (and maybe added
+// again) since. Ids far above the live count, and negative ones, would
+// make the vector mostly holes; those go to a hash map on the side.
+template <typename T>
+class SlotMap {
+public:
+    struct Handle {
+        int id = 0;
+        uint32_t generation = 0;
+    };
+
+private:
+    struct Slot {
+        T value{};
+        uint32_t generation = 0;
+        bool live() const { return generation & 1; }
+    };
+
+    // Holes allowed above twice the live count before an id goes sparse.
+    static const size_t SLACK = 1 << 16;
+
+    std::vector<Slot> slots;
+    std::unordered_map<int, Slot> sparse;
+    // Smallest non-negative id in 'sparse', or -1.
+    int sparse_low = -1;
+    size_t count = 0;
+
+    // An id lives in exactly one place: the vector once it is in range,
+    // the side map otherwise. Growing the vector moves the side-map
+    // entries it now covers, so the vector is always checked first.
+    const Slot* slot(int id) const {
+        if (id >= 0 && static_cast<size_t>(id) < slots.size()) return &slots[id];
+        if (sparse.empty()) return nullptr;
+        auto it = sparse.find(id);
+        return it == sparse.end() ? nullptr : &it->second;
+    }
+    Slot* slot(int id) { return const_cast<Slot*>(static_cast<const SlotMap*>(this)->slot(id)); }
+
+    void grow(size_t size) {
+        slots.resize(size);
+        if (sparse_low < 0 || static_cast<size_t>(sparse_low) >= size) return;
+        sparse_low = -1;
+        for (auto it = sparse.begin(); it != sparse.end();) {
+            if (it->first >= 0 && static_cast<size_t>(it->first) < size) {
+                slots[it->first] = it->second;
+                it = sparse.erase(it);
+                continue;
+            }
+            if (it->first >= 0 && (sparse_low < 0 || it->first < sparse_low)) sparse_low = it->first;
+            ++it;
+        }
+    }
+
+    Slot& claim(int id) {
+        if (Slot* s = slot(id)) return *s;
+        if (id >= 0 && static_cast<size_t>(id) < 2 * count + SLACK) {
+            grow(static_cast<size_t>(id) + 1);
+            return slots[id];
+        }
+        if (id >= 0 && (sparse_low < 0 || id < sparse_low)) sparse_low = id;
+        return sparse[id];
+    }
+
+public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool contains(int id) const {
+        const Slot* s = slot(id);
+        return s && s->live();
+    }
+
+    // Ids are usually handed out from 1 upwards.
+    void reserve(size_t n) { slots.reserve(n + 1); }
+    // Starts over; handles from before are not recognized as stale.
+    void clear() {
+        slots.clear();
+        sparse.clear();
+        sparse_low = -1;
+        count = 0;
+    }
+
+    // Adds or overwrites; overwriting keeps the generation.
+    void insert(int id, const T& value) {
+        Slot& s = claim(id);
+        if (!s.live()) {
+            ++s.generation;
+            ++count;
+        }
+        s.value = value;
+    }
+    bool erase(int id) {
+        Slot* s = slot(id);
+        if (!s || !s->live()) return false;
+        ++s->generation;
+        s->value = T{};
+        --count;
+        return true;
+    }
+
+    const T* find(int id) const {
+        const Slot* s = slot(id);
+        return s && s->live() ? &s->value : nullptr;
+    }
+    T* find(int id) { return const_cast<T*>(static_cast<const SlotMap*>(this)->find(id)); }
+
+    // Handle of a live id; generation 0 (never live) otherwise.
+    Handle handle(int id) const {
+        const Slot* s = slot(id);
+        return { id, s && s->live() ? s->generation : 0 };
+    }
+    // Null once the handle's entry has been erased, even if the id is back.
+    const T* find(Handle h) const {
+        const Slot* s = slot(h.id);
+        return s && s->generation == h.generation && s->live() ? &s->value : nullptr;
+    }
+};
+
+#endif // SLOTMAP_H
@@ -0,0 +1,274 @@
+#include "Snapshot.h"
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <unordered_map>
+#include <filesystem>
+
+namespace {
+
+template <typename Table>
+std::vector<size_t> rowsSortedById(const Table& table) {
+    std::vector<size_t> order(table.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    const std::vector<int>& ids = table.idColumn();
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ids[a] < ids[b]; });
+    return order;
+}
+
+uint32_t appendToHeap(std::string& heap, std::string_view s) {
+    uint32_t offset = static_cast<uint32_t>(heap.size());
+    heap.append(s);
+    return offset;
+}
+
+uint32_t classOffset(std::string& heap, std::unordered_map<ClassId, uint32_t>& offsets, ClassId cls) {
+    auto known = offsets.find(cls);
+    if (known == offsets.end()) known = offsets.emplace(cls, appendToHeap(heap, ClassRegistry::name(cls))).first;
+    return known->second;
+}
+
+bool writeFile(const std::string& filename, const std::vector<PipeRecord>& pipeRecords,
+    const std::vector<StationRecord>& stationRecords, std::string& heap, const std::vector<PipeEndpoints>& endpoints,
+    int next_pipe_id, int next_station_id) {
+    // Offsets past 4 GiB would have wrapped in the 32-bit record fields.
+    if (heap.size() > UINT32_MAX) return false;
+    heap.resize((heap.size() + 7) & ~static_cast<size_t>(7), '\0');
+
+    SnapshotHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+    h.version = SNAPSHOT_VERSION;
+    h.pipe_count = pipeRecords.size();
+    h.station_count = stationRecords.size();
+    h.pipe_offset = sizeof(SnapshotHeader);
+    h.station_offset = h.pipe_offset + pipeRecords.size() * sizeof(PipeRecord);
+    h.heap_offset = h.station_offset + stationRecords.size() * sizeof(StationRecord);
+    h.heap_size = heap.size();
+    h.next_pipe_id = next_pipe_id;
+    h.next_station_id = next_station_id;
+
+    // Written beside the target and renamed over it: a reader that still
+    // maps the old file keeps seeing it whole.
+    const std::string temp = filename + ".tmp";
+    {
+        std::ofstream os(temp, std::ios::binary | std::ios::trunc);
+        if (!os) return false;
+        os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        os.write(reinterpret_cast<const char*>(pipeRecords.data()), pipeRecords.size() * sizeof(PipeRecord));
+        os.write(reinterpret_cast<const char*>(stationRecords.data()), stationRecords.size() * sizeof(StationRecord));
+        os.write(heap.data(), heap.size());
+        os.write(reinterpret_cast<const char*>(endpoints.data()), endpoints.size() * sizeof(PipeEndpoints));
+        os.close();
+        if (!os) {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, filename, ec);
+    if (ec) std::remove(temp.c_str());
+    return !ec;
+}
+
+}
+
+bool writeSnapshot(const std::string& filename, const PipeTable& pipes, const StationTable& stations,
+    int next_pipe_id, int next_station_id) {
+    std::vector<PipeRecord> pipeRecords(pipes.size());
+    std::vector<StationRecord> stationRecords(stations.size());
+    std::vector<PipeEndpoints> endpoints(pipes.size());
+    std::string heap;
+
+    std::vector<size_t> order = rowsSortedById(pipes);
+    for (size_t i = 0; i < order.size(); ++i) {
+        size_t row = order[i];
+        PipeRecord& r = pipeRecords[i];
+        std::memset(&r, 0, sizeof(r));
+        r.id = pipes.idColumn()[row];
+        r.in_repair = pipes.repairColumn()[row];
+        r.diameter = pipes.diameterColumn()[row];
+        r.name_offset = appendToHeap(heap, pipes.nameColumn()[row]);
+        r.name_length = static_cast<uint32_t>(pipes.nameColumn()[row].size());
+        endpoints[i].in_station = pipes.inColumn()[row];
+        endpoints[i].out_station = pipes.outColumn()[row];
+    }
+
+    // Classifications form a dictionary: every distinct one is written to
+    // the heap once and shared by all stations of that class.
+    std::unordered_map<ClassId, uint32_t> classOffsets;
+    order = rowsSortedById(stations);
+    for (size_t i = 0; i < order.size(); ++i) {
+        size_t row = order[i];
+        StationRecord& r = stationRecords[i];
+        std::memset(&r, 0, sizeof(r));
+        r.id = stations.idColumn()[row];
+        r.total_workshops = stations.totalColumn()[row];
+        r.working_workshops = stations.workingColumn()[row];
+        r.name_offset = appendToHeap(heap, stations.nameColumn()[row]);
+        r.name_length = static_cast<uint32_t>(stations.nameColumn()[row].size());
+        ClassId cls = stations.classColumn()[row];
+        r.class_offset = classOffset(heap, classOffsets, cls);
+        r.class_length = static_cast<uint32_t>(ClassRegistry::name(cls).size());
+    }
+    return writeFile(filename, pipeRecords, stationRecords, heap, endpoints, next_pipe_id, next_station_id);
+}
+
+bool writeSnapshot(const std::string& filename, const StoreVersion& version, int next_pipe_id, int next_station_id) {
+    std::vector<PipeRecord> pipeRecords;
+    std::vector<StationRecord> stationRecords;
+    std::vector<PipeEndpoints> endpoints;
+    pipeRecords.reserve(version.pipeCount());
+    stationRecords.reserve(version.stationCount());
+    endpoints.reserve(version.pipeCount());
+    std::string heap;
+
+    // Versions iterate in id order already.
+    version.forEachPipe([&](int id, const PipeState& p) {
+        PipeRecord r;
+        std::memset(&r, 0, sizeof(r));
+        r.id = id;
+        r.in_repair = p.in_repair;
+        r.diameter = p.diameter;
+        r.name_offset = appendToHeap(heap, p.name);
+        r.name_length = static_cast<uint32_t>(p.name.size());
+        pipeRecords.push_back(r);
+        endpoints.push_back(PipeEndpoints{ p.in_station, p.out_station });
+    });
+    std::unordered_map<ClassId, uint32_t> classOffsets;
+    version.forEachStation([&](int id, const StationState& st) {
+        StationRecord r;
+        std::memset(&r, 0, sizeof(r));
+        r.id = id;
+        r.total_workshops = st.total;
+        r.working_workshops = st.working;
+        r.name_offset = appendToHeap(heap, st.name);
+        r.name_length = static_cast<uint32_t>(st.name.size());
+        r.class_offset = classOffset(heap, classOffsets, st.classification);
+        r.class_length = static_cast<uint32_t>(ClassRegistry::name(st.classification).size());
+        stationRecords.push_back(r);
+    });
+    return writeFile(filename, pipeRecords, stationRecords, heap, endpoints, next_pipe_id, next_station_id);
+}
+
+bool isSnapshotFile(const std::string& filename) {
+    std::ifstream is(filename, std::ios::binary);
+    char magic[4] = {};
+    if (!is.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+}
+
+SnapshotReader::SnapshotReader()
+    : header(nullptr), pipeRecords(nullptr), stationRecords(nullptr), heap(nullptr), endpoints(nullptr) {
+}
+
+bool SnapshotReader::open(const std::string& filename) {
+    close();
+    if (!file.open(filename)) return false;
+    if (file.size() < sizeof(SnapshotHeader)) {
+        close();
+        return false;
+    }
+
+    const SnapshotHeader* h = reinterpret_cast<const SnapshotHeader*>(file.data());
+    // Counts come from the file: bound them before they are multiplied.
+    if (h->pipe_count > file.size() / sizeof(PipeRecord) || h->station_count > file.size() / sizeof(StationRecord)
+        || h->heap_size > file.size()) {
+        close();
+        return false;
+    }
+    uint64_t endpointBytes = h->version >= 2 ? h->pipe_count * sizeof(PipeEndpoints) : 0;
+    bool valid = std::memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) == 0
+        && (h->version == 1 || h->version == SNAPSHOT_VERSION)
+        && h->pipe_offset == sizeof(SnapshotHeader)
+        && h->station_offset == h->pipe_offset + h->pipe_count * sizeof(PipeRecord)
+        && h->heap_offset == h->station_offset + h->station_count * sizeof(StationRecord)
+        && (h->version == 1 || h->heap_size % 8 == 0)
+        && h->heap_offset + h->heap_size + endpointBytes == file.size();
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    header = h;
+    pipeRecords = reinterpret_cast<const PipeRecord*>(file.data() + h->pipe_offset);
+    stationRecords = reinterpret_cast<const StationRecord*>(file.data() + h->station_offset);
+    heap = file.data() + h->heap_offset;
+    if (endpointBytes) endpoints = reinterpret_cast<const PipeEndpoints*>(heap + h->heap_size);
+    return true;
+}
+
+void SnapshotReader::swap(SnapshotReader& other) {
+    file.swap(other.file);
+    std::swap(header, other.header);
+    std::swap(pipeRecords, other.pipeRecords);
+    std::swap(stationRecords, other.stationRecords);
+    std::swap(heap, other.heap);
+    std::swap(endpoints, other.endpoints);
+}
+
+void SnapshotReader::close() {
+    file.close();
+    header = nullptr;
+    pipeRecords = nullptr;
+    stationRecords = nullptr;
+    heap = nullptr;
+    endpoints = nullptr;
+}
+
+size_t SnapshotReader::pipeCount() const { return header ? static_cast<size_t>(header->pipe_count) : 0; }
+size_t SnapshotReader::stationCount() const { return header ? static_cast<size_t>(header->station_count) : 0; }
+int SnapshotReader::nextPipeId() const { return header ? header->next_pipe_id : 1; }
+int SnapshotReader::nextStationId() const { return header ? header->next_station_id : 1; }
+
+std::string_view SnapshotReader::heapString(uint32_t offset, uint32_t length) const {
+    if (static_cast<uint64_t>(offset) + length > header->heap_size) return std::string_view();
+    return std::string_view(heap + offset, length);
+}
+
+PipeEndpoints SnapshotReader::pipeEndpoints(size_t i) const {
+    if (!endpoints) return PipeEndpoints{ 0, 0 };
+    return endpoints[i];
+}
+
+std::string_view SnapshotReader::pipeName(size_t i) const {
+    return heapString(pipeRecords[i].name_offset, pipeRecords[i].name_length);
+}
+
+std::string_view SnapshotReader::stationName(size_t i) const {
+    return heapString(stationRecords[i].name_offset, stationRecords[i].name_length);
+}
+
+std::string_view SnapshotReader::stationClassification(size_t i) const {
+    return heapString(stationRecords[i].class_offset, stationRecords[i].class_length);
+}
+
+Pipe SnapshotReader::pipeAt(size_t i) const {
+    const PipeRecord& r = pipeRecords[i];
+    PipeEndpoints e = pipeEndpoints(i);
+    return Pipe(r.id, std::string(pipeName(i)), r.diameter, r.in_repair != 0, e.in_station, e.out_station);
+}
+
+CompressorStation SnapshotReader::stationAt(size_t i) const {
+    const StationRecord& r = stationRecords[i];
+    return CompressorStation(r.id, std::string(stationName(i)), r.total_workshops, r.working_workshops,
+        ClassRegistry::intern(stationClassification(i)));
+}
+
+ptrdiff_t SnapshotReader::findPipe(int id) const {
+    const PipeRecord* first = pipeRecords;
+    const PipeRecord* last = pipeRecords + pipeCount();
+    const PipeRecord* it = std::lower_bound(first, last, id,
+        [](const PipeRecord& r, int key) { return r.id < key; });
+    return (it != last && it->id == id) ? it - first : -1;
+}
+
+ptrdiff_t SnapshotReader::findStation(int id) const {
+    const StationRecord* first = stationRecords;
+    const StationRecord* last = stationRecords + stationCount();
+    const StationRecord* it = std::lower_bound(first, last, id,
+        [](const StationRecord& r, int key) { return r.id < key; });
+    return (it != last && it->id == id) ? it - first : -1;
+}
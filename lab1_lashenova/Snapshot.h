@@ -0,0 +1,117 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include "MappedFile.h"
+#include "PipeTable.h"
+#include "StationTable.h"
+#include "VersionHistory.h"
+
+// Binary snapshot layout (little-endian):
+//   SnapshotHeader | PipeRecord[pipe_count] | StationRecord[station_count] | string heap
+// Records are sorted by id, names live in the heap as (offset, length).
+// Station classifications are deduplicated: equal classes share one heap entry.
+// Version 2 pads the heap to 8 bytes and appends PipeEndpoints[pipe_count]
+// in pipe record order; version 1 files (no endpoints) are still read.
+const char SNAPSHOT_MAGIC[4] = { 'L', 'S', 'N', 'P' };
+const uint32_t SNAPSHOT_VERSION = 2;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t pipe_count;
+    uint64_t station_count;
+    uint64_t pipe_offset;
+    uint64_t station_offset;
+    uint64_t heap_offset;
+    uint64_t heap_size;
+    int32_t next_pipe_id;
+    int32_t next_station_id;
+};
+
+struct PipeRecord {
+    int32_t id;
+    uint8_t in_repair;
+    uint8_t reserved[3];
+    double diameter;
+    uint32_t name_offset;
+    uint32_t name_length;
+};
+
+struct StationRecord {
+    int32_t id;
+    int32_t total_workshops;
+    int32_t working_workshops;
+    uint32_t name_offset;
+    uint32_t name_length;
+    uint32_t class_offset;
+    uint32_t class_length;
+    uint32_t reserved;
+};
+
+struct PipeEndpoints {
+    int32_t in_station;
+    int32_t out_station;
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header layout");
+static_assert(sizeof(PipeRecord) == 24, "pipe record layout");
+static_assert(sizeof(StationRecord) == 32, "station record layout");
+static_assert(sizeof(PipeEndpoints) == 8, "pipe endpoints layout");
+
+// Heap offsets are 32-bit: both fail if the names take more than 4 GiB.
+bool writeSnapshot(const std::string& filename, const PipeTable& pipes, const StationTable& stations,
+    int next_pipe_id, int next_station_id);
+// Same layout from a committed version; safe to call on any thread.
+bool writeSnapshot(const std::string& filename, const StoreVersion& version, int next_pipe_id, int next_station_id);
+
+// True if the file starts with the snapshot magic.
+bool isSnapshotFile(const std::string& filename);
+
+// Zero-copy view over a mapped snapshot. Opening only validates the header;
+// records are read from the mapping when accessed.
+class SnapshotReader {
+private:
+    MappedFile file;
+    const SnapshotHeader* header;
+    const PipeRecord* pipeRecords;
+    const StationRecord* stationRecords;
+    const char* heap;
+    const PipeEndpoints* endpoints;
+
+    std::string_view heapString(uint32_t offset, uint32_t length) const;
+
+public:
+    SnapshotReader();
+
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+    // Takes over the other reader's mapping without reopening the file.
+    void swap(SnapshotReader& other);
+
+    size_t pipeCount() const;
+    size_t stationCount() const;
+    int nextPipeId() const;
+    int nextStationId() const;
+
+    const PipeRecord& pipeRecord(size_t i) const { return pipeRecords[i]; }
+    const StationRecord& stationRecord(size_t i) const { return stationRecords[i]; }
+    // {0, 0} for unconnected pipes and version 1 files.
+    PipeEndpoints pipeEndpoints(size_t i) const;
+    std::string_view pipeName(size_t i) const;
+    std::string_view stationName(size_t i) const;
+    std::string_view stationClassification(size_t i) const;
+
+    Pipe pipeAt(size_t i) const;
+    CompressorStation stationAt(size_t i) const;
+
+    // Index of the record with the given id or -1 (binary search).
+    ptrdiff_t findPipe(int id) const;
+    ptrdiff_t findStation(int id) const;
+};
+
+#endif // SNAPSHOT_H
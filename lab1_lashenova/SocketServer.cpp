@@ -0,0 +1,229 @@
+#include "SocketServer.h"
+
+SocketServer::SocketServer(Manager& manager_, const std::string& path_)
+    : manager(manager_), path(path_), stopping(false), listening(false), requests(0), connections(0) {}
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include "ScriptRunner.h"
+
+namespace {
+
+const int WAIT_MS = 200;
+const size_t READ_CHUNK = 64 * 1024;
+const int MAX_EVENTS = 64;
+
+struct Connection {
+    int fd;
+    std::string in;
+    size_t in_pos = 0;
+    std::string out;
+    size_t out_pos = 0;
+    bool peer_closed = false;
+    uint32_t events = 0;
+    ScriptRunner runner;
+
+    Connection(int fd_, Manager& manager) : fd(fd_), runner(manager) {}
+    size_t pending() const { return out.size() - out_pos; }
+};
+
+void appendReply(std::string& out, bool ok, const std::string& body) {
+    out += ok ? "OK " : "ERR ";
+    out += std::to_string(body.size());
+    out += '\n';
+    out += body;
+}
+
+// Reads everything available; false on a socket error.
+bool readInput(Connection& c) {
+    while (true) {
+        size_t used = c.in.size();
+        c.in.resize(used + READ_CHUNK);
+        ssize_t got = recv(c.fd, c.in.data() + used, READ_CHUNK, 0);
+        c.in.resize(used + (got > 0 ? static_cast<size_t>(got) : 0));
+        if (got > 0) continue;
+        if (got == 0) {
+            c.peer_closed = true;
+            return true;
+        }
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+// Writes until done or the socket is full; false on a socket error.
+bool writeOutput(Connection& c) {
+    while (c.pending() > 0) {
+        ssize_t sent = send(c.fd, c.out.data() + c.out_pos, c.pending(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            c.out_pos += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        return sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    c.out.clear();
+    c.out_pos = 0;
+    return true;
+}
+
+bool hasRequest(const Connection& c) {
+    return c.in.find('\n', c.in_pos) != std::string::npos;
+}
+
+}
+
+bool SocketServer::run() {
+    stopping = false;
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) return false;
+    unlink(path.c_str());
+    int ep = -1;
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, SOMAXCONN) != 0
+        || (ep = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        close(listener);
+        return false;
+    }
+    // The listener is the only entry without a Connection.
+    epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    epoll_ctl(ep, EPOLL_CTL_ADD, listener, &ev);
+
+    std::unordered_map<int, std::unique_ptr<Connection>> open;
+    std::ostringstream body;
+    bool shutdownRequested = false;
+
+    auto drop = [&](Connection& c) {
+        epoll_ctl(ep, EPOLL_CTL_DEL, c.fd, nullptr);
+        close(c.fd);
+        open.erase(c.fd);
+    };
+
+    // Answers complete requests until the connection's backlog is full.
+    auto serve = [&](Connection& c) {
+        size_t served = 0;
+        while (c.pending() < MAX_PENDING_OUTPUT && !shutdownRequested) {
+            size_t eol = c.in.find('\n', c.in_pos);
+            if (eol == std::string::npos) break;
+            std::string line = c.in.substr(c.in_pos, eol - c.in_pos);
+            c.in_pos = eol + 1;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            ++served;
+            if (line == "shutdown") {
+                appendReply(c.out, true, std::string());
+                shutdownRequested = true;
+                break;
+            }
+            body.str(std::string());
+            bool ok = c.runner.runLine(line, body);
+            appendReply(c.out, ok, body.str());
+        }
+        if (c.in_pos == c.in.size()) {
+            c.in.clear();
+            c.in_pos = 0;
+        }
+        else if (c.in_pos > READ_CHUNK) {
+            c.in.erase(0, c.in_pos);
+            c.in_pos = 0;
+        }
+        requests += served;
+        return served;
+    };
+
+    // Event-driven work on one connection; false once it is closed.
+    auto work = [&](Connection& c, uint32_t events) {
+        if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && !c.peer_closed && !readInput(c)) {
+            drop(c);
+            return false;
+        }
+        while (true) {
+            size_t served = serve(c);
+            if (!writeOutput(c)) {
+                drop(c);
+                return false;
+            }
+            if (served == 0 || c.pending() > 0) break;
+        }
+        if (c.peer_closed && c.pending() == 0 && !hasRequest(c)) {
+            drop(c);
+            return false;
+        }
+        // Stop reading while the reply backlog is full; resume once it drains.
+        uint32_t want = (c.pending() > 0 ? uint32_t(EPOLLOUT) : 0u)
+            | (!c.peer_closed && c.pending() < MAX_PENDING_OUTPUT ? uint32_t(EPOLLIN | EPOLLRDHUP) : 0u);
+        if (want != c.events) {
+            epoll_event mod;
+            std::memset(&mod, 0, sizeof(mod));
+            mod.events = want;
+            mod.data.ptr = &c;
+            epoll_ctl(ep, EPOLL_CTL_MOD, c.fd, &mod);
+            c.events = want;
+        }
+        return true;
+    };
+
+    listening = true;
+    epoll_event events[MAX_EVENTS];
+    while (!stopping && !shutdownRequested) {
+        int n = epoll_wait(ep, events, MAX_EVENTS, WAIT_MS);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        uint64_t before = requests;
+        for (int i = 0; i < n; ++i) {
+            if (!events[i].data.ptr) {
+                int fd;
+                while ((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    auto c = std::make_unique<Connection>(fd, manager);
+                    epoll_event add;
+                    std::memset(&add, 0, sizeof(add));
+                    add.events = c->events = EPOLLIN | EPOLLRDHUP;
+                    add.data.ptr = c.get();
+                    epoll_ctl(ep, EPOLL_CTL_ADD, fd, &add);
+                    open.emplace(fd, std::move(c));
+                    ++connections;
+                }
+                continue;
+            }
+            work(*static_cast<Connection*>(events[i].data.ptr), events[i].events);
+        }
+        // One journal flush covers every edit of the batch.
+        if (requests != before) manager.flushJournal();
+    }
+
+    listening = false;
+    for (auto& entry : open) {
+        writeOutput(*entry.second);
+        close(entry.first);
+    }
+    close(ep);
+    close(listener);
+    unlink(path.c_str());
+    return true;
+}
+
+#else
+
+bool SocketServer::run() {
+    return false;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef SOCKETSERVER_H
+#define SOCKETSERVER_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "Manager.h"
+
+// Daemon mode: one resident Manager served over a Unix domain socket from
+// a single epoll thread (Linux only; elsewhere run() reports failure).
+//
+// Protocol: a request is one script line (see ScriptRunner) ended by '\n'.
+// Every request gets exactly one reply, in request order:
+//   "OK <length>\n" or "ERR <length>\n", then <length> bytes of output.
+// Clients may pipeline any number of requests. All complete requests in a
+// read are answered together and their replies leave in as few writes as
+// the socket allows. Each connection has its own "@last" result. The
+// request "shutdown" stops the server after its reply.
+class SocketServer {
+private:
+    Manager& manager;
+    std::string path;
+    std::atomic<bool> stopping;
+    std::atomic<bool> listening;
+    std::atomic<uint64_t> requests;
+    std::atomic<uint64_t> connections;
+
+public:
+    // A connection's unsent replies above this stop reading its requests.
+    static const size_t MAX_PENDING_OUTPUT = 4 << 20;
+
+    SocketServer(Manager& manager_, const std::string& path_);
+
+    // Serves until stop() or a "shutdown" request; false if the socket
+    // could not be set up. An existing file at the path is replaced.
+    bool run();
+    // Safe from other threads and signal handlers.
+    void stop() { stopping = true; }
+    bool isListening() const { return listening; }
+
+    uint64_t requestCount() const { return requests; }
+    uint64_t connectionCount() const { return connections; }
+};
+
+#endif // SOCKETSERVER_H
@@ -0,0 +1,111 @@
+#include "StationTable.h"
+
+StationTable::StationTable() : live_name_bytes(0) {}
+
+void StationTable::reserve(size_t n) {
+    ids.reserve(n);
+    totals.reserve(n);
+    workings.reserve(n);
+    names.reserve(n);
+    classes.reserve(n);
+    rows.reserve(n);
+}
+
+void StationTable::reserveNames(size_t bytes) {
+    arena.reserve(bytes);
+}
+
+void StationTable::clear() {
+    ids.clear();
+    totals.clear();
+    workings.clear();
+    names.clear();
+    classes.clear();
+    rows.clear();
+    arena.clear();
+    live_name_bytes = 0;
+}
+
+void StationTable::insert(int id, std::string_view name, int total, int working, ClassId classification) {
+    if (const uint32_t* known = rows.find(id)) {
+        size_t row = *known;
+        live_name_bytes -= names[row].size();
+        live_name_bytes += name.size();
+        names[row] = arena.store(name);
+        totals[row] = total;
+        workings[row] = working;
+        classes[row] = classification;
+        if (arena.bytes() > 2 * live_name_bytes + (1 << 20)) compactNames();
+        return;
+    }
+    rows.insert(id, static_cast<uint32_t>(ids.size()));
+    ids.push_back(id);
+    names.push_back(arena.store(name));
+    totals.push_back(total);
+    workings.push_back(working);
+    classes.push_back(classification);
+    live_name_bytes += name.size();
+}
+
+void StationTable::insert(int id, std::string_view name, int total, int working, std::string_view classification) {
+    insert(id, name, total, working, ClassRegistry::intern(classification));
+}
+
+void StationTable::insert(const CompressorStation& station) {
+    insert(station.getId(), station.getName(), station.getTotalWorkshops(),
+        station.getWorkingWorkshops(), station.getClassId());
+}
+
+void StationTable::compactNames() {
+    StringArena fresh;
+    fresh.reserve(live_name_bytes);
+    for (std::string_view& name : names) name = fresh.store(name);
+    arena = std::move(fresh);
+}
+
+bool StationTable::erase(int id) {
+    const uint32_t* known = rows.find(id);
+    if (!known) return false;
+
+    size_t row = *known;
+    size_t last = ids.size() - 1;
+    live_name_bytes -= names[row].size();
+    if (row != last) {
+        ids[row] = ids[last];
+        names[row] = names[last];
+        totals[row] = totals[last];
+        workings[row] = workings[last];
+        classes[row] = classes[last];
+        *rows.find(ids[row]) = static_cast<uint32_t>(row);
+    }
+    ids.pop_back();
+    names.pop_back();
+    totals.pop_back();
+    workings.pop_back();
+    classes.pop_back();
+    rows.erase(id);
+    if (arena.bytes() > 2 * live_name_bytes + (1 << 20)) compactNames();
+    return true;
+}
+
+ptrdiff_t StationTable::rowOf(int id) const {
+    const uint32_t* row = rows.find(id);
+    return row ? static_cast<ptrdiff_t>(*row) : -1;
+}
+
+CompressorStation StationTable::at(size_t row) const {
+    return CompressorStation(ids[row], std::string(names[row]), totals[row], workings[row], classes[row]);
+}
+
+std::optional<CompressorStation> StationTable::get(int id) const {
+    ptrdiff_t row = rowOf(id);
+    if (row < 0) return std::nullopt;
+    return at(static_cast<size_t>(row));
+}
+
+bool StationTable::setWorkingWorkshops(int id, int w) {
+    ptrdiff_t row = rowOf(id);
+    if (row < 0) return false;
+    workings[row] = w;
+    return true;
+}
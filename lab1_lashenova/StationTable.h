@@ -0,0 +1,79 @@
+#ifndef STATIONTABLE_H
+#define STATIONTABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <optional>
+#include "CompressorStation.h"
+#include "StringArena.h"
+#include "SlotMap.h"
+
+// Column-oriented station storage, same layout rules as PipeTable.
+class StationTable {
+private:
+    std::vector<int> ids;
+    std::vector<int32_t> totals;
+    std::vector<int32_t> workings;
+    std::vector<std::string_view> names;
+    std::vector<ClassId> classes;
+    // Row of each id.
+    SlotMap<uint32_t> rows;
+    StringArena arena;
+    size_t live_name_bytes;
+
+    void compactNames();
+
+public:
+    StationTable();
+    StationTable(const StationTable&) = delete;
+    StationTable& operator=(const StationTable&) = delete;
+
+    class const_iterator {
+    private:
+        const StationTable* table;
+        size_t row;
+    public:
+        const_iterator(const StationTable* t, size_t r) : table(t), row(r) {}
+        std::pair<int, CompressorStation> operator*() const { return { table->ids[row], table->at(row) }; }
+        const_iterator& operator++() { ++row; return *this; }
+        bool operator==(const const_iterator& o) const { return row == o.row; }
+        bool operator!=(const const_iterator& o) const { return row != o.row; }
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, ids.size()); }
+
+    size_t size() const { return ids.size(); }
+    size_t capacity() const { return ids.capacity(); }
+    bool empty() const { return ids.empty(); }
+    bool contains(int id) const { return rows.contains(id); }
+
+    void reserve(size_t n);
+    // Reserves arena space for the next 'bytes' of names.
+    void reserveNames(size_t bytes);
+    void clear();
+    void insert(int id, std::string_view name, int total, int working, ClassId classification);
+    void insert(int id, std::string_view name, int total, int working, std::string_view classification);
+    void insert(const CompressorStation& station);
+    bool erase(int id);
+
+    // Row of the given id or -1.
+    ptrdiff_t rowOf(int id) const;
+    CompressorStation at(size_t row) const;
+    // Empty when the id is not in the table.
+    std::optional<CompressorStation> get(int id) const;
+    bool setWorkingWorkshops(int id, int w);
+
+    const std::vector<int>& idColumn() const { return ids; }
+    const std::vector<int32_t>& totalColumn() const { return totals; }
+    const std::vector<int32_t>& workingColumn() const { return workings; }
+    const std::vector<std::string_view>& nameColumn() const { return names; }
+    const std::vector<ClassId>& classColumn() const { return classes; }
+    const std::string& classificationOf(size_t row) const { return ClassRegistry::name(classes[row]); }
+};
+
+#endif // STATIONTABLE_H
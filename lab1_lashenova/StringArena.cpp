@@ -0,0 +1,32 @@
+#include "StringArena.h"
+#include <cstring>
+#include <algorithm>
+
+namespace {
+const size_t BLOCK_SIZE = 1 << 20;
+}
+
+StringArena::StringArena() : used(0), total_bytes(0) {}
+
+void StringArena::reserve(size_t bytes) {
+    if (!blocks.empty() && blocks.back().size - used >= bytes) return;
+    size_t size = std::max(bytes, BLOCK_SIZE);
+    blocks.push_back(Block{ std::unique_ptr<char[]>(new char[size]), size });
+    used = 0;
+}
+
+std::string_view StringArena::store(std::string_view s) {
+    if (s.empty()) return std::string_view();
+    reserve(s.size());
+    char* dest = blocks.back().data.get() + used;
+    std::memcpy(dest, s.data(), s.size());
+    used += s.size();
+    total_bytes += s.size();
+    return std::string_view(dest, s.size());
+}
+
+void StringArena::clear() {
+    blocks.clear();
+    used = 0;
+    total_bytes = 0;
+}
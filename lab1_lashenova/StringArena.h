@@ -0,0 +1,35 @@
+#ifndef STRINGARENA_H
+#define STRINGARENA_H
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+// Monotonic byte arena for string storage. Stored views stay valid until
+// clear(); nothing is freed individually.
+class StringArena {
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t used;
+    size_t total_bytes;
+
+public:
+    StringArena();
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+
+    std::string_view store(std::string_view s);
+    // Makes sure the next 'bytes' of strings fit into one block.
+    void reserve(size_t bytes);
+    void clear();
+
+    size_t bytes() const { return total_bytes; }
+};
+
+#endif // STRINGARENA_H
@@ -0,0 +1,116 @@
+#include "TextLoader.h"
+#include <fstream>
+#include <thread>
+#include <charconv>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+const size_t READ_BLOCK = 1 << 20;
+const size_t MIN_CHUNK = 1 << 20;
+
+// Cuts the next '|'-separated field off the front of line.
+std::string_view nextField(std::string_view& line) {
+    size_t bar = line.find('|');
+    std::string_view field = line.substr(0, bar);
+    line = bar == std::string_view::npos ? std::string_view() : line.substr(bar + 1);
+    return field;
+}
+
+bool toInt(std::string_view s, int& value) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+    return res.ec == std::errc();
+}
+
+bool toDouble(std::string_view s, double& value) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+    return res.ec == std::errc();
+}
+
+void parseLine(std::string_view line, TextChunk& out) {
+    std::string_view type = nextField(line);
+
+    if (type == "PIPE") {
+        TextPipe p;
+        std::string_view id = nextField(line);
+        p.name = nextField(line);
+        std::string_view diameter = nextField(line);
+        std::string_view repair = nextField(line);
+        std::string_view from = nextField(line);
+        std::string_view to = nextField(line);
+        if (!toInt(id, p.id) || !toDouble(diameter, p.diameter)) return;
+        p.in_repair = repair == "1";
+        if (from.empty() || !toInt(from, p.in_station) || !toInt(to, p.out_station)) p.in_station = p.out_station = 0;
+        out.pipes.push_back(p);
+    }
+    else if (type == "STATION") {
+        TextStation s;
+        std::string_view id = nextField(line);
+        s.name = nextField(line);
+        std::string_view total = nextField(line);
+        std::string_view working = nextField(line);
+        s.classification = nextField(line);
+        if (!toInt(id, s.id) || !toInt(total, s.total) || !toInt(working, s.working)) return;
+        out.stations.push_back(s);
+    }
+}
+
+void parseChunk(const char* begin, const char* end, TextChunk& out) {
+    while (begin < end) {
+        const char* eol = std::find(begin, end, '\n');
+        std::string_view line(begin, eol - begin);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (!line.empty()) parseLine(line, out);
+        begin = eol + 1;
+    }
+}
+
+}
+
+void TextLoader::parse(const char* begin, const char* end, TextChunk& out) {
+    parseChunk(begin, end, out);
+}
+
+bool TextLoader::load(const std::string& filename, size_t threads) {
+    buffer.clear();
+    chunks.clear();
+
+    std::ifstream is(filename, std::ios::binary);
+    if (!is) return false;
+
+    is.seekg(0, std::ios::end);
+    buffer.reserve(static_cast<size_t>(is.tellg()) + READ_BLOCK);
+    is.seekg(0, std::ios::beg);
+    while (is) {
+        size_t used = buffer.size();
+        buffer.resize(used + READ_BLOCK);
+        is.read(buffer.data() + used, READ_BLOCK);
+        buffer.resize(used + static_cast<size_t>(is.gcount()));
+    }
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, buffer.size() / MIN_CHUNK + 1));
+
+    // Chunk boundaries are moved forward to the next line start.
+    const char* data = buffer.data();
+    const char* end = data + buffer.size();
+    std::vector<const char*> bounds = { data };
+    for (size_t i = 1; i < threads; ++i) {
+        const char* cut = data + buffer.size() * i / threads;
+        if (cut <= bounds.back()) continue;
+        cut = std::find(cut, end, '\n');
+        if (cut != end) ++cut;
+        bounds.push_back(cut);
+    }
+    bounds.push_back(end);
+
+    chunks.resize(bounds.size() - 1);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        workers.emplace_back(parseChunk, bounds[i], bounds[i + 1], std::ref(chunks[i]));
+    }
+    parseChunk(bounds[0], bounds[1], chunks[0]);
+    for (auto& t : workers) t.join();
+    return true;
+}
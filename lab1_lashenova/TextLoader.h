@@ -0,0 +1,52 @@
+#ifndef TEXTLOADER_H
+#define TEXTLOADER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// Records parsed from the PIPE|/STATION| text format. Strings point into
+// the bytes that were parsed: for load() that is the loader's own copy of
+// the file, so they are valid only while the TextLoader is alive. Manager
+// copies the names into its tables' arenas.
+struct TextPipe {
+    int id;
+    std::string_view name;
+    double diameter;
+    bool in_repair;
+    // Optional trailing fields; 0 when absent.
+    int in_station;
+    int out_station;
+};
+
+struct TextStation {
+    int id;
+    std::string_view name;
+    int total;
+    int working;
+    std::string_view classification;
+};
+
+struct TextChunk {
+    std::vector<TextPipe> pipes;
+    std::vector<TextStation> stations;
+};
+
+// Splits the file into line-aligned chunks and parses them in parallel
+// with std::from_chars. Chunks are returned in file order.
+class TextLoader {
+private:
+    std::vector<char> buffer;
+    std::vector<TextChunk> chunks;
+
+public:
+    bool load(const std::string& filename, size_t threads = 0);
+    // Parses the whole lines in [begin, end) into 'out'; views point into the range.
+    static void parse(const char* begin, const char* end, TextChunk& out);
+
+    const std::vector<TextChunk>& getChunks() const { return chunks; }
+    size_t bytes() const { return buffer.size(); }
+};
+
+#endif // TEXTLOADER_H
@@ -0,0 +1,87 @@
+#include "TrigramIndex.h"
+#include <algorithm>
+#include <iterator>
+
+uint32_t TrigramIndex::gramAt(std::string_view s, size_t i) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(s[i])) << 16
+        | static_cast<uint32_t>(static_cast<uint8_t>(s[i + 1])) << 8
+        | static_cast<uint32_t>(static_cast<uint8_t>(s[i + 2]));
+}
+
+std::vector<uint32_t> TrigramIndex::trigramsOf(std::string_view s) {
+    std::vector<uint32_t> result;
+    if (s.size() < 3) return result;
+    result.reserve(s.size() - 2);
+    for (size_t i = 0; i + 2 < s.size(); ++i) result.push_back(gramAt(s, i));
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void TrigramIndex::clear() {
+    postings.clear();
+}
+
+// Repeated trigrams of one name are harmless here: the id is already
+// present in the list the second time.
+void TrigramIndex::add(int id, std::string_view name) {
+    for (size_t i = 0; i + 2 < name.size(); ++i) {
+        std::vector<int>& list = postings[gramAt(name, i)];
+        if (list.empty() || list.back() < id) {
+            list.push_back(id);
+        }
+        else {
+            auto it = std::lower_bound(list.begin(), list.end(), id);
+            if (it == list.end() || *it != id) list.insert(it, id);
+        }
+    }
+}
+
+void TrigramIndex::remove(int id, std::string_view name) {
+    for (size_t i = 0; i + 2 < name.size(); ++i) {
+        auto entry = postings.find(gramAt(name, i));
+        if (entry == postings.end()) continue;
+        std::vector<int>& list = entry->second;
+        auto it = std::lower_bound(list.begin(), list.end(), id);
+        if (it != list.end() && *it == id) list.erase(it);
+        if (list.empty()) postings.erase(entry);
+    }
+}
+
+void TrigramIndex::rebuild(const std::vector<int>& ids, const std::vector<std::string_view>& names) {
+    postings.clear();
+    for (size_t row = 0; row < ids.size(); ++row) {
+        for (uint32_t t : trigramsOf(names[row])) postings[t].push_back(ids[row]);
+    }
+    for (auto& entry : postings) {
+        std::vector<int>& list = entry.second;
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+    }
+}
+
+bool TrigramIndex::candidates(const std::string& pattern, std::vector<int>& out) const {
+    out.clear();
+    std::vector<uint32_t> grams = trigramsOf(pattern);
+    if (grams.empty()) return false;
+
+    std::vector<const std::vector<int>*> lists;
+    lists.reserve(grams.size());
+    for (uint32_t t : grams) {
+        auto entry = postings.find(t);
+        if (entry == postings.end()) return true;
+        lists.push_back(&entry->second);
+    }
+    std::sort(lists.begin(), lists.end(),
+        [](const std::vector<int>* a, const std::vector<int>* b) { return a->size() < b->size(); });
+
+    out = *lists[0];
+    std::vector<int> next;
+    for (size_t i = 1; i < lists.size() && !out.empty(); ++i) {
+        next.clear();
+        std::set_intersection(out.begin(), out.end(), lists[i]->begin(), lists[i]->end(),
+            std::back_inserter(next));
+        out.swap(next);
+    }
+    return true;
+}
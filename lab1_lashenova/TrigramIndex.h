@@ -0,0 +1,33 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Inverted index from every 3-byte substring of a name to the sorted ids
+// whose name contains it. Substring queries intersect the posting lists of
+// the pattern's trigrams; the caller verifies the surviving candidates.
+class TrigramIndex {
+private:
+    std::unordered_map<uint32_t, std::vector<int>> postings;
+
+    static uint32_t gramAt(std::string_view s, size_t i);
+    // Distinct trigrams of s, sorted.
+    static std::vector<uint32_t> trigramsOf(std::string_view s);
+
+public:
+    void clear();
+    void add(int id, std::string_view name);
+    void remove(int id, std::string_view name);
+    // Bulk build from parallel id/name columns.
+    void rebuild(const std::vector<int>& ids, const std::vector<std::string_view>& names);
+
+    // Sorted candidate ids for a substring query. Returns false when the
+    // pattern is shorter than a trigram and the caller has to scan.
+    bool candidates(const std::string& pattern, std::vector<int>& out) const;
+};
+
+#endif // TRIGRAMINDEX_H
@@ -7,11 +7,27 @@
 #include <fstream>
 #include <set>
 #include <unordered_map> 
+#include <type_traits>
 #include "Pipe.h"
 #include "CompressorStation.h"
+#include "AsyncLog.h"
+
+// Input echo: goes to the async log when one is running, else to cerr.
+inline void log_input(const std::string& str) {
+    if (AsyncLog* log = AsyncLog::active()) log->text(str);
+    else std::cerr << str << '\n';
+}
+
+template <typename T>
+void log_input(T x) {
+    AsyncLog* log = AsyncLog::active();
+    if (!log) std::cerr << x << '\n';
+    else if (std::is_integral<T>::value) log->integer(static_cast<long long>(x));
+    else log->real(static_cast<double>(x));
+}
 
 #define INPUT_LINE(in, str) std::getline(in>>std::ws, str); \
-						std::cerr << str << std::endl
+						log_input(str)
 
 class redirect_output_wrapper
 {
@@ -44,22 +60,30 @@ T GetCorrectNumber(T min, T max)
         std::cin.ignore(10000, '\n');
         std::cout << "Type number (" << min << "-" << max << "):";
     }
-    std::cerr << x << std::endl;
+    log_input(x);
     return x;
 }
 
-template <typename Obj, typename Func, typename Param>
-std::set<int> find_by_filter(const std::unordered_map<int, Obj>& objs, Func func, Param param) {
+// Single-predicate filter; output is separate (print_by_ids). For combined
+// conditions use the query:: combinators or QueryExpr.
+template <typename Table, typename Func, typename Param>
+std::set<int> find_by_filter(const Table& objs, Func func, Param param) {
     std::set<int> result;
     for (const auto& obj : objs) {
-        if (func(obj.second, param)) {
-            std::cout << "ID: " << obj.first << std::endl;
-            std::cout << obj.second;
-            result.insert(obj.first);
-        }
+        if (func(obj.second, param)) result.insert(obj.first);
     }
     return result;
 }
+
+template <typename Table, typename Ids>
+void print_by_ids(std::ostream& os, const Table& objs, const Ids& ids) {
+    for (int id : ids) {
+        auto obj = objs.get(id);
+        if (!obj) continue;
+        os << "ID: " << id << "\n";
+        os << *obj << "\n";
+    }
+}
 inline bool filter_pipe_by_name(const Pipe& pipe, const std::string& name_substr) {
     return pipe.getName().find(name_substr) != std::string::npos;
 }
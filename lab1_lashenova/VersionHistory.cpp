@@ -0,0 +1,90 @@
+#include "VersionHistory.h"
+#include <algorithm>
+
+StoreVersion::StoreVersion(uint64_t number_, const std::string& label_,
+    const PersistentMap<PipeState>& pipes_, const PersistentMap<StationState>& stations_)
+    : number(number_), label(label_), pipes(pipes_), stations(stations_) {}
+
+std::optional<Pipe> StoreVersion::getPipeById(int id) const {
+    const PipeState* p = pipes.find(id);
+    if (!p) return std::nullopt;
+    return Pipe(id, p->name, p->diameter, p->in_repair, p->in_station, p->out_station);
+}
+
+std::optional<CompressorStation> StoreVersion::getStationById(int id) const {
+    const StationState* s = stations.find(id);
+    if (!s) return std::nullopt;
+    return CompressorStation(id, s->name, s->total, s->working, s->classification);
+}
+
+size_t VersionDiff::size() const {
+    return pipes_added.size() + pipes_removed.size() + pipes_changed.size()
+        + stations_added.size() + stations_removed.size() + stations_changed.size();
+}
+
+VersionHistory::VersionHistory() : current(0), limit(0), next_number(1) {}
+
+void VersionHistory::setLimit(size_t versions_) {
+    limit = versions_;
+    if (limit == 0) {
+        versions.clear();
+        current = 0;
+        pipes.clear();
+        stations.clear();
+    }
+    else if (versions.size() > limit) {
+        size_t drop = std::min(versions.size() - limit, current);
+        versions.erase(versions.begin(), versions.begin() + drop);
+        current -= drop;
+        if (versions.size() > limit) versions.resize(limit);
+    }
+}
+
+void VersionHistory::reset(const std::string& label) {
+    versions.clear();
+    current = 0;
+    versions.push_back(std::make_shared<const StoreVersion>(next_number++, label, pipes, stations));
+}
+
+void VersionHistory::commit(const std::string& label) {
+    if (!versions.empty()) versions.resize(current + 1);
+    versions.push_back(std::make_shared<const StoreVersion>(next_number++, label, pipes, stations));
+    if (versions.size() > limit) versions.erase(versions.begin(), versions.begin() + (versions.size() - limit));
+    current = versions.size() - 1;
+}
+
+std::shared_ptr<const StoreVersion> VersionHistory::undoTarget() const {
+    return canUndo() ? versions[current - 1] : nullptr;
+}
+
+std::shared_ptr<const StoreVersion> VersionHistory::redoTarget() const {
+    return canRedo() ? versions[current + 1] : nullptr;
+}
+
+void VersionHistory::moveTo(bool forward) {
+    if (forward ? !canRedo() : !canUndo()) return;
+    current = forward ? current + 1 : current - 1;
+    pipes = versions[current]->pipes;
+    stations = versions[current]->stations;
+}
+
+std::shared_ptr<const StoreVersion> VersionHistory::currentVersion() const {
+    return versions.empty() ? nullptr : versions[current];
+}
+
+std::shared_ptr<const StoreVersion> VersionHistory::find(uint64_t number) const {
+    // Numbers ascend along the list.
+    auto it = std::lower_bound(versions.begin(), versions.end(), number,
+        [](const std::shared_ptr<const StoreVersion>& v, uint64_t n) { return v->number < n; });
+    return it != versions.end() && (*it)->number == number ? *it : nullptr;
+}
+
+void VersionHistory::diff(const StoreVersion& a, const StoreVersion& b, VersionDiff& out) {
+    out = VersionDiff();
+    PersistentMap<PipeState>::diff(a.pipes, b.pipes, [&](int id, const PipeState* before, const PipeState* after) {
+        (!before ? out.pipes_added : !after ? out.pipes_removed : out.pipes_changed).push_back(id);
+    });
+    PersistentMap<StationState>::diff(a.stations, b.stations, [&](int id, const StationState* before, const StationState* after) {
+        (!before ? out.stations_added : !after ? out.stations_removed : out.stations_changed).push_back(id);
+    });
+}
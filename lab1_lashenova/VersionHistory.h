@@ -0,0 +1,124 @@
+#ifndef VERSIONHISTORY_H
+#define VERSIONHISTORY_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include "PersistentMap.h"
+#include "ClassRegistry.h"
+#include "Pipe.h"
+#include "CompressorStation.h"
+
+struct PipeState {
+    std::string name;
+    double diameter = 0;
+    bool in_repair = false;
+    int in_station = 0;
+    int out_station = 0;
+
+    bool operator==(const PipeState&) const = default;
+};
+
+struct StationState {
+    std::string name;
+    int total = 0;
+    int working = 0;
+    ClassId classification = ClassRegistry::NONE;
+
+    bool operator==(const StationState&) const = default;
+};
+
+// One committed state of the pipe and station stores. Immutable and shared
+// with its neighbours, so it can be held and queried from any thread for
+// as long as needed.
+class StoreVersion {
+private:
+    uint64_t number;
+    std::string label;
+    PersistentMap<PipeState> pipes;
+    PersistentMap<StationState> stations;
+
+    friend class VersionHistory;
+
+public:
+    StoreVersion(uint64_t number_, const std::string& label_,
+        const PersistentMap<PipeState>& pipes_, const PersistentMap<StationState>& stations_);
+
+    uint64_t getNumber() const { return number; }
+    const std::string& getLabel() const { return label; }
+    size_t pipeCount() const { return pipes.size(); }
+    size_t stationCount() const { return stations.size(); }
+
+    // nullptr if the record does not exist in this version.
+    const PipeState* findPipe(int id) const { return pipes.find(id); }
+    const StationState* findStation(int id) const { return stations.find(id); }
+    std::optional<Pipe> getPipeById(int id) const;
+    std::optional<CompressorStation> getStationById(int id) const;
+
+    // f(id, state) in ascending id order.
+    template <typename F>
+    void forEachPipe(F f) const { pipes.forEach(f); }
+    template <typename F>
+    void forEachStation(F f) const { stations.forEach(f); }
+
+    const PersistentMap<PipeState>& pipeMap() const { return pipes; }
+    const PersistentMap<StationState>& stationMap() const { return stations; }
+};
+
+// Ids that differ between two versions, each list ascending.
+struct VersionDiff {
+    std::vector<int> pipes_added;
+    std::vector<int> pipes_removed;
+    std::vector<int> pipes_changed;
+    std::vector<int> stations_added;
+    std::vector<int> stations_removed;
+    std::vector<int> stations_changed;
+
+    size_t size() const;
+};
+
+// Linear undo history over persistent copies of the stores. The live maps
+// follow every change of Manager's tables; commit() freezes them into a
+// version in O(1), and the next writes copy only the paths they touch.
+// Committing after an undo drops the redo tail; beyond the limit the
+// oldest versions are released.
+class VersionHistory {
+private:
+    std::vector<std::shared_ptr<const StoreVersion>> versions;
+    size_t current;
+    size_t limit;
+    uint64_t next_number;
+
+public:
+    PersistentMap<PipeState> pipes;
+    PersistentMap<StationState> stations;
+
+    VersionHistory();
+
+    bool isEnabled() const { return limit > 0; }
+    size_t getLimit() const { return limit; }
+    // 0 disables the history and drops all versions.
+    void setLimit(size_t versions_);
+    // Forgets all versions; the live maps become the only one.
+    void reset(const std::string& label);
+    void commit(const std::string& label);
+
+    bool canUndo() const { return current > 0; }
+    bool canRedo() const { return current + 1 < versions.size(); }
+    // Versions the tables move to on undo/redo; nullptr if none.
+    std::shared_ptr<const StoreVersion> undoTarget() const;
+    std::shared_ptr<const StoreVersion> redoTarget() const;
+    // Marks the neighbour as current and makes its maps the live ones.
+    void moveTo(bool forward);
+
+    std::shared_ptr<const StoreVersion> currentVersion() const;
+    std::shared_ptr<const StoreVersion> find(uint64_t number) const;
+    const std::vector<std::shared_ptr<const StoreVersion>>& all() const { return versions; }
+
+    static void diff(const StoreVersion& a, const StoreVersion& b, VersionDiff& out);
+};
+
+#endif // VERSIONHISTORY_H
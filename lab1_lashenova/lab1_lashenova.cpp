@@ -4,11 +4,25 @@
 #include <vector>
 #include <set>
 #include <ctime>
+#include <memory>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <csignal>
 #include "Manager.h"
 #include "Utils.h"
+#include "ScriptRunner.h"
+#include "AsyncLog.h"
+#include "SocketServer.h"
 
 using namespace std;
 
+// The daemon being served, for the SIGINT/SIGTERM handler.
+SocketServer* active_server = nullptr;
+
+void stopServer(int) {
+    if (active_server) active_server->stop();
+}
 
 void printMenu() {
     cout << "\nMain Menu:\n";
@@ -24,11 +38,19 @@ void printMenu() {
     cout << "10) List All Compressor Stations\n";
     cout << "11) Save to File\n";
     cout << "12) Load from File\n";
+    cout << "13) Connect Pipe to Stations\n";
+    cout << "14) Network Queries\n";
+    cout << "15) Statistics\n";
+    cout << "16) History (undo/redo)\n";
+    cout << "17) Autosave\n";
+    cout << "18) Open File Lazily\n";
+    cout << "19) List Pipes by Page\n";
+    cout << "20) List Compressor Stations by Page\n";
     cout << "0) Exit\n";
     cout << "Choose an option: ";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     redirect_output_wrapper cerr_out(cerr);
 
     string filename = "log_" + to_string(time(nullptr));
@@ -37,14 +59,108 @@ int main() {
     if (logfile)
         cerr_out.redirect(logfile);
 
+    int flush_ms = 100;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--log-flush-ms") flush_ms = max(1, atoi(argv[++i]));
+    }
+    // Declared after logfile, so it is flushed and stopped before the file closes.
+    unique_ptr<AsyncLog> input_log;
+    if (logfile) input_log.reset(new AsyncLog(logfile, chrono::milliseconds(flush_ms)));
+
     Manager manager;
+
+    string script;
+    string autosave;
+    int autosave_ms = 30000;
+    int autosave_records = 10000;
+    string lazy;
+    int lazy_cache_mb = 64;
+    // Undo history copies every record, so it is off unless asked for.
+    int history_versions = 0;
+    string serve;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--log-flush-ms") {
+            ++i;
+        }
+        else if (string(argv[i]) == "--store") {
+            string base = argv[++i];
+            if (manager.openStore(base)) cout << "Opened store " << base << "\n";
+            else cout << "Error opening store " << base << "\n";
+        }
+        else if (string(argv[i]) == "--script") {
+            script = argv[++i];
+        }
+        else if (string(argv[i]) == "--autosave") {
+            autosave = argv[++i];
+        }
+        else if (string(argv[i]) == "--autosave-ms") {
+            autosave_ms = max(0, atoi(argv[++i]));
+        }
+        else if (string(argv[i]) == "--autosave-records") {
+            autosave_records = max(0, atoi(argv[++i]));
+        }
+        else if (string(argv[i]) == "--lazy") {
+            lazy = argv[++i];
+        }
+        else if (string(argv[i]) == "--lazy-cache-mb") {
+            lazy_cache_mb = max(0, atoi(argv[++i]));
+        }
+        else if (string(argv[i]) == "--history") {
+            history_versions = max(0, atoi(argv[++i]));
+        }
+        else if (string(argv[i]) == "--serve") {
+            serve = argv[++i];
+        }
+    }
+    if (history_versions > 0 && !manager.setHistoryLimit(static_cast<size_t>(history_versions)))
+        cout << "Error: cannot turn on history\n";
+    if (!lazy.empty()) {
+        if (manager.openLazy(lazy, static_cast<size_t>(lazy_cache_mb) << 20)) cout << "Opened " << lazy << " lazily\n";
+        else cout << "Error opening " << lazy << "\n";
+    }
+    if (!autosave.empty() && !manager.startAutosave(autosave, chrono::milliseconds(autosave_ms), autosave_records))
+        cout << "Error: cannot start autosave\n";
+
+    if (!script.empty()) {
+        ScriptRunner runner(manager);
+        ifstream file;
+        if (script != "-") file.open(script);
+        istream& in = script == "-" ? cin : file;
+        if (!in) {
+            cout << "Cannot open script " << script << "\n";
+            return 1;
+        }
+        if (!runner.parse(in)) {
+            for (const string& e : runner.getErrors()) cout << e << "\n";
+            return 1;
+        }
+        return runner.run(cout) == 0 ? 0 : 2;
+    }
+
+    if (!serve.empty()) {
+        SocketServer server(manager, serve);
+        active_server = &server;
+        signal(SIGINT, stopServer);
+        signal(SIGTERM, stopServer);
+        cout << "Serving on " << serve << endl;
+        bool ok = server.run();
+        active_server = nullptr;
+        manager.flushJournal();
+        if (!ok) {
+            cout << "Cannot serve on " << serve << "\n";
+            return 1;
+        }
+        cout << "Served " << server.requestCount() << " requests over " << server.connectionCount() << " connections\n";
+        return 0;
+    }
+
     cout << "=== Pipe and Compressor Station Manager ===\n";
 
 
     bool running = true;
     while (running) {
         printMenu();
-        switch (GetCorrectNumber(0, 12)) {
+        switch (GetCorrectNumber(0, 20)) {
         case 1: manager.addPipe(); break;
         case 2: manager.editPipe(); break;
         case 3: manager.deletePipe(); break;
@@ -57,6 +173,14 @@ int main() {
         case 10: manager.listAllStations(); break;
         case 11: manager.saveToFileUI(); break;
         case 12: manager.loadFromFileUI(); break;
+        case 13: manager.connectPipeUI(); break;
+        case 14: manager.networkUI(); break;
+        case 15: manager.statisticsUI(); break;
+        case 16: manager.historyUI(); break;
+        case 17: manager.autosaveUI(); break;
+        case 18: manager.openLazyUI(); break;
+        case 19: manager.listPipePagesUI(); break;
+        case 20: manager.listStationPagesUI(); break;
 
         case 0: {
             running = false;
@@ -67,6 +191,7 @@ int main() {
             cout << "Invalid option.\n";
             break;
         }
+        manager.flushJournal();
     }
     return 0;
 }
\ No newline at end of file